@@ -0,0 +1,130 @@
+/*
+ * arena.c: region allocator for scratch memory that is all thrown
+ * away at once, such as the working storage of a puzzle solver
+ * called many times over during a single generation attempt.
+ *
+ * Memory is handed out sequentially from a list of large chunks
+ * obtained from smalloc. Nothing is ever freed individually: instead
+ * the whole arena can be reset, or rewound to a previously saved
+ * mark, and the chunks are kept for reuse rather than returned to
+ * the system until the arena itself is freed.
+ */
+
+#include <stddef.h>
+
+#include "puzzles.h"
+
+/*
+ * Every allocation is rounded up to a multiple of the size of this
+ * union, which is at least as strictly aligned as anything we'd
+ * want to store.
+ */
+union arena_align {
+    long l;
+    double d;
+    void *p;
+    void (*fp)(void);
+};
+#define ARENA_ALIGN (sizeof(union arena_align))
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+/* Size of the first chunk; each subsequent one is twice the last. */
+#define ARENA_MIN_CHUNK 4096
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;                       /* usable bytes after the header */
+};
+#define CHUNK_HEADER ARENA_ROUND(sizeof(struct arena_chunk))
+#define CHUNK_DATA(c) ((unsigned char *)(c) + CHUNK_HEADER)
+
+struct arena {
+    struct arena_chunk *head, *tail;
+    struct arena_chunk *cur;           /* chunk we're allocating from */
+    size_t used;                       /* bytes of cur already handed out */
+};
+
+arena *arena_new(void)
+{
+    arena *a = snew(arena);
+    a->head = a->tail = a->cur = NULL;
+    a->used = 0;
+    return a;
+}
+
+void arena_free(arena *a)
+{
+    struct arena_chunk *c, *next;
+
+    if (!a)
+        return;
+    for (c = a->head; c; c = next) {
+        next = c->next;
+        sfree(c);
+    }
+    sfree(a);
+}
+
+void *arena_alloc(arena *a, size_t size)
+{
+    struct arena_chunk *c;
+    void *ret;
+
+    if (size > ((size_t)-1) / 2)
+        fatal("out of memory");
+    size = ARENA_ROUND(size);
+
+    if (!a->cur) {
+        a->cur = a->head;
+        a->used = 0;
+    }
+
+    /*
+     * Move along the chunk list until we find room, skipping any
+     * chunks too small for this request.
+     */
+    while (a->cur && a->used + size > a->cur->size) {
+        a->cur = a->cur->next;
+        a->used = 0;
+    }
+
+    if (!a->cur) {
+        size_t csize = a->tail ? a->tail->size * 2 : ARENA_MIN_CHUNK;
+        if (csize < size)
+            csize = size;
+        c = smalloc(CHUNK_HEADER + csize);
+        c->next = NULL;
+        c->size = csize;
+        if (a->tail)
+            a->tail->next = c;
+        else
+            a->head = c;
+        a->tail = c;
+        a->cur = c;
+        a->used = 0;
+    }
+
+    ret = CHUNK_DATA(a->cur) + a->used;
+    a->used += size;
+    return ret;
+}
+
+void arena_reset(arena *a)
+{
+    a->cur = a->head;
+    a->used = 0;
+}
+
+arena_mark arena_get_mark(arena *a)
+{
+    arena_mark m;
+    m.chunk = a->cur;
+    m.used = a->used;
+    return m;
+}
+
+void arena_release(arena *a, arena_mark m)
+{
+    a->cur = m.chunk;
+    a->used = m.used;
+}
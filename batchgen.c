@@ -0,0 +1,1192 @@
+/*
+ * batchgen.c: non-interactive bulk generation of puzzles, shared
+ * between the Unix front ends - the '--generate', '--print' and
+ * '--save' modes of the GTK puzzle binaries, and the headless
+ * 'puzzlegen' program which provides the same modes without linking
+ * against GTK at all, plus a server mode of its own.
+ */
+
+/* For RUSAGE_THREAD and clock_gettime, where they're available. */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <pthread.h>
+
+#include "puzzles.h"
+#include "grid.h"
+
+struct savefile_write_ctx {
+    FILE *fp;
+    int error;
+};
+
+static void savefile_write(void *wctx, const void *buf, int len)
+{
+    struct savefile_write_ctx *ctx = (struct savefile_write_ctx *)wctx;
+    if (fwrite(buf, 1, len, ctx->fp) < len)
+	ctx->error = errno;
+}
+
+static void list_presets_from_menu(const game *game, struct preset_menu *menu)
+{
+    int i;
+
+    for (i = 0; i < menu->n_entries; i++) {
+        if (menu->entries[i].params) {
+            char *paramstr = game->encode_params(
+                menu->entries[i].params, true);
+            printf("%s %s\n", paramstr, menu->entries[i].title);
+            sfree(paramstr);
+        } else {
+            list_presets_from_menu(game, menu->entries[i].submenu);
+        }
+    }
+}
+
+/*
+ * Specialist mode which causes the puzzle to list the game_params
+ * strings for all its preset configurations.
+ */
+void batchgen_list_presets(const game *game)
+{
+    midend *me;
+    struct preset_menu *menu;
+
+    me = midend_new(NULL, game, NULL, NULL);
+    menu = midend_get_presets(me, NULL);
+    list_presets_from_menu(game, menu);
+    midend_free(me);
+}
+
+void batchgen_default_options(struct batchgen_options *opts)
+{
+    opts->pname = NULL;
+    opts->arg = NULL;
+    opts->ngenerate = 0;
+    opts->njobs = 1;
+    opts->nthreads = 1;
+    opts->print = false;
+    opts->px = opts->py = 1;
+    opts->scale = 1.0F;
+    opts->soln = opts->colour = false;
+    opts->time_generation = opts->test_solve = false;
+    opts->savefile = opts->savesuffix = NULL;
+}
+
+/*
+ * Support for '--jobs', which runs the bulk-generation loop on
+ * several threads at once.
+ *
+ * The main thread's midend is still the one that decides what game
+ * each iteration should generate (parsing the command line or stdin,
+ * and inventing random seeds from its own random state, via
+ * midend_next_game_id), so the sequence of game ids handed out is
+ * exactly the one the serial loop would have generated. Each worker
+ * thread has a midend of its own, in which it generates the games it
+ * is given; the output for each game is buffered, and the main thread
+ * writes the buffers out in the original order. So the output is
+ * byte-for-byte what it would have been without '--jobs'.
+ */
+
+static char *dupfmt(const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+    char *ret;
+
+    va_start(ap, fmt);
+    len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    ret = snewn(len + 1, char);
+    va_start(ap, fmt);
+    vsnprintf(ret, len + 1, fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+/*
+ * Clock function for midend_set_phase_clock(), also used to time
+ * generation as a whole. 'ctx' points to a bool saying whether we're
+ * in a worker thread, in which case CPU time has to mean the thread's
+ * own CPU time rather than the whole process's. (If the OS can't give
+ * us that, the figures will be inflated by whatever the other workers
+ * were doing at the time.) CPU time includes system time as well as
+ * user time, since generators that allocate a lot of memory can spend
+ * a significant amount of time in the kernel.
+ */
+static bool clock_process = false, clock_thread = true;
+
+static void batchgen_clock(void *ctx, double *wall, double *cpu)
+{
+    bool thread = *(bool *)ctx;
+#if defined CLOCK_MONOTONIC && defined CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *wall = ts.tv_sec + ts.tv_nsec / 1000000000.0;
+
+    clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID :
+                  CLOCK_PROCESS_CPUTIME_ID, &ts);
+    *cpu = ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#else
+    struct timeval tv;
+    struct rusage ru;
+
+    gettimeofday(&tv, NULL);
+    *wall = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+#ifdef RUSAGE_THREAD
+    getrusage(thread ? RUSAGE_THREAD : RUSAGE_SELF, &ru);
+#else
+    getrusage(RUSAGE_SELF, &ru);
+#endif
+    *cpu = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+        (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+#endif
+}
+
+/*
+ * A snapshot of the midend's per-phase times. --test-solve re-enters
+ * each game it generates, which goes through some of the same phases
+ * again, so we take one of these once the game has been generated to
+ * be able to report the two steps separately.
+ */
+struct phase_times {
+    int count[MIDEND_NPHASES];
+    double wall[MIDEND_NPHASES], cpu[MIDEND_NPHASES];
+};
+
+static void get_phase_times(midend *me, struct phase_times *pt)
+{
+    int phase;
+
+    for (phase = 0; phase < MIDEND_NPHASES; phase++)
+        pt->count[phase] = midend_get_phase_times(
+            me, phase, &pt->wall[phase], &pt->cpu[phase]);
+}
+
+/*
+ * Format the report printed by --time-generation: the CPU time taken
+ * to generate the puzzle, followed by any other measurements in the
+ * form 'key=value' (which benchmark.pl knows how to parse). Those are
+ * the wall-clock time for the whole generation, and the CPU and wall
+ * time for each phase the midend went through; then, if 'gen' is a
+ * snapshot taken after generating the puzzle, the time for each phase
+ * run since then (by --test-solve) with 'test_' on the front of its
+ * name; and finally any counters the generator reported (see
+ * genstats.c).
+ */
+static char *timing_report(midend *me, const game *game, const char *seed,
+                           double cpu, double wall,
+                           const struct phase_times *gen)
+{
+    char *ret = dupfmt("%s %s: %.6f wall=%.6f", game->name, seed, cpu, wall);
+    const struct genstats *stats = midend_get_genstats(me);
+    struct phase_times now;
+    int phase;
+
+    get_phase_times(me, &now);
+    if (!gen)
+        gen = &now;
+
+    for (phase = 0; phase < MIDEND_NPHASES; phase++) {
+        char *newret;
+
+        if (!gen->count[phase])
+            continue;
+        newret = dupfmt("%s %s=%.6f %s_wall=%.6f", ret,
+                        midend_phase_name(phase), gen->cpu[phase],
+                        midend_phase_name(phase), gen->wall[phase]);
+        sfree(ret);
+        ret = newret;
+    }
+    for (phase = 0; phase < MIDEND_NPHASES; phase++) {
+        char *newret;
+
+        if (now.count[phase] == gen->count[phase])
+            continue;
+        newret = dupfmt("%s test_%s=%.6f test_%s_wall=%.6f", ret,
+                        midend_phase_name(phase),
+                        now.cpu[phase] - gen->cpu[phase],
+                        midend_phase_name(phase),
+                        now.wall[phase] - gen->wall[phase]);
+        sfree(ret);
+        ret = newret;
+    }
+
+    /*
+     * Then the generator's own counters, if it reported any. Once it
+     * has, we print all of them, zeroes included, so that every line
+     * for a given preset has the same set of keys.
+     */
+    if (stats->count[GENSTAT_ATTEMPTS]) {
+        int i;
+
+        for (i = 0; i < GENSTAT_N; i++) {
+            char *newret = dupfmt("%s %s=%lu", ret, genstat_name(i),
+                                  stats->count[i]);
+            sfree(ret);
+            ret = newret;
+        }
+    }
+
+    return ret;
+}
+
+/*
+ * Support for '--threads', which gives each thread that generates
+ * games a pool of helper threads, for generators to farm work out to
+ * via parallel_run() (see parallel.c). The thread that calls
+ * parallel_run() works through the jobs alongside its helpers, so a
+ * pool for n threads has n-1 helpers.
+ */
+struct helper_pool {
+    struct parallel_runner runner;
+    pthread_t *threads;
+    int nhelpers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond, done_cond;
+
+    /* Everything below here is protected by 'lock'. */
+    parallel_job_fn job;
+    void *ctx;
+    int njobs, nextjob, ndone;
+    bool closing;
+};
+
+static void *helper_thread(void *vctx)
+{
+    struct helper_pool *pool = (struct helper_pool *)vctx;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        int i;
+
+        while (!pool->closing && pool->nextjob >= pool->njobs)
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        if (pool->closing)
+            break;
+
+        i = pool->nextjob++;
+        pthread_mutex_unlock(&pool->lock);
+        pool->job(pool->ctx, i);
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->ndone == pool->njobs)
+            pthread_cond_signal(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    grid_cache_clear();
+    return NULL;
+}
+
+static void helper_pool_run(const struct parallel_runner *pr, int njobs,
+                            parallel_job_fn job, void *ctx)
+{
+    struct helper_pool *pool = (struct helper_pool *)pr->ctx;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->ctx = ctx;
+    pool->njobs = njobs;
+    pool->nextjob = pool->ndone = 0;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    while (pool->nextjob < pool->njobs) {
+        int i = pool->nextjob++;
+        pthread_mutex_unlock(&pool->lock);
+        job(ctx, i);
+        pthread_mutex_lock(&pool->lock);
+        pool->ndone++;
+    }
+    while (pool->ndone < pool->njobs)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+
+    pool->njobs = pool->nextjob = pool->ndone = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Returns NULL if nthreads is 1, or if no helper threads could be
+ * created at all (in which case generation just goes ahead on one
+ * thread).
+ */
+static struct helper_pool *helper_pool_new(int nthreads)
+{
+    struct helper_pool *pool;
+
+    if (nthreads <= 1)
+        return NULL;
+
+    pool = snew(struct helper_pool);
+    pool->threads = snewn(nthreads - 1, pthread_t);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->njobs = pool->nextjob = pool->ndone = 0;
+    pool->closing = false;
+
+    for (pool->nhelpers = 0; pool->nhelpers < nthreads - 1;
+         pool->nhelpers++)
+        if (pthread_create(&pool->threads[pool->nhelpers], NULL,
+                           helper_thread, pool))
+            break;                     /* make do with what we've got */
+
+    pool->runner.nthreads = pool->nhelpers + 1;
+    pool->runner.run = helper_pool_run;
+    pool->runner.ctx = pool;
+    return pool;
+}
+
+static void helper_pool_free(struct helper_pool *pool)
+{
+    int i;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->closing = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->nhelpers; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    sfree(pool->threads);
+    sfree(pool);
+}
+
+/* Make a pool's runner current for this thread, if there is a pool. */
+static void helper_pool_use(struct helper_pool *pool)
+{
+    parallel_use(pool && pool->nhelpers > 0 ? &pool->runner : NULL);
+}
+
+struct batchgen_result {
+    char *output;                      /* text destined for stdout */
+    char *error;                       /* text destined for stderr */
+    bool done;
+};
+
+struct batchgen {
+    const game *game;
+    const struct batchgen_options *opts;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /* Everything below here is protected by 'lock'. */
+    midend *me;
+    int nextjob;                       /* number of jobs handed out */
+    bool exhausted;                    /* true once no more are coming */
+    struct batchgen_result *results;
+    int resultsize;
+};
+
+/*
+ * Decide what the next job is. Called with bg->lock held. Returns
+ * false if there are no more jobs; otherwise fills in *id and
+ * *params, or *error if the job can't be set up (in which case no
+ * further jobs will be handed out either).
+ */
+static bool batchgen_next_job(struct batchgen *bg, int i, char **id,
+                              game_params **params, char **error)
+{
+    const struct batchgen_options *opts = bg->opts;
+    char *pstr;
+
+    *id = *error = NULL;
+    *params = NULL;
+
+    if (opts->ngenerate == 0) {
+        pstr = fgetline(stdin);
+        if (!pstr)
+            return false;
+        pstr[strcspn(pstr, "\r\n")] = '\0';
+    } else {
+        if (i >= opts->ngenerate)
+            return false;
+        if (opts->arg) {
+            pstr = snewn(strlen(opts->arg) + 40, char);
+
+            strcpy(pstr, opts->arg);
+            if (i > 0 && strchr(opts->arg, '#'))
+                sprintf(pstr + strlen(pstr), "-%d", i);
+        } else
+            pstr = NULL;
+    }
+
+    if (pstr) {
+        const char *err = midend_game_id(bg->me, pstr);
+        if (err) {
+            *error = dupfmt("%s: error parsing '%s': %s\n",
+                            opts->pname, pstr, err);
+            sfree(pstr);
+            return true;
+        }
+        sfree(pstr);
+    }
+
+    *params = midend_get_params(bg->me);
+    *id = midend_next_game_id(bg->me);
+    return true;
+}
+
+/*
+ * Do the actual work for one job, in a worker's own midend. Returns
+ * NULL on success, or an error message.
+ */
+static char *batchgen_run_job(struct batchgen *bg, midend *me, int i,
+                              const char *id, game_params *params,
+                              char **output)
+{
+    const struct batchgen_options *opts = bg->opts;
+    const game *game = bg->game;
+    char *seed;
+    const char *err;
+    double startwall, startcpu, wall, cpu;
+    struct phase_times gen;
+
+    *output = NULL;
+
+    midend_set_params(me, params);
+    midend_reset_phase_times(me);
+    err = midend_game_id(me, id);
+    if (err)
+        return dupfmt("%s: error parsing '%s': %s\n", opts->pname, id, err);
+
+    if (opts->time_generation)
+        batchgen_clock(&clock_thread, &startwall, &startcpu);
+
+    midend_new_game(me);
+
+    if (opts->time_generation)
+        batchgen_clock(&clock_thread, &wall, &cpu);
+    get_phase_times(me, &gen);
+
+    seed = midend_get_random_seed(me);
+
+    if (opts->test_solve && game->can_solve) {
+        char *game_id;
+
+        game_id = midend_get_game_id(me);
+        err = midend_game_id(me, game_id);
+        if (err) {
+            char *ret = dupfmt("%s %s: game id re-entry error: %s\n",
+                               game->name, seed, err);
+            sfree(game_id);
+            sfree(seed);
+            return ret;
+        }
+        midend_new_game(me);
+        sfree(game_id);
+
+        err = midend_solve(me);
+        if (err && strcmp(err, "Solution not known for this puzzle")) {
+            char *ret = dupfmt("%s %s: solve error: %s\n",
+                               game->name, seed, err);
+            sfree(seed);
+            return ret;
+        }
+    }
+
+    if (opts->time_generation) {
+        char *report = timing_report(me, game, seed, cpu - startcpu,
+                                     wall - startwall, &gen);
+        *output = dupfmt("%s\n", report);
+        sfree(report);
+    }
+
+    sfree(seed);
+
+    if (opts->savefile) {
+        struct savefile_write_ctx ctx;
+        char *realname = snewn(40 + strlen(opts->savefile) +
+                               strlen(opts->savesuffix), char);
+        char *ret;
+        sprintf(realname, "%s%d%s", opts->savefile, i, opts->savesuffix);
+
+        if (opts->soln) {
+            err = midend_solve(me);
+            if (err) {
+                ret = dupfmt("%s: unable to show solution: %s\n",
+                             realname, err);
+                sfree(realname);
+                return ret;
+            }
+        }
+
+        ctx.fp = fopen(realname, "w");
+        if (!ctx.fp) {
+            ret = dupfmt("%s: open: %s\n", realname, strerror(errno));
+            sfree(realname);
+            return ret;
+        }
+        ctx.error = 0;
+        midend_serialise(me, savefile_write, &ctx);
+        if (ctx.error) {
+            ret = dupfmt("%s: write: %s\n", realname, strerror(ctx.error));
+            fclose(ctx.fp);
+            sfree(realname);
+            return ret;
+        }
+        if (fclose(ctx.fp)) {
+            ret = dupfmt("%s: close: %s\n", realname, strerror(errno));
+            sfree(realname);
+            return ret;
+        }
+        sfree(realname);
+    }
+
+    if (!opts->savefile && !opts->time_generation) {
+        char *gameid = midend_get_game_id(me);
+        *output = dupfmt("%s\n", gameid);
+        sfree(gameid);
+    }
+
+    return NULL;
+}
+
+static void *batchgen_worker(void *vctx)
+{
+    struct batchgen *bg = (struct batchgen *)vctx;
+    midend *me = midend_new(NULL, bg->game, NULL, NULL);
+    struct helper_pool *pool = helper_pool_new(bg->opts->nthreads);
+
+    if (bg->opts->time_generation)
+        midend_set_phase_clock(me, batchgen_clock, &clock_thread);
+    helper_pool_use(pool);
+
+    pthread_mutex_lock(&bg->lock);
+    while (!bg->exhausted) {
+        int i = bg->nextjob;
+        char *id, *output, *error;
+        game_params *params;
+
+        if (!batchgen_next_job(bg, i, &id, &params, &error)) {
+            bg->exhausted = true;
+            break;
+        }
+
+        bg->nextjob++;
+        if (i >= bg->resultsize) {
+            int j, oldsize = bg->resultsize;
+            bg->resultsize = i * 5 / 4 + 256;
+            bg->results = sresize(bg->results, bg->resultsize,
+                                  struct batchgen_result);
+            for (j = oldsize; j < bg->resultsize; j++)
+                bg->results[j].done = false;
+        }
+
+        output = NULL;
+        if (!error) {
+            pthread_mutex_unlock(&bg->lock);
+            error = batchgen_run_job(bg, me, i, id, params, &output);
+            bg->game->free_params(params);
+            sfree(id);
+            pthread_mutex_lock(&bg->lock);
+        }
+
+        bg->results[i].output = output;
+        bg->results[i].error = error;
+        bg->results[i].done = true;
+        if (error)
+            bg->exhausted = true;      /* don't start anything further */
+        pthread_cond_broadcast(&bg->cond);
+    }
+    pthread_cond_broadcast(&bg->cond);
+    pthread_mutex_unlock(&bg->lock);
+
+    midend_free(me);
+    helper_pool_use(NULL);
+    helper_pool_free(pool);
+    grid_cache_clear();                /* this thread's cached grids */
+    return NULL;
+}
+
+static int batchgen_run_parallel(struct batchgen *bg, int njobs)
+{
+    pthread_t *threads = snewn(njobs, pthread_t);
+    int i, nthreads, ret = 0;
+
+    pthread_mutex_init(&bg->lock, NULL);
+    pthread_cond_init(&bg->cond, NULL);
+    bg->nextjob = 0;
+    bg->exhausted = false;
+    bg->results = NULL;
+    bg->resultsize = 0;
+
+    for (nthreads = 0; nthreads < njobs; nthreads++) {
+        if (pthread_create(&threads[nthreads], NULL, batchgen_worker, bg)) {
+            if (nthreads == 0) {
+                fprintf(stderr, "%s: unable to create threads: %s\n",
+                        bg->opts->pname, strerror(errno));
+                sfree(threads);
+                return 1;
+            }
+            break;                     /* make do with what we've got */
+        }
+    }
+
+    /*
+     * Write out the results in order, as they become available.
+     */
+    pthread_mutex_lock(&bg->lock);
+    for (i = 0 ;; i++) {
+        char *output, *error;
+
+        while (!(i < bg->resultsize && bg->results[i].done) &&
+               !(bg->exhausted && i >= bg->nextjob))
+            pthread_cond_wait(&bg->cond, &bg->lock);
+        if (i >= bg->nextjob && bg->exhausted)
+            break;
+
+        output = bg->results[i].output;
+        error = bg->results[i].error;
+        pthread_mutex_unlock(&bg->lock);
+
+        if (output) {
+            fputs(output, stdout);
+            sfree(output);
+        }
+        if (error) {
+            fflush(stdout);
+            fputs(error, stderr);
+            sfree(error);
+            ret = 1;
+        }
+
+        pthread_mutex_lock(&bg->lock);
+        if (ret)
+            break;
+    }
+    pthread_mutex_unlock(&bg->lock);
+
+    if (ret)
+        exit(ret);                     /* don't wait for other workers */
+
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    sfree(threads);
+    sfree(bg->results);
+    pthread_mutex_destroy(&bg->lock);
+    pthread_cond_destroy(&bg->cond);
+    return ret;
+}
+
+/*
+ * Main entry point for the bulk generation mode. Returns an exit
+ * status for the program.
+ *
+ * In this mode, we generate puzzle IDs on the command line. Useful
+ * for generating puzzles to be printed out and solved offline (for
+ * puzzles where that even makes sense - Solo, for example, is a lot
+ * more pencil-and-paper friendly than Twiddle!)
+ *
+ * Usage:
+ *
+ *   <puzzle-name> --generate [<n> [<params>]]
+ *
+ * <n>, if present, is the number of puzzle IDs to generate.
+ * <params>, if present, is the same type of parameter string you
+ * would pass to the puzzle when running it in GUI mode, including
+ * optional extras such as the expansion factor in Rectangles and the
+ * difficulty level in Solo.
+ *
+ * If you specify <params>, you must also specify <n> (although you
+ * may specify it to be 1). Sorry; that was the simplest-to-parse
+ * command-line syntax I came up with.
+ */
+int batchgen_run(const game *game, const struct batchgen_options *inopts)
+{
+    struct batchgen_options optbuf = *inopts, *opts = &optbuf;
+    int i, n = 1;
+    midend *me;
+    char *id;
+    document *doc = NULL;
+    struct helper_pool *pool;
+
+    n = opts->ngenerate;
+
+    me = midend_new(NULL, game, NULL, NULL);
+    if (opts->time_generation)
+        midend_set_phase_clock(me, batchgen_clock, &clock_process);
+    i = 0;
+
+    if (opts->savefile && !opts->savesuffix)
+        opts->savesuffix = "";
+    if (!opts->savefile && opts->savesuffix)
+        opts->savefile = "";
+
+    if (opts->njobs > 1) {
+        struct batchgen bg;
+        int ret;
+
+        /*
+         * Printing collects every puzzle into a single document in
+         * order, so there's nothing to be gained by farming the
+         * generation out to other threads.
+         */
+        if (opts->print) {
+            fprintf(stderr, "%s: '--jobs' cannot be combined with "
+                    "'--print'\n", opts->pname);
+            midend_free(me);
+            return 1;
+        }
+
+        bg.game = game;
+        bg.opts = opts;
+        bg.me = me;
+
+        ret = batchgen_run_parallel(&bg, opts->njobs);
+
+        midend_free(me);
+        return ret;
+    }
+
+    if (opts->print)
+        doc = document_new(opts->px, opts->py, opts->scale);
+
+    pool = helper_pool_new(opts->nthreads);
+    helper_pool_use(pool);
+
+    /*
+     * In this loop, we either generate a game ID or read one from
+     * stdin depending on whether we're in generate mode; then we
+     * either write it to stdout or print it, depending on whether
+     * we're in print mode. Thus, this loop handles generate-to-stdout,
+     * print-from-stdin and generate-and-immediately-print modes.
+     *
+     * (It could also handle a copy-stdin-to-stdout mode, although
+     * there's currently no combination of options which will cause
+     * this loop to be activated in that mode. It wouldn't be
+     * _entirely_ pointless, though, because stdin could contain bare
+     * params strings or random-seed IDs, and stdout would contain
+     * nothing but fully generated descriptive game IDs.)
+     */
+    while (opts->ngenerate == 0 || i < n) {
+        char *pstr, *seed;
+        const char *err;
+        double startwall, startcpu, wall, cpu;
+        struct phase_times gen;
+
+        if (opts->ngenerate == 0) {
+            pstr = fgetline(stdin);
+            if (!pstr)
+                break;
+            pstr[strcspn(pstr, "\r\n")] = '\0';
+        } else {
+            if (opts->arg) {
+                pstr = snewn(strlen(opts->arg) + 40, char);
+
+                strcpy(pstr, opts->arg);
+                if (i > 0 && strchr(opts->arg, '#'))
+                    sprintf(pstr + strlen(pstr), "-%d", i);
+            } else
+                pstr = NULL;
+        }
+
+        midend_reset_phase_times(me);
+        if (pstr) {
+            err = midend_game_id(me, pstr);
+            if (err) {
+                fprintf(stderr, "%s: error parsing '%s': %s\n",
+                        opts->pname, pstr, err);
+                return 1;
+            }
+        }
+
+        if (opts->time_generation)
+            batchgen_clock(&clock_process, &startwall, &startcpu);
+
+        midend_new_game(me);
+
+        if (opts->time_generation)
+            batchgen_clock(&clock_process, &wall, &cpu);
+        get_phase_times(me, &gen);
+
+        seed = midend_get_random_seed(me);
+
+        if (opts->test_solve && game->can_solve) {
+            /*
+             * Now destroy the aux_info in the midend, by means of
+             * re-entering the same game id, and then try to solve it.
+             */
+            char *game_id;
+
+            game_id = midend_get_game_id(me);
+            err = midend_game_id(me, game_id);
+            if (err) {
+                fprintf(stderr, "%s %s: game id re-entry error: %s\n",
+                        game->name, seed, err);
+                return 1;
+            }
+            midend_new_game(me);
+            sfree(game_id);
+
+            err = midend_solve(me);
+            /*
+             * If the solve operation returned the error "Solution not
+             * known for this puzzle", that's OK, because that just
+             * means it's a puzzle for which we don't have an
+             * algorithmic solver and hence can't solve it without the
+             * aux_info, e.g. Netslide. Any other error is a problem,
+             * though.
+             */
+            if (err && strcmp(err, "Solution not known for this puzzle")) {
+                fprintf(stderr, "%s %s: solve error: %s\n",
+                        game->name, seed, err);
+                return 1;
+            }
+        }
+
+        if (opts->time_generation) {
+            char *report = timing_report(me, game, seed, cpu - startcpu,
+                                         wall - startwall, &gen);
+            puts(report);
+            sfree(report);
+        }
+
+        sfree(pstr);
+        sfree(seed);
+
+        if (doc) {
+            err = midend_print_puzzle(me, doc, opts->soln);
+            if (err) {
+                fprintf(stderr, "%s: error in printing: %s\n",
+                        opts->pname, err);
+                return 1;
+            }
+        }
+        if (opts->savefile) {
+            struct savefile_write_ctx ctx;
+            char *realname = snewn(40 + strlen(opts->savefile) +
+                                   strlen(opts->savesuffix), char);
+            sprintf(realname, "%s%d%s",
+                    opts->savefile, i, opts->savesuffix);
+
+            if (opts->soln) {
+                const char *err = midend_solve(me);
+                if (err) {
+                    fprintf(stderr, "%s: unable to show solution: %s\n",
+                            realname, err);
+                    return 1;
+                }
+            }
+
+            ctx.fp = fopen(realname, "w");
+            if (!ctx.fp) {
+                fprintf(stderr, "%s: open: %s\n", realname,
+                        strerror(errno));
+                return 1;
+            }
+            ctx.error = 0;
+            midend_serialise(me, savefile_write, &ctx);
+            if (ctx.error) {
+                fprintf(stderr, "%s: write: %s\n", realname,
+                        strerror(ctx.error));
+                return 1;
+            }
+            if (fclose(ctx.fp)) {
+                fprintf(stderr, "%s: close: %s\n", realname,
+                        strerror(errno));
+                return 1;
+            }
+            sfree(realname);
+        }
+        if (!doc && !opts->savefile && !opts->time_generation) {
+            id = midend_get_game_id(me);
+            puts(id);
+            sfree(id);
+        }
+
+        i++;
+    }
+
+    if (doc) {
+        psdata *ps = ps_init(stdout, opts->colour);
+        document_print(doc, ps_drawing_api(ps));
+        document_free(doc);
+        ps_free(ps);
+    }
+
+    helper_pool_use(NULL);
+    helper_pool_free(pool);
+    midend_free(me);
+
+    return 0;
+}
+
+/*
+ * Server mode, for 'puzzlegen --server'. Rather than generating one
+ * batch and exiting, we read requests from standard input, one per
+ * line, and stream the results back on standard output, flushing
+ * after every puzzle. A client wanting small puzzles one or two at a
+ * time can keep a single server process around, instead of paying
+ * for process startup and midend setup on every request; we also
+ * keep one midend per puzzle for the life of the process.
+ *
+ * Each request is a line of space-separated words:
+ *
+ *   <puzzle> [<params> | <game-id>] [count=<n>] [seed=<seed>]
+ *            [preset=<n>] [solution] [time]
+ *
+ * <puzzle> is looked up by the caller's find_game function.
+ * 'preset=<n>' selects the <n>th preset, counting from 1 in the
+ * order '--list-presets' prints them, as an alternative to giving
+ * params; with neither, the puzzle's default params are used.
+ * 'seed=<seed>' is shorthand for appending '#<seed>' to the params,
+ * and as in '--generate', the second and subsequent puzzles from a
+ * random-seed id get '-1', '-2' etc appended to the seed.
+ *
+ * For each puzzle generated, the response contains a line 'id
+ * <game-id>'; then, if 'solution' was requested, 'solution <move>'
+ * (see midend_get_solution) or 'nosolution <reason>'; then, if
+ * 'time' was requested, 'time ' followed by the same report as
+ * '--time-generation' prints. The response to each request is
+ * terminated by either 'done' or 'error <message>'. Blank lines are
+ * ignored, and the server exits at end of file.
+ */
+
+struct server_midend {
+    const game *game;
+    midend *me;
+};
+
+struct server {
+    const game *(*find_game)(const char *name);
+    struct server_midend *mes;
+    int nmes, mesize;
+};
+
+static midend *server_get_midend(struct server *sv, const game *game)
+{
+    midend *me;
+    int i;
+
+    for (i = 0; i < sv->nmes; i++)
+        if (sv->mes[i].game == game)
+            return sv->mes[i].me;
+
+    if (sv->nmes >= sv->mesize) {
+        sv->mesize = sv->nmes * 5 / 4 + 16;
+        sv->mes = sresize(sv->mes, sv->mesize, struct server_midend);
+    }
+    me = midend_new(NULL, game, NULL, NULL);
+    midend_set_phase_clock(me, batchgen_clock, &clock_process);
+    sv->mes[sv->nmes].game = game;
+    sv->mes[sv->nmes].me = me;
+    sv->nmes++;
+    return me;
+}
+
+/*
+ * Find the *n'th preset in a (possibly nested) preset menu, counting
+ * from 1, and return its encoded params.
+ */
+static char *server_find_preset(const game *game, struct preset_menu *menu,
+                                int *n)
+{
+    int i;
+
+    for (i = 0; i < menu->n_entries; i++) {
+        if (menu->entries[i].params) {
+            if (--*n == 0)
+                return game->encode_params(menu->entries[i].params, true);
+        } else {
+            char *ret = server_find_preset(
+                game, menu->entries[i].submenu, n);
+            if (ret)
+                return ret;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Handle one request, writing the results to stdout. Returns NULL on
+ * success, or a dynamically allocated error message.
+ */
+static char *server_request(struct server *sv, char *line)
+{
+    const game *game;
+    midend *me;
+    const char *arg = NULL, *seed = NULL;
+    char *word, *base, *full;
+    int count = 1, preset = 0;
+    bool soln = false, timing = false;
+    int i;
+
+    line += strspn(line, " \t");
+    word = line;
+    line += strcspn(line, " \t");
+    if (*line)
+        *line++ = '\0';
+
+    game = sv->find_game(word);
+    if (!game)
+        return dupfmt("unrecognised puzzle '%s'", word);
+
+    while (*(line += strspn(line, " \t"))) {
+        word = line;
+        line += strcspn(line, " \t");
+        if (*line)
+            *line++ = '\0';
+
+        if (!strncmp(word, "count=", 6)) {
+            count = atoi(word + 6);
+            if (count < 1)
+                return dupfmt("'count' expected a positive number");
+        } else if (!strncmp(word, "seed=", 5)) {
+            seed = word + 5;
+        } else if (!strncmp(word, "preset=", 7)) {
+            preset = atoi(word + 7);
+            if (preset < 1)
+                return dupfmt("'preset' expected a positive number");
+        } else if (!strcmp(word, "solution")) {
+            soln = true;
+        } else if (!strcmp(word, "time")) {
+            timing = true;
+        } else if (arg) {
+            return dupfmt("more than one params string supplied");
+        } else {
+            arg = word;
+        }
+    }
+
+    me = server_get_midend(sv, game);
+
+    if (preset) {
+        int n = preset;
+
+        if (arg)
+            return dupfmt("both a preset and params supplied");
+        base = server_find_preset(game, midend_get_presets(me, NULL), &n);
+        if (!base)
+            return dupfmt("%s has no preset %d", game->name, preset);
+    } else if (arg) {
+        base = dupstr(arg);
+    } else {
+        game_params *params = game->default_params();
+        base = game->encode_params(params, true);
+        game->free_params(params);
+    }
+
+    if (seed) {
+        if (strchr(base, '#') || strchr(base, ':')) {
+            sfree(base);
+            return dupfmt("seed supplied along with a game id");
+        }
+        full = dupfmt("%s#%s", base, seed);
+        sfree(base);
+    } else {
+        full = base;
+    }
+
+    for (i = 0; i < count; i++) {
+        char *id, *gameid;
+        const char *err;
+        double startwall, startcpu, wall, cpu;
+
+        if (i > 0 && strchr(full, '#'))
+            id = dupfmt("%s-%d", full, i);
+        else
+            id = dupstr(full);
+
+        midend_reset_phase_times(me);
+        err = midend_game_id(me, id);
+        if (err) {
+            char *ret = dupfmt("invalid game id '%s': %s", id, err);
+            sfree(id);
+            sfree(full);
+            return ret;
+        }
+
+        batchgen_clock(&clock_process, &startwall, &startcpu);
+        midend_new_game(me);
+        batchgen_clock(&clock_process, &wall, &cpu);
+
+        gameid = midend_get_game_id(me);
+        printf("id %s\n", gameid);
+
+        if (soln) {
+            char *move = midend_get_solution(me, &err);
+            if (move)
+                printf("solution %s\n", move);
+            else
+                printf("nosolution %s\n", err);
+            sfree(move);
+        }
+
+        if (timing) {
+            char *seedstr = midend_get_random_seed(me);
+            char *report = timing_report(me, game, seedstr ? seedstr : id,
+                                         cpu - startcpu, wall - startwall,
+                                         NULL);
+            printf("time %s\n", report);
+            sfree(report);
+            sfree(seedstr);
+        }
+
+        fflush(stdout);
+        sfree(gameid);
+        sfree(id);
+    }
+
+    sfree(full);
+    return NULL;
+}
+
+/*
+ * Main entry point for server mode. 'find_game' looks up a puzzle by
+ * the name given in a request, returning NULL if there's no such
+ * puzzle. Returns an exit status for the program.
+ */
+int batchgen_serve(const game *(*find_game)(const char *name))
+{
+    struct server sv;
+    char *line;
+    int i;
+
+    sv.find_game = find_game;
+    sv.mes = NULL;
+    sv.nmes = sv.mesize = 0;
+
+    while ((line = fgetline(stdin)) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[strspn(line, " \t")]) {
+            char *err = server_request(&sv, line);
+            if (err) {
+                printf("error %s\n", err);
+                sfree(err);
+            } else {
+                printf("done\n");
+            }
+            fflush(stdout);
+        }
+        sfree(line);
+    }
+
+    for (i = 0; i < sv.nmes; i++)
+        midend_free(sv.mes[i].me);
+    sfree(sv.mes);
+
+    return 0;
+}
@@ -1,20 +1,72 @@
 #!/usr/bin/perl
 
-# Process the raw output from benchmark.sh into Javascript-ified HTML.
+# Process the raw output from benchmark.sh into Javascript-ified HTML,
+# or into machine-readable summary statistics.
+#
+# Usage:
+#   benchmark.pl [raw-output...]                  HTML page (the default)
+#   benchmark.pl --json|--csv [raw-output...]     per-preset statistics
+#   benchmark.pl --compare [options] old new      look for regressions
+#
+# Each line of raw output gives the time taken to generate one puzzle,
+# optionally followed by other measurements in the form 'key=value'
+# (such as the time taken to solve it). The statistics modes report
+# the count, min, median, mean, 95th and 99th percentiles and max of
+# every measurement, for each preset.
+#
+# --compare reads two sets of raw output (typically from before and
+# after a change) and applies a Mann-Whitney U test to each
+# measurement of each preset, which makes no assumptions about the
+# shape of the distributions (generation times are very heavy-tailed).
+# A change is reported if it is statistically significant (p below
+# --alpha, default 0.01) and the median has moved by more than
+# --threshold (default 0.05, i.e. 5%). The exit status is 1 if any
+# regressions were found. --json or --csv may also be given to get the
+# comparison in machine-readable form; there the ratio of the medians
+# is null (or empty) if the old median was zero.
 
 use strict;
 use warnings;
+use Getopt::Long;
+use POSIX qw(erfc);
 
-my @presets = ();
-my %presets = ();
-my $maxval = 0;
+my $format = "html";
+my $compare = 0;
+my $alpha = 0.01;
+my $threshold = 0.05;
+
+my @statnames = qw(count min median mean p95 p99 max);
+
+GetOptions("json" => sub { $format = "json" },
+           "csv" => sub { $format = "csv" },
+           "html" => sub { $format = "html" },
+           "compare" => \$compare,
+           "alpha=f" => \$alpha,
+           "threshold=f" => \$threshold)
+    or die "usage: benchmark.pl [--json | --csv | --compare] [files]\n";
+
+if ($compare) {
+    die "benchmark.pl: --compare expects two files\n" unless @ARGV == 2;
+    my $old = &read_data($ARGV[0]);
+    my $new = &read_data($ARGV[1]);
+    exit &compare($old, $new);
+}
+
+my $data = &read_data(@ARGV);
+if ($format eq "json") {
+    &print_json_stats($data);
+    exit 0;
+} elsif ($format eq "csv") {
+    &print_csv_stats($data);
+    exit 0;
+}
 
-while (<<>>) {
-    chomp;
-    if (/^(.*)(#.*): ([\d\.]+)$/) {
-        push @presets, $1 unless defined $presets{$1};
-        push @{$presets{$1}}, $3;
-        $maxval = $3 if $maxval < $3;
+my @presets = @{$data->{presets}};
+my %presets = map { $_ => $data->{values}{$_}{time} } @presets;
+my $maxval = 0;
+for my $preset (@presets) {
+    for my $value (@{$presets{$preset}}) {
+        $maxval = $value if $maxval < $value;
     }
 }
 
@@ -195,3 +247,199 @@ sub escape {
     $text =~ s/>/&gt;/g;
     return $text;
 }
+
+# Read raw benchmark output, returning a hash with 'presets' (a list of
+# the preset names in the order they first appeared), 'metrics' (the
+# same for the measurement names, beginning with 'time' for the
+# generation time) and 'values' (mapping preset and then metric to a
+# list of measurements).
+sub read_data {
+    my @files = @_;
+    my $data = { presets => [], metrics => ["time"], values => {} };
+    my %seenmetric = (time => 1);
+
+    local @ARGV = @files;
+    while (<<>>) {
+        chomp;
+        if (/^(.*)(#.*): ([\d\.]+)((?: \w+=[\d\.]+)*)$/) {
+            my ($preset, $time, $extra) = ($1, $3, $4);
+            push @{$data->{presets}}, $preset
+                unless defined $data->{values}{$preset};
+            push @{$data->{values}{$preset}{time}}, $time;
+            while ($extra =~ / (\w+)=([\d\.]+)/g) {
+                push @{$data->{metrics}}, $1 unless $seenmetric{$1}++;
+                push @{$data->{values}{$preset}{$1}}, $2;
+            }
+        }
+    }
+    return $data;
+}
+
+# Quantile of a sorted list, interpolating linearly between the
+# nearest two elements.
+sub quantile {
+    my ($q, @sorted) = @_;
+    my $pos = $q * $#sorted;
+    my $lo = int($pos);
+    return $sorted[$lo] if $lo >= $#sorted;
+    return $sorted[$lo] + ($pos - $lo) * ($sorted[$lo+1] - $sorted[$lo]);
+}
+
+sub stats {
+    my @sorted = sort { $a <=> $b } @_;
+    my $mean = 0; map { $mean += $_ } @sorted; $mean /= @sorted;
+    return { count => scalar @sorted,
+             min => 0 + $sorted[0],
+             median => &quantile(0.5, @sorted),
+             mean => $mean,
+             p95 => &quantile(0.95, @sorted),
+             p99 => &quantile(0.99, @sorted),
+             max => 0 + $sorted[$#sorted] };
+}
+
+# Split a preset name such as 'Light Up 7x7b20s' into the puzzle name
+# and the parameter string.
+sub split_preset {
+    my ($preset) = @_;
+    return $preset =~ /^(.*) (\S+)$/ ? ($1, $2) : ($preset, "");
+}
+
+sub print_json_stats {
+    my ($data) = @_;
+    my @entries;
+    for my $preset (@{$data->{presets}}) {
+        my ($game, $params) = &split_preset($preset);
+        my $entry = { game => $game, params => $params };
+        for my $metric (@{$data->{metrics}}) {
+            my $values = $data->{values}{$preset}{$metric};
+            $entry->{$metric} = &stats(@$values) if $values;
+        }
+        push @entries, $entry;
+    }
+    &print_json(\@entries);
+}
+
+sub print_csv_stats {
+    my ($data) = @_;
+    print join(",", "game", "params", "metric", @statnames), "\n";
+    for my $preset (@{$data->{presets}}) {
+        my ($game, $params) = &split_preset($preset);
+        for my $metric (@{$data->{metrics}}) {
+            my $values = $data->{values}{$preset}{$metric};
+            next unless $values;
+            my $stats = &stats(@$values);
+            print join(",", &csv($game), &csv($params), $metric,
+                       map { $stats->{$_} } @statnames), "\n";
+        }
+    }
+}
+
+# Two-sided Mann-Whitney U test, using the normal approximation with a
+# correction for ties. Returns the p-value.
+sub mann_whitney {
+    my ($xs, $ys) = @_;
+    my ($n1, $n2) = (scalar @$xs, scalar @$ys);
+    my $n = $n1 + $n2;
+    return 1 if $n1 == 0 || $n2 == 0;
+
+    my @all = sort { $a->[0] <=> $b->[0] }
+        ((map { [$_, 0] } @$xs), (map { [$_, 1] } @$ys));
+    my ($r1, $tiesum) = (0, 0);
+    for (my $i = 0; $i < $n; ) {
+        my $j = $i;
+        $j++ while $j+1 < $n && $all[$j+1][0] == $all[$i][0];
+        my $t = $j - $i + 1;
+        my $rank = ($i + $j) / 2 + 1;
+        for my $k ($i..$j) {
+            $r1 += $rank if $all[$k][1] == 0;
+        }
+        $tiesum += $t*$t*$t - $t;
+        $i = $j + 1;
+    }
+
+    my $u = $r1 - $n1 * ($n1 + 1) / 2;
+    my $var = $n1 * $n2 / 12 * (($n + 1) - $tiesum / ($n * ($n - 1)));
+    return 1 if $var <= 0;
+    my $z = abs($u - $n1 * $n2 / 2) / sqrt($var);
+    return erfc($z / sqrt(2));
+}
+
+sub compare {
+    my ($old, $new) = @_;
+    my @results;
+    my $regressions = 0;
+
+    for my $preset (@{$new->{presets}}) {
+        next unless defined $old->{values}{$preset};
+        my ($game, $params) = &split_preset($preset);
+        for my $metric (@{$new->{metrics}}) {
+            my $ov = $old->{values}{$preset}{$metric};
+            my $nv = $new->{values}{$preset}{$metric};
+            next unless $ov && $nv;
+            my $os = &stats(@$ov);
+            my $ns = &stats(@$nv);
+            my $p = &mann_whitney($ov, $nv);
+            # If the old median was 0, there's no finite ratio to
+            # report (and JSON has no way to write an infinite one),
+            # so leave it undefined; any rise from 0 is then a slowdown.
+            my $ratio = $os->{median} > 0 ? $ns->{median} / $os->{median} :
+                $ns->{median} > 0 ? undef : 1;
+            my $slower = defined $ratio ? $ratio > 1 + $threshold : 1;
+            my $verdict = "same";
+            if ($p < $alpha && $slower) {
+                $verdict = "regression";
+                $regressions++;
+            } elsif ($p < $alpha && defined $ratio &&
+                     $ratio < 1 / (1 + $threshold)) {
+                $verdict = "improvement";
+            }
+            push @results, { game => $game, params => $params,
+                             metric => $metric, verdict => $verdict,
+                             p => $p, ratio => $ratio,
+                             old => $os, new => $ns };
+        }
+    }
+
+    if ($format eq "json") {
+        &print_json(\@results);
+    } elsif ($format eq "csv") {
+        print join(",", qw(game params metric verdict p ratio),
+                   (map { "old_$_" } @statnames),
+                   (map { "new_$_" } @statnames)), "\n";
+        for my $r (@results) {
+            print join(",", &csv($r->{game}), &csv($r->{params}),
+                       $r->{metric}, $r->{verdict}, $r->{p},
+                       $r->{ratio} // "",
+                       (map { $r->{old}{$_} } @statnames),
+                       (map { $r->{new}{$_} } @statnames)), "\n";
+        }
+    } else {
+        for my $r (@results) {
+            next if $r->{verdict} eq "same";
+            printf "%-11s %s %s %s: median %.6f -> %.6f (%s), " .
+                "p99 %.6f -> %.6f, p=%.2g\n",
+                uc $r->{verdict}, $r->{game}, $r->{params}, $r->{metric},
+                $r->{old}{median}, $r->{new}{median},
+                defined $r->{ratio} ? sprintf("x%.3f", $r->{ratio}) :
+                "up from 0",
+                $r->{old}{p99}, $r->{new}{p99}, $r->{p};
+        }
+        printf "%d comparisons, %d regressions\n",
+            scalar @results, $regressions;
+    }
+
+    return $regressions ? 1 : 0;
+}
+
+sub print_json {
+    my ($value) = @_;
+    require JSON::PP;
+    print JSON::PP->new->canonical->pretty->encode($value);
+}
+
+sub csv {
+    my ($text) = @_;
+    return $text unless $text =~ /[",\n]/;
+    $text =~ s/"/""/g;
+    return "\"$text\"";
+}
@@ -1,25 +1,43 @@
 #!/bin/sh
 
 # Run every puzzle in benchmarking mode, and generate a file of raw
-# data that benchmark.pl will format into a web page.
+# data that benchmark.pl will format into a web page, or into
+# machine-readable statistics.
+
+# Run a puzzle binary, or if the individual puzzle binaries weren't
+# built (e.g. in a headless build), run it via puzzlegen instead. Use
+# 'env -i' to suppress any environment variables that might change the
+# preset list for a puzzle (e.g. user-defined extras).
+run_game() {
+    game=$1; shift
+    if test -x ./$game; then
+        env -i ./$game "$@"
+    else
+        env -i ./puzzlegen $game "$@"
+    fi
+}
 
 # If any arguments are provided, use those as the list of games to
-# benchmark. Otherwise, read the full list from gamedesc.txt.
+# benchmark. Otherwise, read the full list from gamedesc.txt, or ask
+# puzzlegen for it.
 if test $# = 0; then
-    set -- $(cut -f1 -d: < gamedesc.txt)
+    if test -f gamedesc.txt; then
+        set -- $(cut -f1 -d: < gamedesc.txt)
+    else
+        set -- $(./puzzlegen --list | cut -f1 -d' ')
+    fi
 fi
 
 failures=false
 
 for game in "$@"; do
-    # Use 'env -i' to suppress any environment variables that might
-    # change the preset list for a puzzle (e.g. user-defined extras)
-    presets=$(env -i ./$game --list-presets | cut -f1 -d' ')
+    presets=$(run_game $game --list-presets | cut -f1 -d' ')
     for preset in $presets; do
-	if ! env -i ./$game --test-solve --time-generation \
+	if ! run_game $game --test-solve --time-generation \
                             --generate 100 $preset;
         then
             echo "${game} ${preset} failed to generate" >&2
+            failures=true
         fi
     done
 done
@@ -134,8 +134,9 @@ struct game_params {
 typedef unsigned int grid_type; /* change me later if we invent > 16 bits of flags. */
 
 struct solver_state {
-    int *dsf, *comptspaces;
-    int *tmpdsf, *tmpcompspaces;
+    rdsf *dsf;
+    int *comptspaces;
+    int *tmpcompspaces;
     int refcount;
 };
 
@@ -1133,13 +1134,13 @@ static bool map_hasloops(game_state *state, bool mark)
 
 static void map_group(game_state *state)
 {
-    int i, wh = state->w*state->h, d1, d2;
+    int i, d1, d2;
     int x, y, x2, y2;
-    int *dsf = state->solver->dsf;
+    rdsf *dsf = state->solver->dsf;
     struct island *is, *is_join;
 
     /* Initialise dsf. */
-    dsf_init(dsf, wh);
+    rdsf_reset(dsf);
 
     /* For each island, find connected islands right or down
      * and merge the dsf for the island squares as well as the
@@ -1160,7 +1161,7 @@ static void map_group(game_state *state)
                 if (!is_join) continue;
 
                 d2 = DINDEX(is_join->x, is_join->y);
-                if (dsf_canonify(dsf,d1) == dsf_canonify(dsf,d2)) {
+                if (rdsf_canonify(dsf,d1) == rdsf_canonify(dsf,d2)) {
                     ; /* we have a loop. See comment in map_hasloops. */
                     /* However, we still want to merge all squares joining
                      * this side-that-makes-a-loop. */
@@ -1169,7 +1170,7 @@ static void map_group(game_state *state)
                 for (x2 = x; x2 <= is_join->x; x2++) {
                     for (y2 = y; y2 <= is_join->y; y2++) {
                         d2 = DINDEX(x2,y2);
-                        if (d1 != d2) dsf_merge(dsf,d1,d2);
+                        if (d1 != d2) rdsf_merge(dsf,d1,d2);
                     }
                 }
             }
@@ -1180,14 +1181,15 @@ static void map_group(game_state *state)
 static bool map_group_check(game_state *state, int canon, bool warn,
                             int *nislands_r)
 {
-    int *dsf = state->solver->dsf, nislands = 0;
+    rdsf *dsf = state->solver->dsf;
+    int nislands = 0;
     int x, y, i;
     bool allfull = true;
     struct island *is;
 
     for (i = 0; i < state->n_islands; i++) {
         is = &state->islands[i];
-        if (dsf_canonify(dsf, DINDEX(is->x,is->y)) != canon) continue;
+        if (rdsf_canonify(dsf, DINDEX(is->x,is->y)) != canon) continue;
 
         GRID(state, is->x, is->y) |= G_SWEEP;
         nislands++;
@@ -1199,7 +1201,7 @@ static bool map_group_check(game_state *state, int canon, bool warn,
          * Mark all squares with this dsf canon as ERR. */
         for (x = 0; x < state->w; x++) {
             for (y = 0; y < state->h; y++) {
-                if (dsf_canonify(dsf, DINDEX(x,y)) == canon) {
+                if (rdsf_canonify(dsf, DINDEX(x,y)) == canon) {
                     GRID(state,x,y) |= G_WARN;
                 }
             }
@@ -1212,7 +1214,8 @@ static bool map_group_check(game_state *state, int canon, bool warn,
 
 static bool map_group_full(game_state *state, int *ngroups_r)
 {
-    int *dsf = state->solver->dsf, ngroups = 0;
+    rdsf *dsf = state->solver->dsf;
+    int ngroups = 0;
     int i;
     bool anyfull = false;
     struct island *is;
@@ -1224,7 +1227,7 @@ static bool map_group_full(game_state *state, int *ngroups_r)
         if (GRID(state,is->x,is->y) & G_SWEEP) continue;
 
         ngroups++;
-        if (map_group_check(state, dsf_canonify(dsf, DINDEX(is->x,is->y)),
+        if (map_group_check(state, rdsf_canonify(dsf, DINDEX(is->x,is->y)),
                             true, NULL))
             anyfull = true;
     }
@@ -1267,7 +1270,8 @@ static void map_clear(game_state *state)
 static void solve_join(struct island *is, int direction, int n, bool is_max)
 {
     struct island *is_orth;
-    int d1, d2, *dsf = is->state->solver->dsf;
+    int d1, d2;
+    rdsf *dsf = is->state->solver->dsf;
     game_state *state = is->state; /* for DINDEX */
 
     is_orth = INDEX(is->state, gridi,
@@ -1281,8 +1285,8 @@ static void solve_join(struct island *is, int direction, int n, bool is_max)
     if (n > 0 && !is_max) {
         d1 = DINDEX(is->x, is->y);
         d2 = DINDEX(is_orth->x, is_orth->y);
-        if (dsf_canonify(dsf, d1) != dsf_canonify(dsf, d2))
-            dsf_merge(dsf, d1, d2);
+        if (rdsf_canonify(dsf, d1) != rdsf_canonify(dsf, d2))
+            rdsf_merge(dsf, d1, d2);
     }
 }
 
@@ -1382,7 +1386,8 @@ static bool solve_island_stage1(struct island *is, bool *didsth_r)
 static bool solve_island_checkloop(struct island *is, int direction)
 {
     struct island *is_orth;
-    int *dsf = is->state->solver->dsf, d1, d2;
+    rdsf *dsf = is->state->solver->dsf;
+    int d1, d2;
     game_state *state = is->state;
 
     if (is->state->allowloops)
@@ -1399,7 +1404,7 @@ static bool solve_island_checkloop(struct island *is, int direction)
 
     d1 = DINDEX(is->x, is->y);
     d2 = DINDEX(is_orth->x, is_orth->y);
-    if (dsf_canonify(dsf, d1) == dsf_canonify(dsf, d2)) {
+    if (rdsf_canonify(dsf, d1) == rdsf_canonify(dsf, d2)) {
         /* two islands are connected already; don't join them. */
         return true;
     }
@@ -1457,7 +1462,8 @@ static bool solve_island_stage2(struct island *is, bool *didsth_r)
 static bool solve_island_subgroup(struct island *is, int direction)
 {
     struct island *is_join;
-    int nislands, *dsf = is->state->solver->dsf;
+    int nislands;
+    rdsf *dsf = is->state->solver->dsf;
     game_state *state = is->state;
 
     debug(("..checking subgroups.\n"));
@@ -1483,7 +1489,7 @@ static bool solve_island_subgroup(struct island *is, int direction)
     }
 
     /* Check group membership for is->dsf; if it's full return 1. */
-    if (map_group_check(state, dsf_canonify(dsf, DINDEX(is->x,is->y)),
+    if (map_group_check(state, rdsf_canonify(dsf, DINDEX(is->x,is->y)),
                         false, &nislands)) {
         if (nislands < state->n_islands) {
             /* we have a full subgroup that isn't the whole set.
@@ -1518,9 +1524,8 @@ static bool solve_island_impossible(game_state *state)
 /* Bear in mind that this function is really rather inefficient. */
 static bool solve_island_stage3(struct island *is, bool *didsth_r)
 {
-    int i, n, x, y, missing, spc, curr, maxb;
+    int i, n, x, y, missing, spc, curr, maxb, checkpoint;
     bool didsth = false;
-    int wh = is->state->w * is->state->h;
     struct solver_state *ss = is->state->solver;
 
     assert(didsth_r);
@@ -1542,9 +1547,9 @@ static bool solve_island_stage3(struct island *is, bool *didsth_r)
         /* Now we know that this island could have more bridges,
          * to bring the total from curr+1 to curr+spc. */
         maxb = -1;
-        /* We have to squirrel the dsf away and restore it afterwards;
-         * it is additive only, and can't be removed from. */
-        memcpy(ss->tmpdsf, ss->dsf, wh*sizeof(int));
+        /* Removing bridges doesn't split groups in the dsf, so
+         * remember where it was and roll it back afterwards. */
+        checkpoint = rdsf_checkpoint(ss->dsf);
         for (n = curr+1; n <= curr+spc; n++) {
             solve_join(is, i, n, false);
             map_update_possibles(is->state);
@@ -1560,7 +1565,7 @@ static bool solve_island_stage3(struct island *is, bool *didsth_r)
             }
         }
         solve_join(is, i, curr, false); /* put back to before. */
-        memcpy(ss->dsf, ss->tmpdsf, wh*sizeof(int));
+        rdsf_rollback(ss->dsf, checkpoint);
 
         if (maxb != -1) {
             /*debug_state(is->state);*/
@@ -1629,7 +1634,7 @@ static bool solve_island_stage3(struct island *is, bool *didsth_r)
                                   is->adj.points[j].dx ? G_LINEH : G_LINEV);
         if (before[i] != 0) continue;  /* this idea is pointless otherwise */
 
-        memcpy(ss->tmpdsf, ss->dsf, wh*sizeof(int));
+        checkpoint = rdsf_checkpoint(ss->dsf);
 
         for (j = 0; j < is->adj.npoints; j++) {
             spc = island_adjspace(is, true, missing, j);
@@ -1644,7 +1649,7 @@ static bool solve_island_stage3(struct island *is, bool *didsth_r)
 
         for (j = 0; j < is->adj.npoints; j++)
             solve_join(is, j, before[j], false);
-        memcpy(ss->dsf, ss->tmpdsf, wh*sizeof(int));
+        rdsf_rollback(ss->dsf, checkpoint);
 
         if (got) {
             debug(("island at (%d,%d) must connect in direction (%d,%d) to"
@@ -1763,8 +1768,7 @@ static game_state *new_state(const game_params *params)
     ret->completed = false;
 
     ret->solver = snew(struct solver_state);
-    ret->solver->dsf = snew_dsf(wh);
-    ret->solver->tmpdsf = snewn(wh, int);
+    ret->solver->dsf = rdsf_new(wh, true);
 
     ret->solver->refcount = 1;
 
@@ -1813,8 +1817,7 @@ static game_state *dup_game(const game_state *state)
 static void free_game(game_state *state)
 {
     if (--state->solver->refcount <= 0) {
-        sfree(state->solver->dsf);
-        sfree(state->solver->tmpdsf);
+        rdsf_free(state->solver->dsf);
         sfree(state->solver);
     }
 
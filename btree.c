@@ -0,0 +1,909 @@
+/*
+ * btree.c: counted B-trees with wide nodes, for large collections
+ * that are searched far more often than they're modified.
+ *
+ * A 2-3-4 tree spends a separately allocated node, and hence most
+ * likely a cache miss on every lookup, on each one to three
+ * elements. Here a node holds up to BT_MAX elements in a contiguous
+ * array, so that a tree of a hundred thousand elements is only four
+ * levels deep and most of a search is a binary search within a node
+ * that's already in cache. Leaf nodes, which are the great majority,
+ * don't carry the arrays of child pointers and subtree counts at all.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "puzzles.h"
+#include "btree.h"
+
+#define BT_MAX 31                      /* most elements in a node */
+#define BT_MIN (BT_MAX / 2)            /* fewest in any node but the root */
+
+/*
+ * Each node has room for one more element (and child) than it's
+ * allowed to keep, so that insertion can put the new element in
+ * place first and split the node afterwards if it has overflowed.
+ */
+typedef struct btnode {
+    int nelems;
+    bool leaf;
+    void *elems[BT_MAX + 1];
+} btnode;
+
+/*
+ * An internal node has one more child than it has elements, and
+ * counts[k] is the total number of elements in the subtree kids[k].
+ */
+typedef struct btinternal {
+    btnode node;
+    btnode *kids[BT_MAX + 2];
+    int counts[BT_MAX + 2];
+} btinternal;
+
+#define INTERNAL(n) ((btinternal *)(n))
+
+struct btree {
+    btnode *root;                      /* NULL if the tree is empty */
+    int count;
+    cmpfn234 cmp;
+};
+
+static btnode *new_leaf(void)
+{
+    btnode *n = snew(btnode);
+    n->nelems = 0;
+    n->leaf = true;
+    return n;
+}
+
+static btnode *new_internal(void)
+{
+    btinternal *in = snew(btinternal);
+    in->node.nelems = 0;
+    in->node.leaf = false;
+    return &in->node;
+}
+
+static void free_node(btnode *n)
+{
+    int k;
+
+    if (!n)
+        return;
+    if (!n->leaf)
+        for (k = 0; k <= n->nelems; k++)
+            free_node(INTERNAL(n)->kids[k]);
+    sfree(n);
+}
+
+static int node_count(btnode *n)
+{
+    int count = n->nelems, k;
+
+    if (!n->leaf)
+        for (k = 0; k <= n->nelems; k++)
+            count += INTERNAL(n)->counts[k];
+    return count;
+}
+
+btree *btree_new(cmpfn234 cmp)
+{
+    btree *t = snew(btree);
+    t->root = NULL;
+    t->count = 0;
+    t->cmp = cmp;
+    return t;
+}
+
+void btree_free(btree *t)
+{
+    if (!t)
+        return;
+    free_node(t->root);
+    sfree(t);
+}
+
+int btree_count(btree *t)
+{
+    return t->count;
+}
+
+/* ----------------------------------------------------------------------
+ * Building a tree in one go from an array.
+ */
+
+/*
+ * Build a subtree of exactly the given height from n elements, where
+ * cap[h] is the most elements a subtree of height h can hold.
+ *
+ * We give each node as few children as will hold its elements, and
+ * share the elements out between them as evenly as possible. That
+ * leaves every child at least half full, which is all the minimum
+ * occupancy rule asks.
+ */
+static btnode *build(void **elems, int n, int height, const int *cap)
+{
+    btinternal *in;
+    int nkids, per, extra, i;
+
+    if (height == 0) {
+        btnode *leaf = new_leaf();
+        assert(n <= BT_MAX);
+        memcpy(leaf->elems, elems, n * sizeof(void *));
+        leaf->nelems = n;
+        return leaf;
+    }
+
+    for (nkids = 2; nkids * cap[height-1] + nkids - 1 < n; nkids++);
+    assert(nkids <= BT_MAX + 1);
+    per = (n - (nkids - 1)) / nkids;
+    extra = (n - (nkids - 1)) % nkids;
+
+    in = INTERNAL(new_internal());
+    for (i = 0; i < nkids; i++) {
+        int size = per + (i < extra);
+        in->kids[i] = build(elems, size, height - 1, cap);
+        in->counts[i] = size;
+        elems += size;
+        if (i < nkids - 1)
+            in->node.elems[i] = *elems++;
+    }
+    in->node.nelems = nkids - 1;
+    return &in->node;
+}
+
+/*
+ * Replace the contents of t with the n elements in an array.
+ */
+static void set_contents(btree *t, void **elems, int n)
+{
+    int cap[16], height = 0;
+
+    cap[0] = BT_MAX;
+    while (cap[height] < n) {
+        height++;
+        assert(height < lenof(cap));
+        if (cap[height-1] > (INT_MAX - BT_MAX) / (BT_MAX + 1))
+            cap[height] = INT_MAX;
+        else
+            cap[height] = BT_MAX + (BT_MAX + 1) * cap[height-1];
+    }
+
+    free_node(t->root);
+    t->root = (n > 0 ? build(elems, n, height, cap) : NULL);
+    t->count = n;
+}
+
+btree *btree_new_sorted(cmpfn234 cmp, void **elems, int n)
+{
+    btree *t = btree_new(cmp);
+    int i;
+
+    if (cmp)
+        for (i = 1; i < n; i++)
+            assert(cmp(elems[i-1], elems[i]) < 0);
+    set_contents(t, elems, n);
+    return t;
+}
+
+/* ----------------------------------------------------------------------
+ * Lookups.
+ */
+
+void *btree_index(btree *t, int index)
+{
+    btnode *n = t->root;
+
+    if (index < 0 || index >= t->count)
+        return NULL;
+
+    while (!n->leaf) {
+        btinternal *in = INTERNAL(n);
+        int k = 0;
+        while (index > in->counts[k]) {
+            index -= in->counts[k] + 1;
+            k++;
+        }
+        if (index == in->counts[k])
+            return n->elems[k];
+        n = in->kids[k];
+    }
+    return n->elems[index];
+}
+
+/*
+ * Find the number of elements in the tree that compare less than e.
+ * If one compares equal to it, return that in *found, or NULL if
+ * none does.
+ */
+static int locate(btree *t, void *e, cmpfn234 cmp, void **found)
+{
+    btnode *n = t->root;
+    int pos = 0;
+
+    *found = NULL;
+    while (n) {
+        int lo = 0, hi = n->nelems, k;
+
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            int c = cmp(e, n->elems[mid]);
+            if (c == 0) {
+                *found = n->elems[mid];
+                lo = mid;
+                break;
+            }
+            if (c > 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        pos += lo;
+        if (n->leaf)
+            break;
+        for (k = 0; k < lo; k++)
+            pos += INTERNAL(n)->counts[k];
+        if (*found) {
+            pos += INTERNAL(n)->counts[lo];
+            break;
+        }
+        n = INTERNAL(n)->kids[lo];
+    }
+
+    return pos;
+}
+
+void *btree_findrelpos(btree *t, void *e, cmpfn234 cmp, int relation,
+                       int *index)
+{
+    void *found = NULL;
+    int pos;
+
+    if (!cmp)
+        cmp = t->cmp;
+    assert(cmp);
+
+    if (e == NULL) {
+        assert(relation == REL234_LT || relation == REL234_GT);
+        pos = (relation == REL234_GT ? 0 : t->count - 1);
+    } else {
+        pos = locate(t, e, cmp, &found);
+        switch (relation) {
+          case REL234_EQ:
+            if (!found)
+                return NULL;
+            break;
+          case REL234_LT:
+            found = NULL;
+            pos--;
+            break;
+          case REL234_LE:
+            if (!found)
+                pos--;
+            break;
+          case REL234_GT:
+            if (found) {
+                found = NULL;
+                pos++;
+            }
+            break;
+          case REL234_GE:
+            break;
+        }
+    }
+
+    if (pos < 0 || pos >= t->count)
+        return NULL;
+    if (index)
+        *index = pos;
+    return found ? found : btree_index(t, pos);
+}
+
+void *btree_find(btree *t, void *e, cmpfn234 cmp)
+{
+    return btree_findrelpos(t, e, cmp, REL234_EQ, NULL);
+}
+
+void *btree_findrel(btree *t, void *e, cmpfn234 cmp, int relation)
+{
+    return btree_findrelpos(t, e, cmp, relation, NULL);
+}
+
+void *btree_findpos(btree *t, void *e, cmpfn234 cmp, int *index)
+{
+    return btree_findrelpos(t, e, cmp, REL234_EQ, index);
+}
+
+/* ----------------------------------------------------------------------
+ * Insertion.
+ */
+
+/*
+ * Split an overfull node in two, returning the new right-hand half
+ * and the element that should separate the two in the parent.
+ */
+static btnode *split_node(btnode *n, void **sep)
+{
+    int nleft = (BT_MAX + 1) / 2, nright = n->nelems - nleft - 1;
+    btnode *right = (n->leaf ? new_leaf() : new_internal());
+
+    memcpy(right->elems, &n->elems[nleft + 1], nright * sizeof(void *));
+    if (!n->leaf) {
+        memcpy(INTERNAL(right)->kids, &INTERNAL(n)->kids[nleft + 1],
+               (nright + 1) * sizeof(btnode *));
+        memcpy(INTERNAL(right)->counts, &INTERNAL(n)->counts[nleft + 1],
+               (nright + 1) * sizeof(int));
+    }
+    right->nelems = nright;
+    *sep = n->elems[nleft];
+    n->nelems = nleft;
+    return right;
+}
+
+/*
+ * Insert e at position 'index' in the subtree rooted at n. If that
+ * overfills n, split it, returning the new right-hand half and
+ * putting the separating element in *sep; otherwise return NULL.
+ */
+static btnode *insert(btnode *n, int index, void *e, void **sep)
+{
+    int k;
+
+    if (n->leaf) {
+        k = index;
+    } else {
+        btinternal *in = INTERNAL(n);
+        btnode *right;
+
+        for (k = 0; index > in->counts[k]; k++)
+            index -= in->counts[k] + 1;
+        right = insert(in->kids[k], index, e, &e);
+        in->counts[k]++;
+        if (!right)
+            return NULL;
+
+        /*
+         * The child split, so its separator and new right half go in
+         * here, after it.
+         */
+        memmove(&in->kids[k + 2], &in->kids[k + 1],
+                (n->nelems - k) * sizeof(btnode *));
+        memmove(&in->counts[k + 2], &in->counts[k + 1],
+                (n->nelems - k) * sizeof(int));
+        in->kids[k + 1] = right;
+        in->counts[k] = node_count(in->kids[k]);
+        in->counts[k + 1] = node_count(right);
+    }
+
+    memmove(&n->elems[k + 1], &n->elems[k],
+            (n->nelems - k) * sizeof(void *));
+    n->elems[k] = e;
+    n->nelems++;
+
+    return (n->nelems > BT_MAX ? split_node(n, sep) : NULL);
+}
+
+static void add_at(btree *t, void *e, int index)
+{
+    btnode *right;
+    void *sep;
+
+    if (!t->root)
+        t->root = new_leaf();
+
+    right = insert(t->root, index, e, &sep);
+    if (right) {
+        btinternal *in = INTERNAL(new_internal());
+        in->node.nelems = 1;
+        in->node.elems[0] = sep;
+        in->kids[0] = t->root;
+        in->kids[1] = right;
+        in->counts[0] = node_count(t->root);
+        in->counts[1] = node_count(right);
+        t->root = &in->node;
+    }
+    t->count++;
+}
+
+void *btree_add(btree *t, void *e)
+{
+    void *found;
+    int pos;
+
+    assert(t->cmp);
+    pos = locate(t, e, t->cmp, &found);
+    if (found)
+        return found;
+    add_at(t, e, pos);
+    return e;
+}
+
+void *btree_addpos(btree *t, void *e, int index)
+{
+    if (t->cmp || index < 0 || index > t->count)
+        return NULL;
+    add_at(t, e, index);
+    return e;
+}
+
+/* ----------------------------------------------------------------------
+ * Deletion.
+ */
+
+/*
+ * Bring kids[k] of an internal node back up to the minimum size, if
+ * a deletion has taken it below, by taking an element from a sibling
+ * that can spare one or else merging it with a sibling.
+ */
+static void rebalance(btinternal *in, int k)
+{
+    btnode *n = &in->node, *kid = in->kids[k], *sib;
+    int moved;
+
+    if (kid->nelems >= BT_MIN)
+        return;
+
+    if (k > 0 && in->kids[k - 1]->nelems > BT_MIN) {
+        /*
+         * Rotate right: the separator comes down to the front of kid,
+         * and the left sibling's last element goes up to replace it.
+         */
+        sib = in->kids[k - 1];
+        memmove(&kid->elems[1], &kid->elems[0],
+                kid->nelems * sizeof(void *));
+        kid->elems[0] = n->elems[k - 1];
+        n->elems[k - 1] = sib->elems[sib->nelems - 1];
+        moved = 1;
+        if (!kid->leaf) {
+            btinternal *ik = INTERNAL(kid), *is = INTERNAL(sib);
+            memmove(&ik->kids[1], &ik->kids[0],
+                    (kid->nelems + 1) * sizeof(btnode *));
+            memmove(&ik->counts[1], &ik->counts[0],
+                    (kid->nelems + 1) * sizeof(int));
+            ik->kids[0] = is->kids[sib->nelems];
+            ik->counts[0] = is->counts[sib->nelems];
+            moved += ik->counts[0];
+        }
+        kid->nelems++;
+        sib->nelems--;
+        in->counts[k] += moved;
+        in->counts[k - 1] -= moved;
+    } else if (k < n->nelems && in->kids[k + 1]->nelems > BT_MIN) {
+        /* Rotate left, the mirror image of the above. */
+        sib = in->kids[k + 1];
+        kid->elems[kid->nelems] = n->elems[k];
+        n->elems[k] = sib->elems[0];
+        memmove(&sib->elems[0], &sib->elems[1],
+                (sib->nelems - 1) * sizeof(void *));
+        moved = 1;
+        if (!kid->leaf) {
+            btinternal *ik = INTERNAL(kid), *is = INTERNAL(sib);
+            ik->kids[kid->nelems + 1] = is->kids[0];
+            ik->counts[kid->nelems + 1] = is->counts[0];
+            moved += is->counts[0];
+            memmove(&is->kids[0], &is->kids[1],
+                    sib->nelems * sizeof(btnode *));
+            memmove(&is->counts[0], &is->counts[1],
+                    sib->nelems * sizeof(int));
+        }
+        kid->nelems++;
+        sib->nelems--;
+        in->counts[k] += moved;
+        in->counts[k + 1] -= moved;
+    } else {
+        /*
+         * Neither sibling has any to spare, so merge kid with one of
+         * them, bringing down the separator between. The result has
+         * at most 2*BT_MIN elements, so fits in a node.
+         */
+        int j = (k > 0 ? k - 1 : k);
+        btnode *left = in->kids[j], *right = in->kids[j + 1];
+
+        left->elems[left->nelems] = n->elems[j];
+        memcpy(&left->elems[left->nelems + 1], right->elems,
+               right->nelems * sizeof(void *));
+        if (!left->leaf) {
+            memcpy(&INTERNAL(left)->kids[left->nelems + 1],
+                   INTERNAL(right)->kids,
+                   (right->nelems + 1) * sizeof(btnode *));
+            memcpy(&INTERNAL(left)->counts[left->nelems + 1],
+                   INTERNAL(right)->counts,
+                   (right->nelems + 1) * sizeof(int));
+        }
+        left->nelems += right->nelems + 1;
+        in->counts[j] += in->counts[j + 1] + 1;
+        sfree(right);
+
+        memmove(&n->elems[j], &n->elems[j + 1],
+                (n->nelems - j - 1) * sizeof(void *));
+        memmove(&in->kids[j + 1], &in->kids[j + 2],
+                (n->nelems - j - 1) * sizeof(btnode *));
+        memmove(&in->counts[j + 1], &in->counts[j + 2],
+                (n->nelems - j - 1) * sizeof(int));
+        n->nelems--;
+    }
+}
+
+/*
+ * Remove and return the element at position 'index' in the subtree
+ * rooted at n. This may leave n itself below the minimum size, which
+ * is for the caller to put right.
+ */
+static void *delete_at(btnode *n, int index)
+{
+    btinternal *in;
+    void *ret;
+    int k;
+
+    if (n->leaf) {
+        ret = n->elems[index];
+        memmove(&n->elems[index], &n->elems[index + 1],
+                (n->nelems - index - 1) * sizeof(void *));
+        n->nelems--;
+        return ret;
+    }
+
+    in = INTERNAL(n);
+    for (k = 0; index > in->counts[k]; k++)
+        index -= in->counts[k] + 1;
+    if (index == in->counts[k]) {
+        /*
+         * It's the separator elems[k]. Replace it with its
+         * predecessor, which is the last element of kids[k].
+         */
+        ret = n->elems[k];
+        n->elems[k] = delete_at(in->kids[k], in->counts[k] - 1);
+    } else {
+        ret = delete_at(in->kids[k], index);
+    }
+    in->counts[k]--;
+    rebalance(in, k);
+    return ret;
+}
+
+void *btree_delpos(btree *t, int index)
+{
+    void *ret;
+
+    if (index < 0 || index >= t->count)
+        return NULL;
+
+    ret = delete_at(t->root, index);
+    t->count--;
+    if (t->root->nelems == 0) {
+        btnode *old = t->root;
+        t->root = (old->leaf ? NULL : INTERNAL(old)->kids[0]);
+        sfree(old);
+    }
+    return ret;
+}
+
+void *btree_del(btree *t, void *e)
+{
+    void *found;
+    int pos;
+
+    assert(t->cmp);
+    pos = locate(t, e, t->cmp, &found);
+    return found ? btree_delpos(t, pos) : NULL;
+}
+
+/* ----------------------------------------------------------------------
+ * Splitting and joining, by flattening the trees into an array and
+ * building new ones from it.
+ */
+
+static void **flatten(btnode *n, void **out)
+{
+    int k;
+
+    if (!n)
+        return out;
+    for (k = 0; k < n->nelems; k++) {
+        if (!n->leaf)
+            out = flatten(INTERNAL(n)->kids[k], out);
+        *out++ = n->elems[k];
+    }
+    if (!n->leaf)
+        out = flatten(INTERNAL(n)->kids[n->nelems], out);
+    return out;
+}
+
+btree *btree_splitpos(btree *t, int index, bool before)
+{
+    btree *ret;
+    void **elems;
+    int count = t->count;
+
+    if (index < 0 || index > count)
+        return NULL;
+
+    elems = snewn(count + 1, void *);
+    flatten(t->root, elems);
+    ret = btree_new(t->cmp);
+    if (before) {
+        set_contents(ret, elems, index);
+        set_contents(t, elems + index, count - index);
+    } else {
+        set_contents(ret, elems + index, count - index);
+        set_contents(t, elems, index);
+    }
+    sfree(elems);
+    return ret;
+}
+
+btree *btree_join(btree *t1, btree *t2)
+{
+    void **elems;
+    int count = t1->count + t2->count;
+
+    if (t2->count == 0)
+        return t1;
+    if (t1->cmp && t1->count > 0 &&
+        t1->cmp(btree_index(t1, t1->count - 1), btree_index(t2, 0)) >= 0)
+        return NULL;
+
+    elems = snewn(count, void *);
+    flatten(t2->root, flatten(t1->root, elems));
+    set_contents(t1, elems, count);
+    set_contents(t2, NULL, 0);
+    sfree(elems);
+    return t1;
+}
+
+#ifdef BTREE_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int intcmp(void *av, void *bv)
+{
+    int a = *(int *)av, b = *(int *)bv;
+    return a < b ? -1 : a > b ? +1 : 0;
+}
+
+static int failures = 0;
+
+static void fail(const char *what, int iteration)
+{
+    printf("Failed at iteration %d: %s\n", iteration, what);
+    failures++;
+}
+
+/*
+ * Check the structural invariants of a subtree, returning its height
+ * (or -1 if something's wrong) and adding its size to *count.
+ */
+static int check_node(btnode *n, bool isroot, int *count)
+{
+    int height = 0, k;
+
+    if (n->nelems > BT_MAX || n->nelems < (isroot ? 1 : BT_MIN))
+        return -1;
+    *count += n->nelems;
+    if (n->leaf)
+        return 0;
+    for (k = 0; k <= n->nelems; k++) {
+        int subcount = 0;
+        int h = check_node(INTERNAL(n)->kids[k], false, &subcount);
+        if (h < 0 || (k > 0 && h != height) ||
+            subcount != INTERNAL(n)->counts[k])
+            return -1;
+        height = h;
+        *count += subcount;
+    }
+    return height + 1;
+}
+
+/*
+ * Check a btree has the same contents as a tree234, in the same
+ * order, and that it's a valid B-tree.
+ */
+static bool same(btree *bt, tree234 *t)
+{
+    int i, count = 0;
+
+    if (bt->root && check_node(bt->root, true, &count) < 0)
+        return false;
+    if (count != bt->count || bt->count != count234(t))
+        return false;
+    for (i = 0; i < count; i++)
+        if (btree_index(bt, i) != index234(t, i))
+            return false;
+    return true;
+}
+
+#define NVALUES 1000
+
+int main(int argc, char **argv)
+{
+    static int values[NVALUES];
+    unsigned seed;
+    int iteration, i;
+    clock_t start;
+
+    seed = (argc > 1 ? strtoul(argv[1], NULL, 0) : time(NULL));
+    printf("Random seed = %u\n", seed);
+    srand(seed);
+
+    for (i = 0; i < NVALUES; i++)
+        values[i] = i;
+
+    /*
+     * Random operations on sorted trees, compared with tree234.
+     */
+    for (iteration = 0; iteration < 200; iteration++) {
+        btree *bt = btree_new(intcmp);
+        tree234 *t = newtree234(intcmp);
+        int range = 1 + rand() % NVALUES, step;
+
+        for (step = 0; step < 2000; step++) {
+            void *e = &values[rand() % range];
+            int op = rand() % 8, rel = rand() % 5, i1 = -1, i2 = -1;
+
+            if (op < 4) {
+                if (btree_add(bt, e) != add234(t, e))
+                    fail("add", iteration);
+            } else if (op < 6) {
+                if (btree_del(bt, e) != del234(t, e))
+                    fail("del", iteration);
+            } else if (op == 6) {
+                int index = rand() % (count234(t) + 1);
+                if (btree_delpos(bt, index) != delpos234(t, index))
+                    fail("delpos", iteration);
+            } else {
+                if (rand() % 4 == 0) {
+                    e = NULL;
+                    rel = (rand() % 2 ? REL234_LT : REL234_GT);
+                }
+                if (btree_findrelpos(bt, e, NULL, rel, &i1) !=
+                    findrelpos234(t, e, NULL, rel, &i2) || i1 != i2)
+                    fail("findrelpos", iteration);
+            }
+            if (failures)
+                return 1;
+        }
+        if (!same(bt, t)) {
+            fail("contents", iteration);
+            return 1;
+        }
+
+        /* Split at a random point, check both halves, and rejoin. */
+        {
+            int index = rand() % (count234(t) + 1);
+            bool before = rand() % 2;
+            btree *bt2 = btree_splitpos(bt, index, before);
+            tree234 *t2 = splitpos234(t, index, before);
+
+            if (!same(bt, t) || !same(bt2, t2)) {
+                fail("splitpos", iteration);
+                return 1;
+            }
+            if (count234(t) > 0 && count234(t2) > 0 &&
+                (before ? btree_join(bt, bt2) : btree_join(bt2, bt))) {
+                fail("join out of order", iteration);
+                return 1;
+            }
+            if (before ? (!btree_join(bt2, bt) || !join234(t2, t) ||
+                          !same(bt2, t2) || btree_count(bt) != 0) :
+                (!btree_join(bt, bt2) || !join234(t, t2) ||
+                 !same(bt, t) || btree_count(bt2) != 0)) {
+                fail("join", iteration);
+                return 1;
+            }
+            btree_free(bt2);
+            freetree234(t2);
+        }
+
+        btree_free(bt);
+        freetree234(t);
+    }
+
+    /*
+     * Unsorted trees, which are only accessed by index.
+     */
+    for (iteration = 0; iteration < 200; iteration++) {
+        btree *bt = btree_new(NULL);
+        tree234 *t = newtree234(NULL);
+        int step;
+
+        for (step = 0; step < 2000; step++) {
+            int index = rand() % (count234(t) + 1);
+            if (rand() % 3) {
+                void *e = &values[rand() % NVALUES];
+                if (btree_addpos(bt, e, index) != addpos234(t, e, index))
+                    fail("addpos", iteration);
+            } else {
+                if (btree_delpos(bt, index) != delpos234(t, index))
+                    fail("delpos", iteration);
+            }
+            if (failures)
+                return 1;
+        }
+        if (!same(bt, t)) {
+            fail("unsorted contents", iteration);
+            return 1;
+        }
+        btree_free(bt);
+        freetree234(t);
+    }
+
+    /*
+     * Bulk building, at every size up to a few levels deep.
+     */
+    {
+        void **elems = snewn(40000, void *);
+        int *ints = snewn(40000, int);
+        int n;
+
+        for (i = 0; i < 40000; i++) {
+            ints[i] = i;
+            elems[i] = &ints[i];
+        }
+        for (n = 0; n <= 40000; n += (n < 2000 ? 1 : 997)) {
+            btree *bt = btree_new_sorted(intcmp, elems, n);
+            int count = 0;
+            if ((n > 0 && check_node(bt->root, true, &count) < 0) ||
+                count != n || btree_count(bt) != n) {
+                fail("bulk build", n);
+                return 1;
+            }
+            for (i = 0; i < n; i += 1 + i / 16)
+                if (btree_index(bt, i) != elems[i] ||
+                    btree_find(bt, elems[i], NULL) != elems[i]) {
+                    fail("bulk build lookup", n);
+                    return 1;
+                }
+            btree_free(bt);
+        }
+        sfree(elems);
+        sfree(ints);
+    }
+
+    /*
+     * Timings, with the find-or-add pattern used to deduplicate grid
+     * vertices: a million lookups in a set that grows to a quarter
+     * of a million elements.
+     */
+    {
+        int n = 1 << 20, range = 1 << 18;
+        int *keys = snewn(n, int);
+        btree *bt = btree_new(intcmp);
+        tree234 *t = newtree234(intcmp);
+
+        for (i = 0; i < n; i++)
+            keys[i] = rand() % range;
+
+        start = clock();
+        for (i = 0; i < n; i++)
+            if (!find234(t, &keys[i], NULL))
+                add234(t, &keys[i]);
+        printf("tree234: %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+
+        start = clock();
+        for (i = 0; i < n; i++)
+            if (!btree_find(bt, &keys[i], NULL))
+                btree_add(bt, &keys[i]);
+        printf("btree:   %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+
+        if (!same(bt, t)) {
+            fail("timing run contents", 0);
+            return 1;
+        }
+
+        btree_free(bt);
+        freetree234(t);
+        sfree(keys);
+    }
+
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* BTREE_TEST */
@@ -0,0 +1,67 @@
+/*
+ * btree.h: header defining functions in btree.c.
+ *
+ * A btree is a counted, optionally sorted, collection with the same
+ * semantics as a tree234 (and using the same comparison function
+ * type and REL234_* relations), but stored with many elements per
+ * node. It's the better choice for large collections that are looked
+ * up much more often than they're changed.
+ */
+
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <stdbool.h>
+
+#include "tree234.h"
+
+typedef struct btree btree;
+
+/*
+ * Create an empty btree. If `cmp' is NULL, the tree is unsorted, and
+ * elements can only be added, found and removed by index.
+ */
+btree *btree_new(cmpfn234 cmp);
+
+/*
+ * Create a btree containing the n elements of an array, in the
+ * order given. If `cmp' is non-NULL, the array must already be in
+ * strictly increasing order according to it. This takes linear
+ * time, and packs the nodes fuller than adding the elements one at
+ * a time would.
+ */
+btree *btree_new_sorted(cmpfn234 cmp, void **elems, int n);
+
+/*
+ * Free a btree (not including freeing the elements).
+ */
+void btree_free(btree *t);
+
+int btree_count(btree *t);
+
+/*
+ * These behave exactly like add234, addpos234, index234, the
+ * find*234 family, del234 and delpos234 respectively.
+ */
+void *btree_add(btree *t, void *e);
+void *btree_addpos(btree *t, void *e, int index);
+void *btree_index(btree *t, int index);
+void *btree_find(btree *t, void *e, cmpfn234 cmp);
+void *btree_findrel(btree *t, void *e, cmpfn234 cmp, int relation);
+void *btree_findpos(btree *t, void *e, cmpfn234 cmp, int *index);
+void *btree_findrelpos(btree *t, void *e, cmpfn234 cmp, int relation,
+                       int *index);
+void *btree_del(btree *t, void *e);
+void *btree_delpos(btree *t, int index);
+
+/*
+ * Split and join, with the semantics of splitpos234 and join234
+ * (so btree_join empties t2 into t1, and returns NULL without doing
+ * anything if the result would be out of order). Unlike the tree234
+ * versions these take time linear in the size of the trees, since
+ * they work by rebuilding them.
+ */
+btree *btree_splitpos(btree *t, int index, bool before);
+btree *btree_join(btree *t1, btree *t2);
+
+#endif /* BTREE_H */
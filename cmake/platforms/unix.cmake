@@ -1,7 +1,8 @@
 set(PUZZLES_GTK_VERSION "ANY"
-  CACHE STRING "Which major version of GTK to build with")
+  CACHE STRING "Which major version of GTK to build with \
+(or NONE to build only the command-line tools)")
 set_property(CACHE PUZZLES_GTK_VERSION
-  PROPERTY STRINGS ANY 3 2)
+  PROPERTY STRINGS ANY 3 2 NONE)
 
 set(STRICT OFF
   CACHE BOOL "Enable extra compiler warnings and make them errors")
@@ -27,19 +28,36 @@ endmacro()
 try_gtk_package(3 gtk+-3.0)
 try_gtk_package(2 gtk+-2.0)
 
-if(NOT PUZZLES_GTK_FOUND)
-  message(FATAL_ERROR "Unable to find any usable version of GTK.")
-endif()
+if(PUZZLES_GTK_VERSION STREQUAL NONE)
+  # Headless build, for machines that only want to generate puzzles
+  # in bulk: no GUI puzzles at all, just the command-line programs
+  # (including puzzlegen, which does everything the GUI puzzles'
+  # --generate mode can).
+  set(platform_common_sources printing.c batchgen.c)
+  set(platform_gui_libs)
+  set(build_individual_puzzles FALSE)
+  set(build_gui_programs FALSE)
+else()
+  if(NOT PUZZLES_GTK_FOUND)
+    message(FATAL_ERROR "Unable to find any usable version of GTK. \
+(Configure with -DPUZZLES_GTK_VERSION=NONE to build only the \
+command-line tools.)")
+  endif()
 
-include_directories(${GTK_INCLUDE_DIRS})
-link_directories(${GTK_LIBRARY_DIRS})
+  include_directories(${GTK_INCLUDE_DIRS})
+  link_directories(${GTK_LIBRARY_DIRS})
 
-set(platform_common_sources gtk.c printing.c)
-set(platform_gui_libs ${GTK_LIBRARIES})
+  set(platform_common_sources gtk.c printing.c batchgen.c)
+  set(platform_gui_libs ${GTK_LIBRARIES})
+endif()
 
-set(platform_libs -lm)
+# Threads are used by the '--jobs' option to the bulk generation mode.
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads REQUIRED)
 
-set(build_icons TRUE)
+set(platform_libs -lm Threads::Threads)
+
+set(build_icons ${build_individual_puzzles})
 if(CMAKE_CROSSCOMPILING)
   # The puzzle icons are built by compiling and running a preliminary
   # set of puzzle binaries. We can't do that if the binaries won't run
@@ -107,4 +125,27 @@ function(set_platform_puzzle_target_properties NAME TARGET)
 endfunction()
 
 function(build_platform_extras)
+  if(build_cli_programs)
+    # A single binary containing every puzzle's generator, with no
+    # dependency on GTK, for bulk generation on headless machines.
+    write_generated_games_header()
+    add_executable(puzzlegen puzzlegen.c headless.c list.c ${puzzle_sources})
+    target_compile_definitions(puzzlegen PRIVATE COMBINED)
+    target_include_directories(puzzlegen PRIVATE ${generated_include_dir})
+    target_link_libraries(puzzlegen common ${platform_libs})
+    set_target_properties(puzzlegen PROPERTIES
+      OUTPUT_NAME ${NAME_PREFIX}puzzlegen)
+    if(CMAKE_VERSION VERSION_LESS 3.14)
+      install(TARGETS puzzlegen RUNTIME DESTINATION bin)
+    else()
+      install(TARGETS puzzlegen)
+    endif()
+
+    # Stress test running every back end on several threads at once.
+    # Not installed.
+    add_executable(threadtest threadtest.c headless.c list.c ${puzzle_sources})
+    target_compile_definitions(threadtest PRIVATE COMBINED)
+    target_include_directories(threadtest PRIVATE ${generated_include_dir})
+    target_link_libraries(threadtest common ${platform_libs})
+  endif()
 endfunction()
@@ -0,0 +1,456 @@
+/*
+ * dlx.c: exact cover by Knuth's Algorithm X, using the 'dancing
+ * links' representation.
+ *
+ * The matrix is stored sparsely, as one node per 1, each linked
+ * into a circular doubly linked list along its row and another down
+ * its column, with a header node at the top of each column. Covering
+ * a column unlinks it and every row meeting it; because an unlinked
+ * node keeps its own links, uncovering can put everything back in
+ * reverse order without any further bookkeeping. So backtracking
+ * costs no more than going forward, and each step of the search
+ * only looks at the part of the matrix that's still live.
+ *
+ * Nodes are indices into parallel arrays rather than pointers, so
+ * that adding rows can simply grow the arrays.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "puzzles.h"
+
+struct dlx {
+    int nprimary, ncols;
+    int nrows;
+    /*
+     * Node 0 is the root, whose row list threads through the primary
+     * column headers; nodes 1..ncols are the column headers (a
+     * secondary column's header is linked only to itself
+     * horizontally); everything after that is a 1 in some row.
+     */
+    int nnodes, nodesize;
+    int *left, *right, *up, *down;
+    int *col;                          /* column header of each node */
+    int *row;                          /* row index of each node */
+    int *size;                         /* live rows in each column */
+    /*
+     * The rows chosen at each level of the current search, and a
+     * copy of them from the first solution found.
+     */
+    int *chosen;
+    int *solution, nsolution;
+};
+
+dlx *dlx_new(int nprimary, int nsecondary)
+{
+    dlx *d = snew(dlx);
+    int i;
+
+    assert(nprimary >= 0 && nsecondary >= 0);
+    d->nprimary = nprimary;
+    d->ncols = nprimary + nsecondary;
+    d->nrows = 0;
+    d->nnodes = d->ncols + 1;
+    d->nodesize = d->nnodes * 4;
+    d->left = snewn(d->nodesize, int);
+    d->right = snewn(d->nodesize, int);
+    d->up = snewn(d->nodesize, int);
+    d->down = snewn(d->nodesize, int);
+    d->col = snewn(d->nodesize, int);
+    d->row = snewn(d->nodesize, int);
+    d->size = snewn(d->ncols + 1, int);
+
+    for (i = 0; i <= d->ncols; i++) {
+        d->up[i] = d->down[i] = d->col[i] = i;
+        d->row[i] = -1;
+        d->size[i] = 0;
+        if (i > nprimary) {
+            d->left[i] = d->right[i] = i;
+        } else {
+            d->left[i] = (i == 0 ? nprimary : i - 1);
+            d->right[i] = (i == nprimary ? 0 : i + 1);
+        }
+    }
+
+    /*
+     * Each chosen row covers at least one primary column, so a search
+     * can't go deeper than there are primary columns.
+     */
+    d->chosen = snewn(nprimary + 1, int);
+    d->solution = snewn(nprimary + 1, int);
+    d->nsolution = 0;
+
+    return d;
+}
+
+void dlx_free(dlx *d)
+{
+    if (!d)
+        return;
+    sfree(d->left);
+    sfree(d->right);
+    sfree(d->up);
+    sfree(d->down);
+    sfree(d->col);
+    sfree(d->row);
+    sfree(d->size);
+    sfree(d->chosen);
+    sfree(d->solution);
+    sfree(d);
+}
+
+int dlx_add_row(dlx *d, const int *cols, int n)
+{
+    int i, first = d->nnodes;
+
+    assert(n > 0);
+    if (d->nnodes + n > d->nodesize) {
+        d->nodesize = (d->nnodes + n) * 5 / 4 + 16;
+        d->left = sresize(d->left, d->nodesize, int);
+        d->right = sresize(d->right, d->nodesize, int);
+        d->up = sresize(d->up, d->nodesize, int);
+        d->down = sresize(d->down, d->nodesize, int);
+        d->col = sresize(d->col, d->nodesize, int);
+        d->row = sresize(d->row, d->nodesize, int);
+    }
+
+    for (i = 0; i < n; i++) {
+        int x = first + i, c = cols[i] + 1;
+
+        assert(cols[i] >= 0 && cols[i] < d->ncols);
+        d->col[x] = c;
+        d->row[x] = d->nrows;
+        d->left[x] = (i == 0 ? first + n - 1 : x - 1);
+        d->right[x] = (i == n - 1 ? first : x + 1);
+        d->up[x] = d->up[c];
+        d->down[x] = c;
+        d->down[d->up[c]] = x;
+        d->up[c] = x;
+        d->size[c]++;
+    }
+
+    d->nnodes += n;
+    return d->nrows++;
+}
+
+int dlx_nrows(const dlx *d)
+{
+    return d->nrows;
+}
+
+/*
+ * Remove column c from the header list, and every row with a 1 in
+ * column c from all the other columns it meets.
+ */
+static void cover(dlx *d, int c)
+{
+    int i, j;
+
+    d->right[d->left[c]] = d->right[c];
+    d->left[d->right[c]] = d->left[c];
+    for (i = d->down[c]; i != c; i = d->down[i])
+        for (j = d->right[i]; j != i; j = d->right[j]) {
+            d->down[d->up[j]] = d->down[j];
+            d->up[d->down[j]] = d->up[j];
+            d->size[d->col[j]]--;
+        }
+}
+
+/* Exactly undo cover(d, c). */
+static void uncover(dlx *d, int c)
+{
+    int i, j;
+
+    for (i = d->up[c]; i != c; i = d->up[i])
+        for (j = d->left[i]; j != i; j = d->left[j]) {
+            d->size[d->col[j]]++;
+            d->down[d->up[j]] = j;
+            d->up[d->down[j]] = j;
+        }
+    d->right[d->left[c]] = c;
+    d->left[d->right[c]] = c;
+}
+
+int dlx_solve(dlx *d, int limit)
+{
+    int depth = 0, count = 0;
+    int c, r, j;
+
+    d->nsolution = 0;
+
+    /*
+     * This is the usual recursive search, flattened into a loop so
+     * that it can stop at any depth without unwinding a call stack,
+     * and so that its depth is limited by the chosen[] array rather
+     * than by the C stack.
+     */
+    while (1) {
+        if (d->right[0] == 0) {
+            /* Every primary column is covered: a solution. */
+            if (count++ == 0) {
+                for (j = 0; j < depth; j++)
+                    d->solution[j] = d->row[d->chosen[j]];
+                d->nsolution = depth;
+            }
+            if (limit > 0 && count >= limit)
+                break;
+            goto backtrack;
+        }
+
+        /*
+         * Branch on the live column with fewest rows left in it. A
+         * column with none means this branch is dead; a column with
+         * one isn't really a branch at all, so stop looking.
+         */
+        {
+            int best = 0, bestsize = -1;
+
+            for (c = d->right[0]; c != 0; c = d->right[c])
+                if (bestsize < 0 || d->size[c] < bestsize) {
+                    best = c;
+                    bestsize = d->size[c];
+                    if (bestsize <= 1)
+                        break;
+                }
+            c = best;
+        }
+        if (d->size[c] == 0)
+            goto backtrack;
+
+        cover(d, c);
+        r = d->down[c];
+
+      try_row:
+        if (r == c) {
+            /* Every row in column c has been tried. */
+            uncover(d, c);
+            goto backtrack;
+        }
+        genstat_count(GENSTAT_BACKTRACKS);
+        d->chosen[depth++] = r;
+        for (j = d->right[r]; j != r; j = d->right[j])
+            cover(d, d->col[j]);
+        continue;
+
+      backtrack:
+        if (depth == 0)
+            break;
+        r = d->chosen[--depth];
+        c = d->col[r];
+        for (j = d->left[r]; j != r; j = d->left[j])
+            uncover(d, d->col[j]);
+        r = d->down[r];
+        goto try_row;
+    }
+
+    /*
+     * If we stopped early, put the matrix back the way it was, so
+     * that it can be searched again.
+     */
+    while (depth > 0) {
+        r = d->chosen[--depth];
+        for (j = d->left[r]; j != r; j = d->left[j])
+            uncover(d, d->col[j]);
+        uncover(d, d->col[r]);
+    }
+
+    return count;
+}
+
+int dlx_solution(const dlx *d, int *rows)
+{
+    if (rows)
+        memcpy(rows, d->solution, d->nsolution * sizeof(int));
+    return d->nsolution;
+}
+
+#ifdef DLX_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Reference implementation: try every subset of the rows. Returns
+ * the number of exact covers, with secondary columns allowed to be
+ * covered at most once.
+ */
+static int naive_count(const unsigned char *m, int nrows, int nprimary,
+                       int ncols)
+{
+    unsigned long x, limit = 1UL << nrows;
+    int count = 0, r, c;
+
+    for (x = 0; x < limit; x++) {
+        for (c = 0; c < ncols; c++) {
+            int n = 0;
+            for (r = 0; r < nrows; r++)
+                if ((x & (1UL << r)) && m[r*ncols+c])
+                    n++;
+            if (n > 1 || (n == 0 && c < nprimary))
+                break;
+        }
+        if (c == ncols)
+            count++;
+    }
+    return count;
+}
+
+static bool check_cover(const unsigned char *m, int nprimary, int ncols,
+                        const int *rows, int n)
+{
+    int r, c;
+
+    for (c = 0; c < ncols; c++) {
+        int k = 0;
+        for (r = 0; r < n; r++)
+            if (m[rows[r]*ncols+c])
+                k++;
+        if (k > 1 || (k == 0 && c < nprimary))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Build the exact cover problem for an order-n*n Sudoku, with a
+ * row for each (square, digit) pair that the givens leave possible.
+ * Columns are: each square filled; each digit once in each row,
+ * column and block.
+ */
+static dlx *sudoku_dlx(int n, const unsigned char *givens, int **rowdesc)
+{
+    int cr = n*n, area = cr*cr;
+    dlx *d = dlx_new(4*area, 0);
+    int x, y, v, cols[4];
+
+    *rowdesc = snewn(area*cr, int);
+    for (y = 0; y < cr; y++)
+        for (x = 0; x < cr; x++)
+            for (v = 0; v < cr; v++) {
+                int b = (y/n)*n + x/n;
+                if (givens[y*cr+x] && givens[y*cr+x] != v+1)
+                    continue;
+                cols[0] = y*cr+x;
+                cols[1] = area + y*cr+v;
+                cols[2] = 2*area + x*cr+v;
+                cols[3] = 3*area + b*cr+v;
+                (*rowdesc)[dlx_add_row(d, cols, 4)] = (y*cr+x)*cr+v;
+            }
+    return d;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed;
+    int iteration;
+
+    seed = (argc > 1 ? strtoul(argv[1], NULL, 0) : time(NULL));
+    printf("Random seed = %u\n", seed);
+    srand(seed);
+
+    /*
+     * Small random matrices, checked exhaustively. Solving each one
+     * twice checks that stopping early leaves the links intact. Every
+     * row meets a primary column, since a row that doesn't is never
+     * chosen (as documented), whereas naive_count would count covers
+     * with and without it.
+     */
+    for (iteration = 0; iteration < 5000; iteration++) {
+        int nrows = 1 + rand() % 14, nprimary = 1 + rand() % 8;
+        int ncols = nprimary + rand() % 3, density = 2 + rand() % 3;
+        unsigned char m[14*10];
+        int cols[10], sol[10];
+        int r, c, k, n, got, expected;
+        dlx *d;
+
+        d = dlx_new(nprimary, ncols - nprimary);
+        for (r = 0; r < nrows; r++) {
+            do {
+                for (c = k = 0; c < ncols; c++)
+                    if ((m[r*ncols+c] = (rand() % density == 0)) != 0)
+                        cols[k++] = c;
+            } while (k == 0 || cols[0] >= nprimary);
+            dlx_add_row(d, cols, k);
+        }
+        expected = naive_count(m, nrows, nprimary, ncols);
+
+        got = dlx_solve(d, 2);
+        n = dlx_solution(d, sol);
+        if (got != (expected < 2 ? expected : 2) ||
+            (got > 0 && !check_cover(m, nprimary, ncols, sol, n))) {
+            printf("Failed at iteration %d (%dx%d): limited count %d, "
+                   "expected %d\n", iteration, nrows, ncols, got, expected);
+            return 1;
+        }
+        got = dlx_solve(d, 0);
+        if (got != expected) {
+            printf("Failed at iteration %d (%dx%d): count %d, "
+                   "expected %d\n", iteration, nrows, ncols, got, expected);
+            return 1;
+        }
+        dlx_free(d);
+    }
+
+    /*
+     * Sudoku, for timing: an empty 4x4-block grid (solved by
+     * filling in the first solution found), and a hard 3x3 puzzle
+     * with a unique solution, proved unique by counting to 2.
+     */
+    {
+        static const char hard[] =
+            "8........"
+            "..36....."
+            ".7..9.2.."
+            ".5...7..."
+            "....457.."
+            "...1...3."
+            "..1....68"
+            "..85...1."
+            ".9....4..";
+        unsigned char givens[256];
+        int *rowdesc, sol[1024];
+        int i, n;
+        clock_t start;
+        dlx *d;
+
+        memset(givens, 0, sizeof(givens));
+        d = sudoku_dlx(4, givens, &rowdesc);
+        start = clock();
+        if (dlx_solve(d, 1) != 1 || dlx_solution(d, sol) != 256) {
+            printf("Failed to fill an empty 16x16 grid\n");
+            return 1;
+        }
+        printf("Empty 16x16 grid filled in %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+        dlx_free(d);
+        sfree(rowdesc);
+
+        for (i = 0; i < 81; i++)
+            givens[i] = (hard[i] == '.' ? 0 : hard[i] - '0');
+        d = sudoku_dlx(3, givens, &rowdesc);
+        start = clock();
+        for (i = 0; i < 100; i++)
+            if (dlx_solve(d, 2) != 1) {
+                printf("Hard 9x9 puzzle not found unique\n");
+                return 1;
+            }
+        printf("Hard 9x9 puzzle proved unique 100 times in %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+        n = dlx_solution(d, sol);
+        for (i = 0; i < n; i++)
+            givens[rowdesc[sol[i]] / 9] = rowdesc[sol[i]] % 9 + 1;
+        for (i = 0; i < 81; i++)
+            putchar('0' + givens[i]);
+        putchar('\n');
+        dlx_free(d);
+        sfree(rowdesc);
+    }
+
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* DLX_TEST */
@@ -190,3 +190,412 @@ void edsf_merge(int *dsf, int v1, int v2, bool inverse)
 
 /*    fprintf(stderr, "dsf[%2d] = %2d\n", v2, dsf[v2]); */
 }
+
+/*
+ * The 'rdsf': a second disjoint set forest implementation, in which
+ * the links and the class sizes live in separate flat arrays and
+ * merges are done by union by rank rather than by always making the
+ * smaller index the root. That keeps the trees logarithmically
+ * shallow without depending on path compression, which means
+ * compression can be turned off in exchange for the ability to undo
+ * merges cheaply, by replaying a log of them backwards.
+ *
+ * Since the root of a class is no longer its smallest element, the
+ * smallest element is maintained separately for callers that want a
+ * deterministic representative of each class.
+ */
+
+struct rdsf_undo {
+    int child;                         /* root that was made a child */
+    int oldmin;                        /* previous minimum of new root */
+    bool rankinc;                      /* whether new root's rank went up */
+};
+
+/*
+ * Each element's link word holds its parent index shifted left by one,
+ * with the bottom bit saying whether it's inverse to that parent, so
+ * that walking up a tree touches only one array. A root is its own
+ * parent, and never inverse to itself.
+ */
+#define LINK(parent, inverse) (((parent) << 1) | (inverse))
+#define PARENT(link) ((link) >> 1)
+#define INVERSE(link) ((link) & 1)
+
+/*
+ * Things we only need to know about the root of each tree are kept
+ * together, so that a merge looks at one record per class.
+ */
+struct rdsf_root {
+    int size;
+    int min;                           /* minimal element of the class */
+    int rank;
+};
+
+struct rdsf {
+    int size;
+    int *link;
+    struct rdsf_root *root;            /* valid only at roots */
+
+    /*
+     * If the forest is undoable, every merge is recorded here, and
+     * canonify never alters the shape of the trees (since otherwise
+     * undoing a merge would have to undo the compression of every
+     * path through the subtree it attached).
+     */
+    bool undoable;
+    struct rdsf_undo *log;
+    int nlog, logsize;
+};
+
+rdsf *rdsf_new(int size, bool undoable)
+{
+    rdsf *d = snew(rdsf);
+
+    d->size = size;
+    d->link = snewn(size, int);
+    d->root = snewn(size, struct rdsf_root);
+    d->undoable = undoable;
+    d->log = NULL;
+    d->nlog = d->logsize = 0;
+    rdsf_reset(d);
+
+    return d;
+}
+
+void rdsf_free(rdsf *d)
+{
+    if (!d)
+        return;
+    sfree(d->link);
+    sfree(d->root);
+    sfree(d->log);
+    sfree(d);
+}
+
+void rdsf_reset(rdsf *d)
+{
+    int i;
+
+    for (i = 0; i < d->size; i++) {
+        d->link[i] = LINK(i, 0);
+        d->root[i].size = 1;
+        d->root[i].min = i;
+        d->root[i].rank = 0;
+    }
+    d->nlog = 0;
+}
+
+int erdsf_canonify(rdsf *d, int index, bool *inverse_return)
+{
+    int *link = d->link;
+    bool inverse = false;
+
+    assert(index >= 0 && index < d->size);
+
+    if (d->undoable) {
+        while (PARENT(link[index]) != index) {
+            inverse ^= INVERSE(link[index]);
+            index = PARENT(link[index]);
+        }
+    } else {
+        /*
+         * Path halving: point each element we pass at its
+         * grandparent, so that the path is about half as long next
+         * time round. Unlike full compression this needs only the
+         * one pass up the tree.
+         */
+        while (PARENT(link[index]) != index) {
+            int p = PARENT(link[index]);
+            if (PARENT(link[p]) != p)
+                link[index] = link[p] ^ INVERSE(link[index]);
+            inverse ^= INVERSE(link[index]);
+            index = PARENT(link[index]);
+        }
+    }
+
+    if (inverse_return)
+        *inverse_return = inverse;
+    return index;
+}
+
+int rdsf_canonify(rdsf *d, int index)
+{
+    return erdsf_canonify(d, index, NULL);
+}
+
+void erdsf_merge(rdsf *d, int v1, int v2, bool inverse)
+{
+    struct rdsf_root *r1, *r2;
+    bool i1, i2;
+
+    v1 = erdsf_canonify(d, v1, &i1);
+    v2 = erdsf_canonify(d, v2, &i2);
+    inverse ^= i1 ^ i2;
+
+    if (v1 == v2) {
+        assert(!inverse);
+        return;
+    }
+
+    /* Hang the lower-ranked tree off the root of the other. */
+    if (d->root[v1].rank < d->root[v2].rank) {
+        int v3 = v1;
+        v1 = v2;
+        v2 = v3;
+    }
+    r1 = &d->root[v1];
+    r2 = &d->root[v2];
+
+    if (d->undoable) {
+        struct rdsf_undo *u;
+        if (d->nlog >= d->logsize) {
+            d->logsize = d->nlog * 5 / 4 + 64;
+            d->log = sresize(d->log, d->logsize, struct rdsf_undo);
+        }
+        u = &d->log[d->nlog++];
+        u->child = v2;
+        u->oldmin = r1->min;
+        u->rankinc = (r1->rank == r2->rank);
+    }
+
+    d->link[v2] = LINK(v1, inverse);
+    r1->size += r2->size;
+    if (r2->min < r1->min)
+        r1->min = r2->min;
+    if (r1->rank == r2->rank)
+        r1->rank++;
+}
+
+void rdsf_merge(rdsf *d, int v1, int v2)
+{
+    erdsf_merge(d, v1, v2, false);
+}
+
+int rdsf_size(rdsf *d, int index)
+{
+    return d->root[rdsf_canonify(d, index)].size;
+}
+
+int rdsf_minimal(rdsf *d, int index)
+{
+    return d->root[rdsf_canonify(d, index)].min;
+}
+
+int rdsf_checkpoint(rdsf *d)
+{
+    assert(d->undoable);
+    return d->nlog;
+}
+
+void rdsf_rollback(rdsf *d, int checkpoint)
+{
+    assert(d->undoable);
+    assert(checkpoint >= 0 && checkpoint <= d->nlog);
+
+    while (d->nlog > checkpoint) {
+        struct rdsf_undo *u = &d->log[--d->nlog];
+        int child = u->child, root = PARENT(d->link[child]);
+
+        d->root[root].size -= d->root[child].size;
+        d->root[root].min = u->oldmin;
+        if (u->rankinc)
+            d->root[root].rank--;
+        d->link[child] = LINK(child, 0);
+    }
+}
+
+#ifdef DSF_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Check that an rdsf describes the same partition as a dsf, with the
+ * same parity relations and with each class's minimal element being
+ * the dsf's canonical one.
+ */
+static bool compare(int *dsf, rdsf *d, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        bool iold, inew, iroot;
+        int c = edsf_canonify(dsf, i, &iold);
+        int r = erdsf_canonify(d, i, &inew);
+
+        if (rdsf_minimal(d, i) != c || rdsf_size(d, i) != dsf_size(dsf, i) ||
+            erdsf_canonify(d, c, &iroot) != r || (inew ^ iroot) != iold) {
+            printf("Mismatch at element %d\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Merge two random elements in both structures, choosing the parity
+ * at random if they're not already in the same class.
+ */
+static void random_merge(int *dsf, rdsf *d, int n)
+{
+    int a = rand() % n, b = rand() % n;
+    bool ia, ib, inverse;
+
+    if (edsf_canonify(dsf, a, &ia) == edsf_canonify(dsf, b, &ib))
+        inverse = ia ^ ib;
+    else
+        inverse = (rand() >> 12) & 1;
+    edsf_merge(dsf, a, b, inverse);
+    erdsf_merge(d, a, b, inverse);
+}
+
+static double bench(int *dsf, rdsf *d, int n, int nops)
+{
+    clock_t start = clock();
+    int i, a, b, dummy = 0;
+
+    srand(1);
+    for (i = 0; i < nops; i++) {
+        a = rand() % n;
+        b = rand() % n;
+        if (dsf) {
+            if (i % 4 == 0)
+                dsf_merge(dsf, a, b);
+            else
+                dummy += (dsf_canonify(dsf, a) == dsf_canonify(dsf, b));
+        } else {
+            if (i % 4 == 0)
+                rdsf_merge(d, a, b);
+            else
+                dummy += (rdsf_canonify(d, a) == rdsf_canonify(d, b));
+        }
+    }
+    if (dummy < 0)
+        printf("(%d)\n", dummy);       /* stop the work being optimised out */
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed;
+    int iteration;
+
+    seed = (argc > 1 ? strtoul(argv[1], NULL, 0) : time(NULL));
+    printf("Random seed = %u\n", seed);
+    srand(seed);
+
+    /*
+     * Random sequences of merges, with and without undo, checked
+     * against the original implementation throughout. In the undoable
+     * case we also roll back to random earlier points, and compare
+     * against a copy of the dsf taken at the time.
+     */
+    for (iteration = 0; iteration < 2000; iteration++) {
+        int n = 1 + rand() % 60, nops = rand() % (2 * n + 1);
+        bool undoable = iteration % 2;
+        int *dsf = snew_dsf(n), *saved = snewn(n, int);
+        rdsf *d = rdsf_new(n, undoable);
+        int i, checkpoint = -1;
+
+        for (i = 0; i < nops; i++) {
+            if (undoable && rand() % 8 == 0) {
+                if (checkpoint < 0) {
+                    checkpoint = rdsf_checkpoint(d);
+                    memcpy(saved, dsf, n * sizeof(int));
+                } else {
+                    rdsf_rollback(d, checkpoint);
+                    memcpy(dsf, saved, n * sizeof(int));
+                    checkpoint = -1;
+                }
+            } else {
+                random_merge(dsf, d, n);
+            }
+            if (!compare(dsf, d, n)) {
+                printf("Failed at iteration %d, step %d\n", iteration, i);
+                return 1;
+            }
+        }
+
+        sfree(dsf);
+        sfree(saved);
+        rdsf_free(d);
+    }
+
+    /*
+     * Timings: a million elements, with one merge for every three
+     * pairs of lookups.
+     */
+    {
+        int n = 1 << 20, nops = 4 * n;
+        int *dsf = snew_dsf(n);
+        rdsf *d = rdsf_new(n, false), *du = rdsf_new(n, true);
+
+        printf("dsf:               %.3f s\n", bench(dsf, NULL, n, nops));
+        printf("rdsf:              %.3f s\n", bench(NULL, d, n, nops));
+        printf("rdsf (undoable):   %.3f s\n", bench(NULL, du, n, nops));
+
+        sfree(dsf);
+        rdsf_free(d);
+        rdsf_free(du);
+    }
+
+    /*
+     * The pattern rollback is meant for: a board-sized forest, in
+     * which a solver tries a few merges and then takes them back,
+     * compared with saving and restoring a copy of a plain dsf.
+     */
+    {
+        int n = 900, ntrials = 200000, nmerges = 4;
+        int *dsf = snew_dsf(n), *saved = snewn(n, int);
+        rdsf *d = rdsf_new(n, true);
+        int *pairs = snewn(2 * nmerges * ntrials, int);
+        int i, j;
+        clock_t start;
+
+        for (i = 0; i < n / 2; i++) {
+            int a = rand() % n, b = rand() % n;
+            dsf_merge(dsf, a, b);
+            rdsf_merge(d, a, b);
+        }
+        for (i = 0; i < 2 * nmerges * ntrials; i++)
+            pairs[i] = rand() % n;
+
+        start = clock();
+        for (i = 0; i < ntrials; i++) {
+            memcpy(saved, dsf, n * sizeof(int));
+            for (j = 0; j < nmerges; j++)
+                dsf_merge(dsf, pairs[2*(i*nmerges+j)],
+                          pairs[2*(i*nmerges+j)+1]);
+            memcpy(dsf, saved, n * sizeof(int));
+        }
+        printf("dsf, copied:       %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+
+        start = clock();
+        for (i = 0; i < ntrials; i++) {
+            int checkpoint = rdsf_checkpoint(d);
+            for (j = 0; j < nmerges; j++)
+                rdsf_merge(d, pairs[2*(i*nmerges+j)],
+                           pairs[2*(i*nmerges+j)+1]);
+            rdsf_rollback(d, checkpoint);
+        }
+        printf("rdsf, rolled back: %.3f s\n",
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+
+        if (!compare(dsf, d, n)) {
+            printf("Failed after rollback timing\n");
+            return 1;
+        }
+
+        sfree(dsf);
+        sfree(saved);
+        sfree(pairs);
+        rdsf_free(d);
+    }
+
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* DSF_TEST */
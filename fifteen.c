@@ -700,13 +700,9 @@ static char *interpret_move(const game_state *state, game_ui *ui,
         if (nx < 0 || nx >= state->w || ny < 0 || ny >= state->h)
             return NULL;               /* out of bounds */
     } else if (IS_CURSOR_MOVE(button)) {
-        static int invert_cursor = -1;
-        if (invert_cursor == -1) {
-            char *env = getenv("FIFTEEN_INVERT_CURSOR");
-            invert_cursor = (env && (env[0] == 'y' || env[0] == 'Y'));
-        }
+        char *env = getenv("FIFTEEN_INVERT_CURSOR");
         button = flip_cursor(button); /* the default */
-        if (invert_cursor)
+        if (env && (env[0] == 'y' || env[0] == 'Y'))
             button = flip_cursor(button); /* undoes the first flip */
 	move_cursor(button, &nx, &ny, state->w, state->h, false);
     } else if ((button == 'h' || button == 'H') && !state->completed) {
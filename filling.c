@@ -1285,13 +1285,9 @@ static const char *validate_desc(const game_params *params, const char *desc)
     for (area = 0; *desc; ++desc) {
 	if (*desc >= 'a' && *desc <= 'z') area += *desc - 'a' + 1;
 	else if (*desc >= '0' && *desc <= m) ++area;
-	else {
-	    static char s[] =  "Invalid character '%""' in game description";
-	    int n = sprintf(s, "Invalid character '%1c' in game description",
-			    *desc);
-	    assert(n + 1 <= lenof(s)); /* +1 for the terminating NUL */
-	    return s;
-	}
+	else if (*desc > m && *desc <= '9')
+	    return "Number too large for grid in game description";
+	else return "Invalid character in game description";
 	if (area > sz) return "Too much data to fit in grid";
     }
     return (area < sz) ? "Not enough data to fill grid" : NULL;
@@ -0,0 +1,52 @@
+/*
+ * genstats.c: counters that puzzle generators can bump to report how
+ * much work it took them to produce a puzzle.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "puzzles.h"
+
+/*
+ * The counters being collected are found via a per-thread pointer
+ * rather than being passed down through new_desc(), so that deeply
+ * nested generator and solver code can report into them without
+ * every function in between growing an extra parameter. It has to be
+ * per-thread because the Unix bulk generation mode runs several
+ * midends at once on separate threads.
+ */
+
+static THREAD_LOCAL struct genstats *current_genstats;
+
+struct genstats *genstats_collect(struct genstats *gs)
+{
+    struct genstats *prev = current_genstats;
+    current_genstats = gs;
+    return prev;
+}
+
+void genstats_reset(struct genstats *gs)
+{
+    int i;
+
+    for (i = 0; i < GENSTAT_N; i++)
+        gs->count[i] = 0;
+}
+
+void genstat_add(int which, unsigned long n)
+{
+    assert(which >= 0 && which < GENSTAT_N);
+    if (current_genstats)
+        current_genstats->count[which] += n;
+}
+
+const char *genstat_name(int which)
+{
+    static const char *const names[GENSTAT_N] = {
+        "attempts", "solves", "backtracks",
+        "rej_ambiguous", "rej_toohard", "rej_tooeasy", "rej_other",
+    };
+    assert(which >= 0 && which < GENSTAT_N);
+    return names[which];
+}
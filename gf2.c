@@ -0,0 +1,408 @@
+/*
+ * gf2.c: linear algebra over GF(2), for puzzles whose rules boil
+ * down to parity constraints (such as Flip, where pressing a square
+ * toggles a fixed set of lights, so the question of which squares to
+ * press is a set of simultaneous equations mod 2).
+ *
+ * Matrices are stored with each row packed into machine words, so
+ * that the row operations making up Gaussian elimination handle a
+ * whole word's worth of columns per instruction. The loops doing
+ * that are kept simple enough that a vectorising compiler can turn
+ * them into SIMD code of its own accord.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "puzzles.h"
+
+#if __STDC_VERSION__ >= 199901L
+typedef uint64_t gf2_word;
+#else
+typedef unsigned long gf2_word;
+#endif
+#define WORD_BITS (sizeof(gf2_word) * CHAR_BIT)
+#define WORDS_FOR(n) (((n) + WORD_BITS - 1) / WORD_BITS)
+#define BIT(c) ((gf2_word)1 << ((c) % WORD_BITS))
+
+struct gf2_matrix {
+    int rows, cols;
+    int stride;                        /* words per row */
+    gf2_word *data;
+};
+
+#define ROW(m, r) ((m)->data + (size_t)(r) * (m)->stride)
+
+static int popcount(gf2_word w)
+{
+#if defined __GNUC__
+    return __builtin_popcountll(w);
+#else
+    int n = 0;
+    while (w) {
+        w &= w - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+gf2_matrix *gf2_matrix_new(int rows, int cols)
+{
+    gf2_matrix *m = snew(gf2_matrix);
+
+    assert(rows >= 0 && cols >= 0);
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = WORDS_FOR(cols);
+    m->data = snewn((size_t)rows * m->stride + 1, gf2_word);
+    memset(m->data, 0, (size_t)rows * m->stride * sizeof(gf2_word));
+    return m;
+}
+
+void gf2_matrix_free(gf2_matrix *m)
+{
+    if (!m)
+        return;
+    sfree(m->data);
+    sfree(m);
+}
+
+bool gf2_get(const gf2_matrix *m, int row, int col)
+{
+    assert(row >= 0 && row < m->rows && col >= 0 && col < m->cols);
+    return (ROW(m, row)[col / WORD_BITS] & BIT(col)) != 0;
+}
+
+void gf2_set(gf2_matrix *m, int row, int col, bool value)
+{
+    gf2_word *w;
+
+    assert(row >= 0 && row < m->rows && col >= 0 && col < m->cols);
+    w = &ROW(m, row)[col / WORD_BITS];
+    if (value)
+        *w |= BIT(col);
+    else
+        *w &= ~BIT(col);
+}
+
+/*
+ * XOR row 'src' into row 'dst', ignoring the first 'from' words
+ * (which the caller knows to be zero in src).
+ */
+static void row_xor(gf2_word *dst, const gf2_word *src, int from, int to)
+{
+    int i;
+    for (i = from; i < to; i++)
+        dst[i] ^= src[i];
+}
+
+int gf2_reduce(gf2_matrix *m, int ncols, int *pivots)
+{
+    int rank = 0, col, r;
+
+    assert(ncols <= m->cols);
+
+    for (col = 0; col < ncols && rank < m->rows; col++) {
+        int wi = col / WORD_BITS;
+        gf2_word bit = BIT(col);
+        gf2_word *prow;
+
+        /*
+         * Find a row at or below 'rank' with a 1 in this column. All
+         * such rows are zero in every column to the left, so from
+         * here on we need only look at words from wi onwards.
+         */
+        for (r = rank; r < m->rows; r++)
+            if (ROW(m, r)[wi] & bit)
+                break;
+        if (r == m->rows)
+            continue;                  /* no pivot: a free column */
+
+        prow = ROW(m, rank);
+        if (r != rank) {
+            gf2_word *other = ROW(m, r);
+            int i;
+            for (i = wi; i < m->stride; i++) {
+                gf2_word t = prow[i];
+                prow[i] = other[i];
+                other[i] = t;
+            }
+        }
+
+        /*
+         * Clear this column in every other row, above as well as
+         * below, so that we end up in reduced row echelon form.
+         */
+        for (r = 0; r < m->rows; r++)
+            if (r != rank && (ROW(m, r)[wi] & bit))
+                row_xor(ROW(m, r), prow, wi, m->stride);
+
+        if (pivots)
+            pivots[rank] = col;
+        rank++;
+    }
+
+    return rank;
+}
+
+int gf2_solve_min(gf2_matrix *m, int n, unsigned char *x)
+{
+    int *pivots, *freecols;
+    unsigned char *counter;
+    gf2_word *sol, *best, *kernel;
+    int nw = WORDS_FOR(n);
+    int rank, nfree, r, i, j, weight, bestweight;
+    bool *ispivot;
+
+    assert(n < m->cols);
+
+    pivots = snewn(m->rows + 1, int);
+    rank = gf2_reduce(m, n, pivots);
+
+    /*
+     * Any remaining row now has nothing left of the right-hand side
+     * column, so reads 0 = (its last entry). If that's 1, there's no
+     * solution.
+     */
+    for (r = rank; r < m->rows; r++)
+        if (gf2_get(m, r, n)) {
+            sfree(pivots);
+            return -1;
+        }
+
+    /*
+     * The columns with no pivot are the free variables. Setting them
+     * all to zero gives a particular solution; setting each one on
+     * its own to 1 (and the right-hand side to zero) gives a basis
+     * for the kernel.
+     */
+    ispivot = snewn(n + 1, bool);
+    for (i = 0; i < n; i++)
+        ispivot[i] = false;
+    for (r = 0; r < rank; r++)
+        ispivot[pivots[r]] = true;
+    freecols = snewn(n + 1, int);
+    nfree = 0;
+    for (i = 0; i < n; i++)
+        if (!ispivot[i])
+            freecols[nfree++] = i;
+
+    sol = snewn(nw + 1, gf2_word);
+    best = snewn(nw + 1, gf2_word);
+    kernel = snewn((size_t)nfree * nw + 1, gf2_word);
+    memset(sol, 0, nw * sizeof(gf2_word));
+    memset(kernel, 0, (size_t)nfree * nw * sizeof(gf2_word));
+    for (r = 0; r < rank; r++)
+        if (gf2_get(m, r, n))
+            sol[pivots[r] / WORD_BITS] |= BIT(pivots[r]);
+    for (j = 0; j < nfree; j++) {
+        gf2_word *k = kernel + (size_t)j * nw;
+        int f = freecols[j];
+        k[f / WORD_BITS] |= BIT(f);
+        for (r = 0; r < rank; r++)
+            if (gf2_get(m, r, f))
+                k[pivots[r] / WORD_BITS] |= BIT(pivots[r]);
+    }
+
+    /*
+     * Enumerate every solution, looking for the one with fewest 1s.
+     * We step through the combinations of kernel vectors in Gray
+     * code order, so that each step XORs in just one of them: the
+     * vector to toggle is the one whose bit becomes set when the
+     * binary counter is incremented.
+     */
+    memcpy(best, sol, nw * sizeof(gf2_word));
+    bestweight = 0;
+    for (i = 0; i < nw; i++)
+        bestweight += popcount(sol[i]);
+    weight = bestweight;
+
+    counter = snewn(nfree + 1, unsigned char);
+    memset(counter, 0, nfree + 1);
+    while (1) {
+        for (j = 0; j < nfree && counter[j]; j++)
+            counter[j] = 0;
+        if (j == nfree)
+            break;                     /* wrapped round: all done */
+        counter[j] = 1;
+
+        weight = 0;
+        for (i = 0; i < nw; i++) {
+            sol[i] ^= kernel[(size_t)j * nw + i];
+            weight += popcount(sol[i]);
+        }
+        if (weight < bestweight) {
+            bestweight = weight;
+            memcpy(best, sol, nw * sizeof(gf2_word));
+        }
+    }
+
+    for (i = 0; i < n; i++)
+        x[i] = (best[i / WORD_BITS] & BIT(i)) != 0;
+
+    sfree(counter);
+    sfree(kernel);
+    sfree(best);
+    sfree(sol);
+    sfree(freecols);
+    sfree(ispivot);
+    sfree(pivots);
+
+    return bestweight;
+}
+
+#ifdef GF2_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Reference implementation: plain bytewise Gaussian elimination,
+ * followed by exhaustive search for the lightest solution. Returns
+ * the weight of the lightest solution, or -1 if there is none.
+ */
+static int naive_min_weight(const unsigned char *a, const unsigned char *b,
+                            int rows, int n)
+{
+    unsigned long x, limit = 1UL << n;
+    int best = -1, r, c;
+
+    for (x = 0; x < limit; x++) {
+        int weight = 0;
+        for (r = 0; r < rows; r++) {
+            int v = 0;
+            for (c = 0; c < n; c++)
+                if (a[r*n+c] && (x & (1UL << c)))
+                    v ^= 1;
+            if (v != b[r])
+                break;
+        }
+        if (r < rows)
+            continue;
+        for (c = 0; c < n; c++)
+            if (x & (1UL << c))
+                weight++;
+        if (best < 0 || weight < best)
+            best = weight;
+    }
+    return best;
+}
+
+static bool check_solution(const unsigned char *a, const unsigned char *b,
+                           const unsigned char *x, int rows, int n)
+{
+    int r, c;
+
+    for (r = 0; r < rows; r++) {
+        int v = 0;
+        for (c = 0; c < n; c++)
+            v ^= a[r*n+c] & x[c];
+        if (v != b[r])
+            return false;
+    }
+    return true;
+}
+
+static gf2_matrix *make_matrix(const unsigned char *a, const unsigned char *b,
+                               int rows, int n)
+{
+    gf2_matrix *m = gf2_matrix_new(rows, n + 1);
+    int r, c;
+
+    for (r = 0; r < rows; r++) {
+        for (c = 0; c < n; c++)
+            gf2_set(m, r, c, a[r*n+c]);
+        gf2_set(m, r, n, b[r]);
+    }
+    return m;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed;
+    int iteration;
+    clock_t start;
+
+    seed = (argc > 1 ? strtoul(argv[1], NULL, 0) : time(NULL));
+    printf("Random seed = %u\n", seed);
+    srand(seed);
+
+    /*
+     * Small random systems, checked exhaustively. Sparse ones are
+     * included so that plenty are singular, with several free
+     * variables.
+     */
+    for (iteration = 0; iteration < 5000; iteration++) {
+        int n = 1 + rand() % 10, rows = 1 + rand() % 12;
+        int density = 1 + rand() % 4;
+        unsigned char a[12*10], b[12], x[10];
+        gf2_matrix *m;
+        int i, got, expected;
+
+        for (i = 0; i < rows*n; i++)
+            a[i] = (rand() % density == 0);
+        for (i = 0; i < rows; i++)
+            b[i] = rand() & 1;
+
+        m = make_matrix(a, b, rows, n);
+        got = gf2_solve_min(m, n, x);
+        gf2_matrix_free(m);
+        expected = naive_min_weight(a, b, rows, n);
+
+        if (got != expected ||
+            (got >= 0 && !check_solution(a, b, x, rows, n))) {
+            printf("Failed at iteration %d (%dx%d): weight %d, "
+                   "expected %d\n", iteration, rows, n, got, expected);
+            return 1;
+        }
+    }
+
+    /*
+     * A large system, the size of the one for a 30x30 Flip, for
+     * timing purposes. It's built to have a known solution. (We take
+     * a high bit from rand(), because in some C libraries the lowest
+     * bit is itself a linear recurrence mod 2, which would give us a
+     * matrix of very low rank and an astronomical number of
+     * solutions to search.)
+     */
+    {
+        int n = 900, i, j;
+        unsigned char *a = snewn(n * n, unsigned char);
+        unsigned char *b = snewn(n, unsigned char);
+        unsigned char *x = snewn(n, unsigned char);
+        unsigned char *x0 = snewn(n, unsigned char);
+        gf2_matrix *m;
+
+        for (i = 0; i < n*n; i++)
+            a[i] = (rand() >> 12) & 1;
+        for (i = 0; i < n; i++)
+            x0[i] = (rand() >> 12) & 1;
+        for (i = 0; i < n; i++) {
+            b[i] = 0;
+            for (j = 0; j < n; j++)
+                b[i] ^= a[i*n+j] & x0[j];
+        }
+
+        m = make_matrix(a, b, n, n);
+        start = clock();
+        if (gf2_solve_min(m, n, x) < 0 || !check_solution(a, b, x, n, n)) {
+            printf("Failed on %dx%d system\n", n, n);
+            return 1;
+        }
+        printf("%dx%d system solved in %.3f s\n", n, n,
+               (double)(clock() - start) / CLOCKS_PER_SEC);
+        gf2_matrix_free(m);
+        sfree(a);
+        sfree(b);
+        sfree(x);
+        sfree(x0);
+    }
+
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* GF2_TEST */
@@ -15,7 +15,7 @@
 #include <float.h>
 
 #include "puzzles.h"
-#include "tree234.h"
+#include "btree.h"
 #include "grid.h"
 #include "penrose.h"
 
@@ -46,6 +46,16 @@ void grid_free(grid *g)
         sfree(g->faces);
         sfree(g->edges);
         sfree(g->dots);
+        sfree(g->face_start);
+        sfree(g->face_edges);
+        sfree(g->face_dots);
+        sfree(g->dot_start);
+        sfree(g->dot_edges);
+        sfree(g->dot_faces);
+        sfree(g->edge_dots);
+        sfree(g->edge_faces);
+        sfree(g->bucket_start);
+        sfree(g->bucket_edges);
         sfree(g);
     }
 }
@@ -59,6 +69,12 @@ static grid *grid_empty(void)
     g->edges = NULL;
     g->dots = NULL;
     g->num_faces = g->num_edges = g->num_dots = 0;
+    g->face_start = g->face_edges = g->face_dots = NULL;
+    g->dot_start = g->dot_edges = g->dot_faces = NULL;
+    g->edge_dots = g->edge_faces = NULL;
+    g->bucket_start = g->bucket_edges = NULL;
+    g->bucket_size = g->bucket_w = g->bucket_h = 0;
+    g->bucket_x0 = g->bucket_y0 = 0;
     g->refcount = 1;
     g->lowest_x = g->lowest_y = g->highest_x = g->highest_y = 0;
     return g;
@@ -111,12 +127,25 @@ grid_edge *grid_nearest_edge(grid *g, int x, int y)
 {
     grid_edge *best_edge;
     double best_distance = 0;
-    int i;
+    int bx, by, b, i;
 
     best_edge = NULL;
 
-    for (i = 0; i < g->num_edges; i++) {
-        grid_edge *e = &g->edges[i];
+    /*
+     * Only the edges listed in the bucket containing (x,y) can pass
+     * the tests below. They're listed in index order, so ties are
+     * broken just as they would be by scanning every edge.
+     */
+    if (x < g->bucket_x0 || y < g->bucket_y0)
+        return NULL;
+    bx = (x - g->bucket_x0) / g->bucket_size;
+    by = (y - g->bucket_y0) / g->bucket_size;
+    if (bx >= g->bucket_w || by >= g->bucket_h)
+        return NULL;
+    b = by * g->bucket_w + bx;
+
+    for (i = g->bucket_start[b]; i < g->bucket_start[b+1]; i++) {
+        grid_edge *e = &g->edges[g->bucket_edges[i]];
         long e2; /* squared length of edge */
         long a2, b2; /* squared lengths of other sides */
         double dist;
@@ -504,7 +533,7 @@ static void grid_trim_vigorously(grid *g)
 static void grid_make_consistent(grid *g)
 {
     int i;
-    tree234 *incomplete_edges;
+    btree *incomplete_edges;
     grid_edge *next_new_edge; /* Where new edge will go into g->edges */
 
     grid_debug_basic(g);
@@ -528,7 +557,7 @@ static void grid_make_consistent(grid *g)
      * know the other face.
      * For efficiency, maintain a list of the incomplete edges, sorted by
      * their dots. */
-    incomplete_edges = newtree234(grid_edge_bydots_cmpfn);
+    incomplete_edges = btree_new(grid_edge_bydots_cmpfn);
     for (i = 0; i < g->num_faces; i++) {
         grid_face *f = g->faces + i;
         int j;
@@ -540,9 +569,9 @@ static void grid_make_consistent(grid *g)
                 j2 = 0;
             e.dot1 = f->dots[j];
             e.dot2 = f->dots[j2];
-            /* Use del234 instead of find234, because we always want to
-             * remove the edge if found */
-            edge_found = del234(incomplete_edges, &e);
+            /* Use btree_del instead of btree_find, because we always
+             * want to remove the edge if found */
+            edge_found = btree_del(incomplete_edges, &e);
             if (edge_found) {
                 /* This edge already added, so fill out missing face.
                  * Edge is already removed from incomplete_edges. */
@@ -553,12 +582,12 @@ static void grid_make_consistent(grid *g)
                 next_new_edge->dot2 = e.dot2;
                 next_new_edge->face1 = f;
                 next_new_edge->face2 = NULL; /* potentially infinite face */
-                add234(incomplete_edges, next_new_edge);
+                btree_add(incomplete_edges, next_new_edge);
                 ++next_new_edge;
             }
         }
     }
-    freetree234(incomplete_edges);
+    btree_free(incomplete_edges);
     
     /* ====== Stage 2 ======
      * For each face, build its edge list.
@@ -792,7 +821,7 @@ static void grid_make_consistent(grid *g)
 /* Helpers for making grid-generation easier.  These functions are only
  * intended for use during grid generation. */
 
-/* Comparison function for the (tree234) sorted dot list */
+/* Comparison function for the (btree) sorted dot list */
 static int grid_point_cmp_fn(void *v1, void *v2)
 {
     grid_dot *p1 = v1;
@@ -832,7 +861,7 @@ static grid_dot *grid_dot_add_new(grid *g, int x, int y)
  * in the dot_list, or add a new dot to the grid (and the dot_list) and
  * return that.
  * Assumes g->dots has enough capacity allocated */
-static grid_dot *grid_get_dot(grid *g, tree234 *dot_list, int x, int y)
+static grid_dot *grid_get_dot(grid *g, btree *dot_list, int x, int y)
 {
     grid_dot test, *ret;
 
@@ -841,12 +870,12 @@ static grid_dot *grid_get_dot(grid *g, tree234 *dot_list, int x, int y)
     test.faces = NULL;
     test.x = x;
     test.y = y;
-    ret = find234(dot_list, &test, NULL);
+    ret = btree_find(dot_list, &test, NULL);
     if (ret)
         return ret;
 
     ret = grid_dot_add_new(g, x, y);
-    add234(dot_list, ret);
+    btree_add(dot_list, ret);
     return ret;
 }
 
@@ -1377,7 +1406,7 @@ void grid_find_incentre(grid_face *f)
  * a new face reuses an existing dot.  For example, two squares touching at an
  * edge would generate six unique dots: four dots from the first face, then
  * two additional dots for the second face, because we detect the other two
- * dots have already been taken up.  This list is stored in a tree234
+ * dots have already been taken up.  This list is stored in a btree
  * called "points".  No extra memory-allocation needed here - we store the
  * actual grid_dot* pointers, which all point into the g->dots list.
  * For this reason, we have to calculate coordinates in such a way as to
@@ -1408,14 +1437,14 @@ static grid *grid_new_square(int width, int height, const char *desc)
     int max_faces = width * height;
     int max_dots = (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = a;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     /* generate square faces */
     for (y = 0; y < height; y++) {
@@ -1437,7 +1466,7 @@ static grid *grid_new_square(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -1471,14 +1500,14 @@ static grid *grid_new_honeycomb(int width, int height, const char *desc)
     int max_faces = width * height;
     int max_dots = 2 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = HONEY_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     /* generate hexagonal faces */
     for (y = 0; y < height; y++) {
@@ -1506,7 +1535,7 @@ static grid *grid_new_honeycomb(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -1649,7 +1678,7 @@ static grid *grid_new_triangular(int width, int height, const char *desc)
          *   5x5t1:0_21120b11a1a01a1a00c1a0b211021c1h1a2a1a0a
          *   5x6t1:0_a1212c22c2a02a2f22a0c12a110d0e1c0c0a101121a1
          */
-        tree234 *points = newtree234(grid_point_cmp_fn);
+        btree *points = btree_new(grid_point_cmp_fn);
         /* Upper bounds - don't have to be exact */
         int max_faces = height * (2*width+1);
         int max_dots = (height+1) * (width+1) * 4;
@@ -1702,7 +1731,7 @@ static grid *grid_new_triangular(int width, int height, const char *desc)
             }
         }
 
-        freetree234(points);
+        btree_free(points);
         assert(g->num_faces <= max_faces);
         assert(g->num_dots <= max_dots);
     }
@@ -1737,14 +1766,14 @@ static grid *grid_new_snubsquare(int width, int height, const char *desc)
     int max_faces = 3 * width * height;
     int max_dots = 2 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = SNUBSQUARE_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -1817,7 +1846,7 @@ static grid *grid_new_snubsquare(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -1850,14 +1879,14 @@ static grid *grid_new_cairo(int width, int height, const char *desc)
     int max_faces = 2 * width * height;
     int max_dots = 3 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = CAIRO_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -1923,7 +1952,7 @@ static grid *grid_new_cairo(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -1957,14 +1986,14 @@ static grid *grid_new_greathexagonal(int width, int height, const char *desc)
     int max_faces = 6 * (width + 1) * (height + 1);
     int max_dots = 6 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = GREATHEX_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2053,7 +2082,7 @@ static grid *grid_new_greathexagonal(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2087,14 +2116,14 @@ static grid *grid_new_kagome(int width, int height, const char *desc)
     int max_faces = 6 * (width + 1) * (height + 1);
     int max_dots = 6 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = KAGOME_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2149,7 +2178,7 @@ static grid *grid_new_kagome(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2183,14 +2212,14 @@ static grid *grid_new_octagonal(int width, int height, const char *desc)
     int max_faces = 2 * width * height;
     int max_dots = 4 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = OCTAGONAL_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2232,7 +2261,7 @@ static grid *grid_new_octagonal(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2266,14 +2295,14 @@ static grid *grid_new_kites(int width, int height, const char *desc)
     int max_faces = 6 * width * height;
     int max_dots = 6 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = KITE_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2352,7 +2381,7 @@ static grid *grid_new_kites(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2397,14 +2426,14 @@ static grid *grid_new_floret(int width, int height, const char *desc)
     int max_faces = 6 * width * height;
     int max_dots = 9 * (width + 1) * (height + 1);
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = FLORET_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     /* generate pentagonal faces */
     for (y = 0; y < height; y++) {
@@ -2462,7 +2491,7 @@ static grid *grid_new_floret(int width, int height, const char *desc)
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2497,14 +2526,14 @@ static grid *grid_new_dodecagonal(int width, int height, const char *desc)
     int max_faces = 3 * width * height;
     int max_dots = 14 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = DODEC_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2548,7 +2577,7 @@ static grid *grid_new_dodecagonal(int width, int height, const char *desc)
 	}
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2578,14 +2607,14 @@ static grid *grid_new_greatdodecagonal(int width, int height, const char *desc)
     int max_faces = 30 * width * height;
     int max_dots = 200 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = DODEC_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2662,7 +2691,7 @@ static grid *grid_new_greatdodecagonal(int width, int height, const char *desc)
 	}
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2692,14 +2721,14 @@ static grid *grid_new_greatgreatdodecagonal(int width, int height, const char *d
     int max_faces = 50 * width * height;
     int max_dots = 300 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = DODEC_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2831,7 +2860,7 @@ static grid *grid_new_greatgreatdodecagonal(int width, int height, const char *d
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2861,14 +2890,14 @@ static grid *grid_new_compassdodecagonal(int width, int height, const char *desc
     int max_faces = 6 * width * height;
     int max_dots = 18 * width * height;
 
-    tree234 *points;
+    btree *points;
 
     grid *g = grid_empty();
     g->tilesize = DODEC_TILESIZE;
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     for (y = 0; y < height; y++) {
         for (x = 0; x < width; x++) {
@@ -2927,7 +2956,7 @@ static grid *grid_new_compassdodecagonal(int width, int height, const char *desc
         }
     }
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -2940,7 +2969,7 @@ typedef struct setface_ctx
     int xmin, xmax, ymin, ymax;
 
     grid *g;
-    tree234 *points;
+    btree *points;
 } setface_ctx;
 
 static double round_int_nearest_away(double r)
@@ -3098,7 +3127,7 @@ static grid *grid_new_penrose(int width, int height, int which, const char *desc
     int xsz, ysz, xoff, yoff, aoff;
     double rradius;
 
-    tree234 *points;
+    btree *points;
     grid *g;
 
     penrose_state ps;
@@ -3121,7 +3150,7 @@ static grid *grid_new_penrose(int width, int height, int which, const char *desc
     g->faces = snewn(max_faces, grid_face);
     g->dots = snewn(max_dots, grid_dot);
 
-    points = newtree234(grid_point_cmp_fn);
+    points = btree_new(grid_point_cmp_fn);
 
     memset(&sf_ctx, 0, sizeof(sf_ctx));
     sf_ctx.g = g;
@@ -3149,7 +3178,7 @@ static grid *grid_new_penrose(int width, int height, int which, const char *desc
 
     penrose(&ps, which, aoff);
 
-    freetree234(points);
+    btree_free(points);
     assert(g->num_faces <= max_faces);
     assert(g->num_dots <= max_dots);
 
@@ -3242,12 +3271,269 @@ const char *grid_validate_desc(grid_type type, int width, int height,
     }
 }
 
+/*
+ * Fill in the index-based copy of a finished grid's incidence
+ * relationships.
+ */
+static void grid_make_index(grid *g)
+{
+    int i, j, n;
+
+#define FACE_INDEX(f) ((f) ? (int)((f) - g->faces) : -1)
+
+    g->face_start = snewn(g->num_faces + 1, int);
+    for (i = n = 0; i < g->num_faces; i++) {
+        g->face_start[i] = n;
+        n += g->faces[i].order;
+    }
+    g->face_start[g->num_faces] = n;
+    g->face_edges = snewn(n, int);
+    g->face_dots = snewn(n, int);
+    for (i = 0; i < g->num_faces; i++) {
+        grid_face *f = g->faces + i;
+        int *fe = g->face_edges + g->face_start[i];
+        int *fd = g->face_dots + g->face_start[i];
+        for (j = 0; j < f->order; j++) {
+            fe[j] = f->edges[j] - g->edges;
+            fd[j] = f->dots[j] - g->dots;
+        }
+    }
+
+    g->dot_start = snewn(g->num_dots + 1, int);
+    for (i = n = 0; i < g->num_dots; i++) {
+        g->dot_start[i] = n;
+        n += g->dots[i].order;
+    }
+    g->dot_start[g->num_dots] = n;
+    g->dot_edges = snewn(n, int);
+    g->dot_faces = snewn(n, int);
+    for (i = 0; i < g->num_dots; i++) {
+        grid_dot *d = g->dots + i;
+        int *de = g->dot_edges + g->dot_start[i];
+        int *df = g->dot_faces + g->dot_start[i];
+        for (j = 0; j < d->order; j++) {
+            de[j] = d->edges[j] - g->edges;
+            df[j] = FACE_INDEX(d->faces[j]);
+        }
+    }
+
+    g->edge_dots = snewn(2 * g->num_edges, int);
+    g->edge_faces = snewn(2 * g->num_edges, int);
+    for (i = 0; i < g->num_edges; i++) {
+        grid_edge *e = g->edges + i;
+        g->edge_dots[2*i] = e->dot1 - g->dots;
+        g->edge_dots[2*i+1] = e->dot2 - g->dots;
+        g->edge_faces[2*i] = FACE_INDEX(e->face1);
+        g->edge_faces[2*i+1] = FACE_INDEX(e->face2);
+    }
+
+#undef FACE_INDEX
+}
+
+/*
+ * Build the bucket index used by grid_nearest_edge. An edge can only
+ * be selected by a click that projects onto it and lies within half
+ * its length of it, which is to say inside its bounding box expanded
+ * by half its length all round; so that's the region whose buckets it
+ * goes in. The buckets are the size of the longest edge, which keeps
+ * each edge in at most a handful of them.
+ */
+static void grid_make_buckets(grid *g)
+{
+    int minx, miny, maxx, maxy, size, pass, i, n;
+    int *count;
+
+    if (g->num_dots == 0) {
+        g->bucket_size = 1;
+        g->bucket_w = g->bucket_h = 0;
+        g->bucket_start = snewn(1, int);
+        g->bucket_start[0] = 0;
+        g->bucket_edges = NULL;
+        return;
+    }
+
+    minx = maxx = g->dots[0].x;
+    miny = maxy = g->dots[0].y;
+    for (i = 1; i < g->num_dots; i++) {
+        minx = min(minx, g->dots[i].x);
+        maxx = max(maxx, g->dots[i].x);
+        miny = min(miny, g->dots[i].y);
+        maxy = max(maxy, g->dots[i].y);
+    }
+
+    size = 1;
+    for (i = 0; i < g->num_edges; i++) {
+        grid_edge *e = g->edges + i;
+        double dx = e->dot1->x - e->dot2->x, dy = e->dot1->y - e->dot2->y;
+        size = max(size, (int)ceil(sqrt(dx*dx + dy*dy)));
+    }
+
+    /* A margin of half the longest edge all round catches every click
+     * that any edge could accept. */
+    g->bucket_size = size;
+    g->bucket_x0 = minx - size/2 - 1;
+    g->bucket_y0 = miny - size/2 - 1;
+    g->bucket_w = (maxx + size/2 + 1 - g->bucket_x0) / size + 1;
+    g->bucket_h = (maxy + size/2 + 1 - g->bucket_y0) / size + 1;
+    n = g->bucket_w * g->bucket_h;
+
+    /*
+     * Two passes over the edges: the first counts each bucket's edges
+     * and the second files them, in index order.
+     */
+    count = snewn(n, int);
+    for (i = 0; i < n; i++)
+        count[i] = 0;
+    g->bucket_start = snewn(n + 1, int);
+    g->bucket_edges = NULL;
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < g->num_edges; i++) {
+            grid_edge *e = g->edges + i;
+            double dx = e->dot1->x - e->dot2->x, dy = e->dot1->y - e->dot2->y;
+            int half = (int)ceil(sqrt(dx*dx + dy*dy) / 2);
+            int x0 = (min(e->dot1->x, e->dot2->x) - half - g->bucket_x0) / size;
+            int x1 = (max(e->dot1->x, e->dot2->x) + half - g->bucket_x0) / size;
+            int y0 = (min(e->dot1->y, e->dot2->y) - half - g->bucket_y0) / size;
+            int y1 = (max(e->dot1->y, e->dot2->y) + half - g->bucket_y0) / size;
+            int bx, by;
+
+            x0 = max(x0, 0);
+            y0 = max(y0, 0);
+            x1 = min(x1, g->bucket_w - 1);
+            y1 = min(y1, g->bucket_h - 1);
+            for (by = y0; by <= y1; by++)
+                for (bx = x0; bx <= x1; bx++) {
+                    int b = by * g->bucket_w + bx;
+                    if (pass == 0)
+                        count[b]++;
+                    else
+                        g->bucket_edges[g->bucket_start[b] + count[b]++] = i;
+                }
+        }
+
+        if (pass == 0) {
+            int total = 0;
+            for (i = 0; i < n; i++) {
+                g->bucket_start[i] = total;
+                total += count[i];
+                count[i] = 0;
+            }
+            g->bucket_start[n] = total;
+            g->bucket_edges = snewn(total + 1, int);
+        }
+    }
+    sfree(count);
+}
+
 grid *grid_new(grid_type type, int width, int height, const char *desc)
 {
     const char *err = grid_validate_desc(type, width, height, desc);
+    grid *g;
+
     if (err) assert(!"Invalid grid description.");
 
-    return grid_news[type](width, height, desc);
+    g = grid_news[type](width, height, desc);
+    grid_make_index(g);
+    grid_make_buckets(g);
+    return g;
+}
+
+/*
+ * The cache of shared grids is a short list in most-recently-used
+ * order. It's per-thread, because nothing in the grid structure
+ * (least of all its refcount) is safe to share between threads.
+ */
+#define GRID_CACHE_ENTRIES 8
+#define GRID_CACHE_BYTES (32 * 1024 * 1024)
+
+struct grid_cache_entry {
+    grid_type type;
+    int width, height;
+    char *desc;                        /* NULL for grids that have none */
+    size_t bytes;
+    grid *g;
+};
+
+struct grid_cache {
+    int n;
+    size_t bytes;
+    struct grid_cache_entry entries[GRID_CACHE_ENTRIES];
+};
+
+static THREAD_LOCAL struct grid_cache grid_cache;
+
+/* An estimate of the memory a grid occupies, for the cache's budget. */
+static size_t grid_bytes(const grid *g)
+{
+    size_t incidences = g->face_start[g->num_faces] +
+        g->dot_start[g->num_dots];
+
+    return sizeof(grid) +
+        g->num_faces * (sizeof(grid_face) + sizeof(int)) +
+        g->num_dots * (sizeof(grid_dot) + sizeof(int)) +
+        g->num_edges * (sizeof(grid_edge) + 4 * sizeof(int)) +
+        incidences * 2 * (sizeof(void *) + sizeof(int)) +
+        (g->bucket_w * g->bucket_h + 1 +
+         g->bucket_start[g->bucket_w * g->bucket_h]) * sizeof(int);
+}
+
+static void grid_cache_evict(struct grid_cache *gc)
+{
+    struct grid_cache_entry *ent = &gc->entries[--gc->n];
+
+    gc->bytes -= ent->bytes;
+    sfree(ent->desc);
+    grid_free(ent->g);
+}
+
+grid *grid_new_shared(grid_type type, int width, int height,
+                      const char *desc)
+{
+    struct grid_cache *gc = &grid_cache;
+    struct grid_cache_entry ent;
+    int i;
+
+    for (i = 0; i < gc->n; i++) {
+        ent = gc->entries[i];
+        if (ent.type == type && ent.width == width && ent.height == height &&
+            (ent.desc ? desc && !strcmp(ent.desc, desc) : !desc)) {
+            memmove(gc->entries + 1, gc->entries,
+                    i * sizeof(*gc->entries));
+            gc->entries[0] = ent;
+            ent.g->refcount++;
+            return ent.g;
+        }
+    }
+
+    ent.type = type;
+    ent.width = width;
+    ent.height = height;
+    ent.g = grid_new(type, width, height, desc);
+    ent.bytes = grid_bytes(ent.g);
+
+    /* A grid too big to share at all just isn't cached. */
+    if (ent.bytes > GRID_CACHE_BYTES)
+        return ent.g;
+
+    while (gc->n > 0 && (gc->n == GRID_CACHE_ENTRIES ||
+                         gc->bytes + ent.bytes > GRID_CACHE_BYTES))
+        grid_cache_evict(gc);
+
+    ent.desc = desc ? dupstr(desc) : NULL;
+    ent.g->refcount++;
+    memmove(gc->entries + 1, gc->entries, gc->n * sizeof(*gc->entries));
+    gc->entries[0] = ent;
+    gc->n++;
+    gc->bytes += ent.bytes;
+    return ent.g;
+}
+
+void grid_cache_clear(void)
+{
+    struct grid_cache *gc = &grid_cache;
+
+    while (gc->n > 0)
+        grid_cache_evict(gc);
 }
 
 void grid_compute_size(grid_type type, int width, int height,
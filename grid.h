@@ -85,6 +85,34 @@ typedef struct grid {
    * of a square cell. */
   int tilesize;
 
+  /*
+   * The same incidence relationships again, as indices into the
+   * arrays above instead of pointers, packed into flat arrays in
+   * "compressed sparse row" form for code that walks them in tight
+   * loops. The edges around face i are face_edges[face_start[i]] up
+   * to (but not including) face_edges[face_start[i+1]], in the same
+   * order as f->edges, and face_dots is laid out in the same way.
+   * Similarly the edges and faces around dot i are at dot_start[i]
+   * onwards in dot_edges and dot_faces. Edge i's two dots are
+   * edge_dots[2*i] and edge_dots[2*i+1] (dot1 and dot2), and its faces
+   * are likewise in edge_faces. The infinite face is represented by
+   * -1 throughout.
+   */
+  int *face_start, *face_edges, *face_dots;
+  int *dot_start, *dot_edges, *dot_faces;
+  int *edge_dots, *edge_faces;
+
+  /*
+   * A uniform spatial index for grid_nearest_edge. The bounding box of
+   * the dots is divided into square buckets bucket_size units across,
+   * bucket_w by bucket_h of them, with the top left one having its
+   * corner at (bucket_x0, bucket_y0). Bucket i lists, in
+   * bucket_edges[bucket_start[i]] up to bucket_edges[bucket_start[i+1]],
+   * every edge that a click anywhere in the bucket could select.
+   */
+  int bucket_size, bucket_x0, bucket_y0, bucket_w, bucket_h;
+  int *bucket_start, *bucket_edges;
+
   /* We really don't want to copy this monstrosity!
    * A grid is immutable once generated.
    */
@@ -123,6 +151,21 @@ const char *grid_validate_desc(grid_type type, int width, int height,
 
 grid *grid_new(grid_type type, int width, int height, const char *desc);
 
+/*
+ * Like grid_new, but may hand out another reference to an identical
+ * grid built by an earlier call on the same thread, since a grid is
+ * immutable once built. Either way the caller gets a reference of its
+ * own, to be released with grid_free as usual.
+ *
+ * A few recently used grids are kept alive by the cache even when
+ * nothing else refers to them, within a fixed memory budget.
+ * grid_cache_clear releases them all (on the calling thread), which a
+ * thread that has been generating should do before it exits.
+ */
+grid *grid_new_shared(grid_type type, int width, int height,
+                      const char *desc);
+void grid_cache_clear(void);
+
 void grid_free(grid *g);
 
 grid_edge *grid_nearest_edge(grid *g, int x, int y);
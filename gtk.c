@@ -12,7 +12,6 @@
 #include <math.h>
 
 #include <sys/time.h>
-#include <sys/resource.h>
 
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
@@ -3559,27 +3558,11 @@ static frontend *new_window(
     return fe;
 }
 
-static void list_presets_from_menu(struct preset_menu *menu)
-{
-    int i;
-
-    for (i = 0; i < menu->n_entries; i++) {
-        if (menu->entries[i].params) {
-            char *paramstr = thegame.encode_params(
-                menu->entries[i].params, true);
-            printf("%s %s\n", paramstr, menu->entries[i].title);
-            sfree(paramstr);
-        } else {
-            list_presets_from_menu(menu->entries[i].submenu);
-        }
-    }
-}
-
 int main(int argc, char **argv)
 {
     char *pname = argv[0];
     char *error;
-    int ngenerate = 0, px = 1, py = 1;
+    int ngenerate = 0, njobs = 1, nthreads = 1, px = 1, py = 1;
     bool print = false;
     bool time_generation = false, test_solve = false, list_presets = false;
     bool soln = false, colour = false;
@@ -3634,6 +3617,31 @@ int main(int argc, char **argv)
 		}
 	    } else
 		ngenerate = 1;
+	} else if (doing_opts && !strcmp(p, "--jobs")) {
+	    if (--ac > 0) {
+		njobs = atoi(*++av);
+		if (njobs < 1) {
+		    fprintf(stderr, "%s: '--jobs' expected a positive "
+			    "number\n", pname);
+		    return 1;
+		}
+	    } else {
+		fprintf(stderr, "%s: '--jobs' expected a number\n", pname);
+		return 1;
+	    }
+	} else if (doing_opts && !strcmp(p, "--threads")) {
+	    if (--ac > 0) {
+		nthreads = atoi(*++av);
+		if (nthreads < 1) {
+		    fprintf(stderr, "%s: '--threads' expected a positive "
+			    "number\n", pname);
+		    return 1;
+		}
+	    } else {
+		fprintf(stderr, "%s: '--threads' expected a number\n",
+			pname);
+		return 1;
+	    }
 	} else if (doing_opts && !strcmp(p, "--time-generation")) {
             time_generation = true;
 	} else if (doing_opts && !strcmp(p, "--test-solve")) {
@@ -3763,30 +3771,11 @@ int main(int argc, char **argv)
 
     /*
      * Special standalone mode for generating puzzle IDs on the
-     * command line. Useful for generating puzzles to be printed
-     * out and solved offline (for puzzles where that even makes
-     * sense - Solo, for example, is a lot more pencil-and-paper
-     * friendly than Twiddle!)
-     * 
-     * Usage:
-     * 
-     *   <puzzle-name> --generate [<n> [<params>]]
-     * 
-     * <n>, if present, is the number of puzzle IDs to generate.
-     * <params>, if present, is the same type of parameter string
-     * you would pass to the puzzle when running it in GUI mode,
-     * including optional extras such as the expansion factor in
-     * Rectangles and the difficulty level in Solo.
-     * 
-     * If you specify <params>, you must also specify <n> (although
-     * you may specify it to be 1). Sorry; that was the
-     * simplest-to-parse command-line syntax I came up with.
+     * command line, printing them or saving them to files; see
+     * batchgen.c.
      */
     if (ngenerate > 0 || print || savefile || savesuffix) {
-	int i, n = 1;
-	midend *me;
-	char *id;
-	document *doc = NULL;
+        struct batchgen_options opts;
 
         /*
          * If we're in this branch, we should display any pending
@@ -3798,195 +3787,26 @@ int main(int argc, char **argv)
             return 1;
         }
 
-	n = ngenerate;
-
-	me = midend_new(NULL, &thegame, NULL, NULL);
-	i = 0;
-
-	if (savefile && !savesuffix)
-	    savesuffix = "";
-	if (!savefile && savesuffix)
-	    savefile = "";
-
-	if (print)
-	    doc = document_new(px, py, scale);
-
-	/*
-	 * In this loop, we either generate a game ID or read one
-	 * from stdin depending on whether we're in generate mode;
-	 * then we either write it to stdout or print it, depending
-	 * on whether we're in print mode. Thus, this loop handles
-	 * generate-to-stdout, print-from-stdin and generate-and-
-	 * immediately-print modes.
-	 * 
-	 * (It could also handle a copy-stdin-to-stdout mode,
-	 * although there's currently no combination of options
-	 * which will cause this loop to be activated in that mode.
-	 * It wouldn't be _entirely_ pointless, though, because
-	 * stdin could contain bare params strings or random-seed
-	 * IDs, and stdout would contain nothing but fully
-	 * generated descriptive game IDs.)
-	 */
-	while (ngenerate == 0 || i < n) {
-	    char *pstr, *seed;
-            const char *err;
-            struct rusage before, after;
-
-	    if (ngenerate == 0) {
-		pstr = fgetline(stdin);
-		if (!pstr)
-		    break;
-		pstr[strcspn(pstr, "\r\n")] = '\0';
-	    } else {
-		if (arg) {
-		    pstr = snewn(strlen(arg) + 40, char);
-
-		    strcpy(pstr, arg);
-		    if (i > 0 && strchr(arg, '#'))
-			sprintf(pstr + strlen(pstr), "-%d", i);
-		} else
-		    pstr = NULL;
-	    }
-
-	    if (pstr) {
-		err = midend_game_id(me, pstr);
-		if (err) {
-		    fprintf(stderr, "%s: error parsing '%s': %s\n",
-			    pname, pstr, err);
-		    return 1;
-		}
-	    }
-
-            if (time_generation)
-                getrusage(RUSAGE_SELF, &before);
-
-            midend_new_game(me);
-
-            seed = midend_get_random_seed(me);
-
-            if (time_generation) {
-                double elapsed;
-
-                getrusage(RUSAGE_SELF, &after);
-
-                elapsed = (after.ru_utime.tv_sec -
-                           before.ru_utime.tv_sec);
-                elapsed += (after.ru_utime.tv_usec -
-                            before.ru_utime.tv_usec) / 1000000.0;
-
-                printf("%s %s: %.6f\n", thegame.name, seed, elapsed);
-            }
-
-            if (test_solve && thegame.can_solve) {
-                /*
-                 * Now destroy the aux_info in the midend, by means of
-                 * re-entering the same game id, and then try to solve
-                 * it.
-                 */
-                char *game_id;
-
-                game_id = midend_get_game_id(me);
-                err = midend_game_id(me, game_id);
-                if (err) {
-                    fprintf(stderr, "%s %s: game id re-entry error: %s\n",
-                            thegame.name, seed, err);
-                    return 1;
-                }
-                midend_new_game(me);
-                sfree(game_id);
-
-                err = midend_solve(me);
-                /*
-                 * If the solve operation returned the error "Solution
-                 * not known for this puzzle", that's OK, because that
-                 * just means it's a puzzle for which we don't have an
-                 * algorithmic solver and hence can't solve it without
-                 * the aux_info, e.g. Netslide. Any other error is a
-                 * problem, though.
-                 */
-                if (err && strcmp(err, "Solution not known for this puzzle")) {
-                    fprintf(stderr, "%s %s: solve error: %s\n",
-                            thegame.name, seed, err);
-                    return 1;
-                }
-            }
-
-	    sfree(pstr);
-            sfree(seed);
-
-	    if (doc) {
-		err = midend_print_puzzle(me, doc, soln);
-		if (err) {
-		    fprintf(stderr, "%s: error in printing: %s\n", pname, err);
-		    return 1;
-		}
-	    }
-	    if (savefile) {
-		struct savefile_write_ctx ctx;
-		char *realname = snewn(40 + strlen(savefile) +
-				       strlen(savesuffix), char);
-		sprintf(realname, "%s%d%s", savefile, i, savesuffix);
-
-                if (soln) {
-                    const char *err = midend_solve(me);
-                    if (err) {
-                        fprintf(stderr, "%s: unable to show solution: %s\n",
-                                realname, err);
-                        return 1;
-                    }
-                }
-
-		ctx.fp = fopen(realname, "w");
-		if (!ctx.fp) {
-		    fprintf(stderr, "%s: open: %s\n", realname,
-			    strerror(errno));
-		    return 1;
-		}
-                ctx.error = 0;
-		midend_serialise(me, savefile_write, &ctx);
-		if (ctx.error) {
-		    fprintf(stderr, "%s: write: %s\n", realname,
-			    strerror(ctx.error));
-		    return 1;
-		}
-		if (fclose(ctx.fp)) {
-		    fprintf(stderr, "%s: close: %s\n", realname,
-			    strerror(errno));
-		    return 1;
-		}
-		sfree(realname);
-	    }
-	    if (!doc && !savefile && !time_generation) {
-		id = midend_get_game_id(me);
-		puts(id);
-		sfree(id);
-	    }
-
-	    i++;
-	}
-
-	if (doc) {
-	    psdata *ps = ps_init(stdout, colour);
-	    document_print(doc, ps_drawing_api(ps));
-	    document_free(doc);
-	    ps_free(ps);
-	}
-
-	midend_free(me);
-
-	return 0;
+        batchgen_default_options(&opts);
+        opts.pname = pname;
+        opts.arg = arg;
+        opts.ngenerate = ngenerate;
+        opts.njobs = njobs;
+        opts.nthreads = nthreads;
+        opts.print = print;
+        opts.px = px;
+        opts.py = py;
+        opts.scale = scale;
+        opts.soln = soln;
+        opts.colour = colour;
+        opts.time_generation = time_generation;
+        opts.test_solve = test_solve;
+        opts.savefile = savefile;
+        opts.savesuffix = savesuffix;
+
+        return batchgen_run(&thegame, &opts);
     } else if (list_presets) {
-        /*
-         * Another specialist mode which causes the puzzle to list the
-         * game_params strings for all its preset configurations.
-         */
-        midend *me;
-        struct preset_menu *menu;
-
-	me = midend_new(NULL, &thegame, NULL, NULL);
-        menu = midend_get_presets(me, NULL);
-        list_presets_from_menu(menu);
-	midend_free(me);
+        batchgen_list_presets(&thegame);
         return 0;
     } else {
 	frontend *fe;
@@ -0,0 +1,55 @@
+/*
+ * headless.c: the few front end functions needed by the midend and
+ * back ends when nothing is being drawn on screen. Shared by the
+ * command-line programs that link in the real midend and drawing
+ * code, such as puzzlegen and threadtest. (The stand-alone solvers,
+ * which stub out the drawing code as well, use nullfe.c instead.)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include <sys/time.h>
+
+#include "puzzles.h"
+
+void fatal(const char *fmt, ...)
+{
+    va_list ap;
+
+    fprintf(stderr, "fatal error: ");
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+#ifdef DEBUGGING
+void debug_printf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+#endif
+
+void get_random_seed(void **randseed, int *randseedsize)
+{
+    struct timeval *tvp = snew(struct timeval);
+    gettimeofday(tvp, NULL);
+    *randseed = (void *)tvp;
+    *randseedsize = sizeof(struct timeval);
+}
+
+void frontend_default_colour(frontend *fe, float *output)
+{
+    output[0] = output[1] = output[2] = 0.9F;
+}
+
+void activate_timer(frontend *fe) {}
+void deactivate_timer(frontend *fe) {}
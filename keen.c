@@ -372,15 +372,13 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 
 		/* (i,j) is a valid digit pair. Try it both ways round. */
 
-		if (solver->cube[sq[0]*w+i-1] &&
-		    solver->cube[sq[1]*w+j-1]) {
+		if (cube2(sq[0], i) && cube2(sq[1], j)) {
 		    ctx->dscratch[0] = i;
 		    ctx->dscratch[1] = j;
 		    solver_clue_candidate(ctx, diff, box);
 		}
 
-		if (solver->cube[sq[0]*w+j-1] &&
-		    solver->cube[sq[1]*w+i-1]) {
+		if (cube2(sq[0], j) && cube2(sq[1], i)) {
 		    ctx->dscratch[0] = j;
 		    ctx->dscratch[1] = i;
 		    solver_clue_candidate(ctx, diff, box);
@@ -411,7 +409,7 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 		    for (j = ctx->dscratch[i] + 1; j <= w; j++) {
 			if (op == C_ADD ? (total < j) : (total % j != 0))
 			    continue;  /* this one won't fit */
-			if (!solver->cube[sq[i]*w+j-1])
+			if (!cube2(sq[i], j))
 			    continue;  /* this one is ruled out already */
 			for (k = 0; k < i; k++)
 			    if (ctx->dscratch[k] == j &&
@@ -478,7 +476,7 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 
 	    for (i = 0; i < n; i++)
 		for (j = 1; j <= w; j++) {
-		    if (solver->cube[sq[i]*w+j-1] &&
+		    if (cube2(sq[i], j) &&
 			!(ctx->iscratch[i] & (1 << j))) {
 #ifdef STANDALONE_SOLVER
 			if (solver_show_working) {
@@ -488,7 +486,7 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 			    prefix[0] = '\0';
 			}
 #endif
-			solver->cube[sq[i]*w+j-1] = 0;
+			cubeclear2(sq[i], j);
 			ret = 1;
 		    }
 		}
@@ -522,7 +520,7 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 		    for (k = 0; k < w; k++) {
 			int pos = start + k*step;
 			if (ctx->whichbox[pos] != box &&
-			    solver->cube[pos*w+j-1]) {
+			    cube2(pos, j)) {
 #ifdef STANDALONE_SOLVER
 			    if (solver_show_working) {
 				printf("%s%s%*s   ruling out %d at (%d,%d)\n",
@@ -532,7 +530,7 @@ static int solver_common(struct latin_solver *solver, void *vctx, int diff)
 				prefix[0] = prefix2[0] = '\0';
 			    }
 #endif
-			    solver->cube[pos*w+j-1] = 0;
+			    cubeclear2(pos, j);
 			    ret = 1;
 			}
 		    }
@@ -693,8 +691,8 @@ static int solver(int w, int *dsf, long *clues, digit *soln, int maxdiff)
      * can iterate more easily.
      *
      * Also transpose the x- and y-coordinates at this point,
-     * because the 'cube' array in the general Latin square solver
-     * puts x first (oops).
+     * because the candidate array in the general Latin square
+     * solver puts x first (oops).
      */
     for (ctx.nboxes = i = 0; i < a; i++)
 	if (dsf_canonify(dsf, i) == i)
@@ -938,6 +936,7 @@ done
 	 */
 	sfree(grid);
 	grid = latin_generate(w, rs);
+        genstat_count(GENSTAT_ATTEMPTS);
 
 	/*
 	 * Divide the grid into arbitrarily sized blocks, but so as
@@ -1025,8 +1024,10 @@ done
 	for (i = 0; i < a; i++)
 	    if (singletons[i])
                 break;
-        if (i < a)
+        if (i < a) {
+            genstat_count(GENSTAT_REJECT_OTHER);
             continue;
+        }
 
 	/*
 	 * Decide what would be acceptable clues for each block.
@@ -1219,13 +1220,17 @@ done
 	if (diff > 0) {
 	    memset(soln, 0, a);
 	    ret = solver(w, dsf, clues, soln, diff-1);
-	    if (ret <= diff-1)
+	    if (ret <= diff-1) {
+                latin_count_rejection(ret, diff);
 		continue;
+            }
 	}
 	memset(soln, 0, a);
 	ret = solver(w, dsf, clues, soln, diff);
-	if (ret != diff)
+	if (ret != diff) {
+            latin_count_rejection(ret, diff);
 	    continue;		       /* go round again */
+        }
 
 	/*
 	 * I wondered if at this point it would be worth trying to
@@ -26,6 +26,21 @@ static int latin_solver_top(struct latin_solver *solver, int maxdiff,
 int solver_show_working, solver_recurse_depth;
 #endif
 
+/*
+ * Test and clear arbitrary positions in the cube, as made by
+ * cubepos. There are o positions per square, so position p is bit
+ * p % o of cand[p / o].
+ */
+static bool postest(struct latin_solver *solver, int p)
+{
+    return (solver->cand[p / solver->o] >> (p % solver->o)) & 1;
+}
+
+static void posclear(struct latin_solver *solver, int p)
+{
+    solver->cand[p / solver->o] &= ~(1UL << (p % solver->o));
+}
+
 /*
  * Function called when we are certain that a particular square has
  * a particular number in it. The y-coordinate passed in here is
@@ -41,23 +56,21 @@ void latin_solver_place(struct latin_solver *solver, int x, int y, int n)
     /*
      * Rule out all other numbers in this square.
      */
-    for (i = 1; i <= o; i++)
-	if (i != n)
-            cube(x,y,i) = false;
+    solver->cand[cubesq(x,y)] = LATIN_BIT(n);
 
     /*
      * Rule out this number in all other positions in the row.
      */
     for (i = 0; i < o; i++)
 	if (i != y)
-            cube(x,i,n) = false;
+            cubeclear(x,i,n);
 
     /*
      * Rule out this number in all other positions in the column.
      */
     for (i = 0; i < o; i++)
 	if (i != x)
-            cube(i,y,n) = false;
+            cubeclear(i,y,n);
 
     /*
      * Enter the number in the result grid.
@@ -68,7 +81,8 @@ void latin_solver_place(struct latin_solver *solver, int x, int y, int n)
      * Cross out this number from the list of numbers left to place
      * in its row, its column and its block.
      */
-    solver->row[y*o+n-1] = solver->col[x*o+n-1] = true;
+    solver->row[y] |= LATIN_BIT(n);
+    solver->col[x] |= LATIN_BIT(n);
 }
 
 int latin_solver_elim(struct latin_solver *solver, int start, int step
@@ -89,11 +103,24 @@ int latin_solver_elim(struct latin_solver *solver, int start, int step
      */
     m = 0;
     fpos = -1;
-    for (i = 0; i < o; i++)
-	if (solver->cube[start+i*step]) {
-	    fpos = start+i*step;
-	    m++;
-	}
+    if (step == 1) {
+        /* All the candidates for one square, so all in one word. */
+        unsigned long bits = solver->cand[start / o];
+        assert(start % o == 0);
+        m = count_bits(bits);
+        if (bits)
+            fpos = start + lowest_bit(bits);
+    } else {
+        /* One digit in a line of squares, so one bit in each word. */
+        unsigned long bit = 1UL << (start % o);
+        int sq = start / o;
+        assert(step % o == 0);
+        for (i = 0; i < o; i++, sq += step / o)
+            if (solver->cand[sq] & bit) {
+                fpos = start+i*step;
+                m++;
+            }
+    }
 
     if (m == 1) {
 	int x, y, n;
@@ -139,7 +166,8 @@ int latin_solver_elim(struct latin_solver *solver, int start, int step
 }
 
 struct latin_solver_scratch {
-    unsigned char *grid, *rowidx, *colidx, *set;
+    unsigned char *grid, *rowidx, *colidx;
+    unsigned long *rows;
     int *neighbours, *bfsqueue;
 #ifdef STANDALONE_SOLVER
     int *bfsprev;
@@ -158,11 +186,11 @@ int latin_solver_set(struct latin_solver *solver,
 #ifdef STANDALONE_SOLVER
     char **names = solver->names;
 #endif
-    int i, j, n, count;
-    unsigned char *grid = scratch->grid;
+    int i, j, n;
     unsigned char *rowidx = scratch->rowidx;
     unsigned char *colidx = scratch->colidx;
-    unsigned char *set = scratch->set;
+    unsigned long *rows = scratch->rows;
+    unsigned long set, allset;
 
     /*
      * We are passed a o-by-o matrix of booleans. Our first job
@@ -174,9 +202,21 @@ int latin_solver_set(struct latin_solver *solver,
     memset(colidx, true, o);
     for (i = 0; i < o; i++) {
         int count = 0, first = -1;
-        for (j = 0; j < o; j++)
-            if (solver->cube[start+i*step1+j*step2])
-                first = j, count++;
+
+        if (step2 == 1) {
+            /*
+             * This row is all the digits of one square, in order,
+             * so we can read it straight out of that square's word.
+             */
+            unsigned long bits = solver->cand[(start+i*step1) / o];
+            count = count_bits(bits);
+            if (bits)
+                first = lowest_bit(bits);
+        } else {
+            for (j = 0; j < o; j++)
+                if (postest(solver, start+i*step1+j*step2))
+                    first = j, count++;
+        }
 
 	if (count == 0) return -1;
         if (count == 1)
@@ -197,11 +237,17 @@ int latin_solver_set(struct latin_solver *solver,
     assert(n == j);
 
     /*
-     * And create the smaller matrix.
+     * And create the smaller matrix, with each row packed into a
+     * word. Column j goes in bit n-1-j, so that a set of columns is
+     * also a word, and counting through the sets of columns in the
+     * order we want is just incrementing it.
      */
-    for (i = 0; i < n; i++)
+    for (i = 0; i < n; i++) {
+        rows[i] = 0;
         for (j = 0; j < n; j++)
-            grid[i*o+j] = solver->cube[start+rowidx[i]*step1+colidx[j]*step2];
+            if (postest(solver, start+rowidx[i]*step1+colidx[j]*step2))
+                rows[i] |= 1UL << (n-1-j);
+    }
 
     /*
      * Having done that, we now have a matrix in which every row
@@ -209,11 +255,15 @@ int latin_solver_set(struct latin_solver *solver,
      * a rectangle of zeroes (in the set-theoretic sense of
      * `rectangle', i.e. a subset of rows crossed with a subset of
      * columns) whose width and height add up to n.
+     *
+     * We stop after the set of all n columns, rather than when we
+     * reach 1 << n, because with n == 32 that doesn't fit in an
+     * unsigned long everywhere.
      */
+    allset = (n > 0 ? 2UL * LATIN_BIT(n) - 1 : 0);
+    for (set = 0;; set++) {
+        int count = count_bits(set);
 
-    memset(set, 0, n);
-    count = 0;
-    while (1) {
         /*
          * We have a candidate set. If its size is <=1 or >=n-1
          * then we move on immediately.
@@ -224,17 +274,10 @@ int latin_solver_set(struct latin_solver *solver,
              * find that many rows which each have a zero in all
              * the positions listed in `set'.
              */
-            int rows = 0;
-            for (i = 0; i < n; i++) {
-                bool ok = true;
-                for (j = 0; j < n; j++)
-                    if (set[j] && grid[i*o+j]) {
-                        ok = false;
-                        break;
-                    }
-                if (ok)
-                    rows++;
-            }
+            int nrows = 0;
+            for (i = 0; i < n; i++)
+                if (!(rows[i] & set))
+                    nrows++;
 
             /*
              * We expect never to be able to get _more_ than
@@ -244,7 +287,7 @@ int latin_solver_set(struct latin_solver *solver,
              * indicates a faulty deduction before this point or
              * even a bogus clue.
              */
-            if (rows > n - count) {
+            if (nrows > n - count) {
 #ifdef STANDALONE_SOLVER
 		if (solver_show_working) {
 		    va_list ap;
@@ -260,7 +303,7 @@ int latin_solver_set(struct latin_solver *solver,
 		return -1;
 	    }
 
-            if (rows >= n - count) {
+            if (nrows >= n - count) {
                 bool progress = false;
 
                 /*
@@ -275,15 +318,9 @@ int latin_solver_set(struct latin_solver *solver,
                  * positions in the cube to meddle with.
                  */
                 for (i = 0; i < n; i++) {
-                    bool ok = true;
-                    for (j = 0; j < n; j++)
-                        if (set[j] && grid[i*o+j]) {
-                            ok = false;
-                            break;
-                        }
-                    if (!ok) {
+                    if (rows[i] & set) {
                         for (j = 0; j < n; j++)
-                            if (!set[j] && grid[i*o+j]) {
+                            if (rows[i] & ~set & (1UL << (n-1-j))) {
                                 int fpos = (start+rowidx[i]*step1+
                                             colidx[j]*step2);
 #ifdef STANDALONE_SOLVER
@@ -311,7 +348,7 @@ int latin_solver_set(struct latin_solver *solver,
                                 }
 #endif
                                 progress = true;
-                                solver->cube[fpos] = false;
+                                posclear(solver, fpos);
                             }
                     }
                 }
@@ -322,17 +359,8 @@ int latin_solver_set(struct latin_solver *solver,
             }
         }
 
-        /*
-         * Binary increment: change the rightmost 0 to a 1, and
-         * change all 1s to the right of it to 0s.
-         */
-        i = n;
-        while (i > 0 && set[i-1])
-            set[--i] = 0, count--;
-        if (i > 0)
-            set[--i] = 1, count++;
-        else
-            break;                     /* done */
+        if (set == allset)
+            break;
     }
 
     return 0;
@@ -391,22 +419,19 @@ int latin_solver_forcing(struct latin_solver *solver,
 
     for (y = 0; y < o; y++)
         for (x = 0; x < o; x++) {
-            int count, t, n;
+            unsigned long bits = solver->cand[cubesq(x, y)];
+            int t, n;
 
             /*
              * If this square doesn't have exactly two candidate
              * numbers, don't try it.
              *
-             * In this loop we also sum the candidate numbers,
-             * which is a nasty hack to allow us to quickly find
-             * `the other one' (since we will shortly know there
-             * are exactly two).
+             * We also sum the candidate numbers, which is a nasty
+             * hack to allow us to quickly find `the other one'.
              */
-            for (count = t = 0, n = 1; n <= o; n++)
-                if (cube(x, y, n))
-                    count++, t += n;
-            if (count != 2)
+            if (count_bits(bits) != 2)
                 continue;
+            t = lowest_bit(bits) + lowest_bit(bits & (bits-1)) + 2;
 
             /*
              * Now attempt a bfs for each candidate.
@@ -450,7 +475,7 @@ int latin_solver_forcing(struct latin_solver *solver,
                          * Try visiting each of those neighbours.
                          */
                         for (i = 0; i < nneighbours; i++) {
-                            int cc, tt, nn;
+                            unsigned long tbits;
 
                             xt = neighbours[i] % o;
                             yt = neighbours[i] / o;
@@ -477,15 +502,14 @@ int latin_solver_forcing(struct latin_solver *solver,
                              * this square to have exactly two
                              * possible numbers.
                              */
-                            for (cc = tt = 0, nn = 1; nn <= o; nn++)
-                                if (cube(xt, yt, nn))
-                                    cc++, tt += nn;
-                            if (cc == 2) {
+                            tbits = solver->cand[cubesq(xt, yt)];
+                            if (count_bits(tbits) == 2) {
                                 bfsqueue[tail++] = yt*o+xt;
 #ifdef STANDALONE_SOLVER
                                 bfsprev[yt*o+xt] = yy*o+xx;
 #endif
-                                number[yt*o+xt] = tt - currn;
+                                number[yt*o+xt] =
+                                    lowest_bit(tbits & ~LATIN_BIT(currn)) + 1;
                             }
 
                             /*
@@ -522,7 +546,7 @@ int latin_solver_forcing(struct latin_solver *solver,
 					   xt+1, yt+1);
                                 }
 #endif
-                                cube(xt, yt, orign) = false;
+                                cubeclear(xt, yt, orign);
                                 return 1;
                             }
                         }
@@ -540,7 +564,7 @@ struct latin_solver_scratch *latin_solver_new_scratch(struct latin_solver *solve
     scratch->grid = snewn(o*o, unsigned char);
     scratch->rowidx = snewn(o, unsigned char);
     scratch->colidx = snewn(o, unsigned char);
-    scratch->set = snewn(o, unsigned char);
+    scratch->rows = snewn(o, unsigned long);
     scratch->neighbours = snewn(3*o, int);
     scratch->bfsqueue = snewn(o*o, int);
 #ifdef STANDALONE_SOLVER
@@ -556,7 +580,7 @@ void latin_solver_free_scratch(struct latin_solver_scratch *scratch)
 #endif
     sfree(scratch->bfsqueue);
     sfree(scratch->neighbours);
-    sfree(scratch->set);
+    sfree(scratch->rows);
     sfree(scratch->colidx);
     sfree(scratch->rowidx);
     sfree(scratch->grid);
@@ -565,17 +589,22 @@ void latin_solver_free_scratch(struct latin_solver_scratch *scratch)
 
 void latin_solver_alloc(struct latin_solver *solver, digit *grid, int o)
 {
-    int x, y;
+    unsigned long all;
+    int x, y, i;
+
+    assert(o >= 1 && o <= 32);
+    all = 2UL * LATIN_BIT(o) - 1;
 
     solver->o = o;
-    solver->cube = snewn(o*o*o, unsigned char);
+    solver->cand = snewn(o*o, unsigned long);
     solver->grid = grid;		/* write straight back to the input */
-    memset(solver->cube, 1, o*o*o);
+    for (i = 0; i < o*o; i++)
+        solver->cand[i] = all;
 
-    solver->row = snewn(o*o, unsigned char);
-    solver->col = snewn(o*o, unsigned char);
-    memset(solver->row, 0, o*o);
-    memset(solver->col, 0, o*o);
+    solver->row = snewn(o, unsigned long);
+    solver->col = snewn(o, unsigned long);
+    memset(solver->row, 0, o * sizeof(unsigned long));
+    memset(solver->col, 0, o * sizeof(unsigned long));
 
     for (x = 0; x < o; x++)
 	for (y = 0; y < o; y++)
@@ -589,7 +618,7 @@ void latin_solver_alloc(struct latin_solver *solver, digit *grid, int o)
 
 void latin_solver_free(struct latin_solver *solver)
 {
-    sfree(solver->cube);
+    sfree(solver->cand);
     sfree(solver->row);
     sfree(solver->col);
 }
@@ -606,7 +635,7 @@ int latin_solver_diff_simple(struct latin_solver *solver)
      */
     for (y = 0; y < o; y++)
         for (n = 1; n <= o; n++)
-            if (!solver->row[y*o+n-1]) {
+            if (!(solver->row[y] & LATIN_BIT(n))) {
                 ret = latin_solver_elim(solver, cubepos(0,y,n), o*o
 #ifdef STANDALONE_SOLVER
 					, "positional elimination,"
@@ -621,7 +650,7 @@ int latin_solver_diff_simple(struct latin_solver *solver)
      */
     for (x = 0; x < o; x++)
         for (n = 1; n <= o; n++)
-            if (!solver->col[x*o+n-1]) {
+            if (!(solver->col[x] & LATIN_BIT(n))) {
                 ret = latin_solver_elim(solver, cubepos(x,0,n), o
 #ifdef STANDALONE_SOLVER
 					, "positional elimination,"
@@ -732,10 +761,7 @@ static int latin_solver_recurse
                  * An unfilled square. Count the number of
                  * possible digits in it.
                  */
-                count = 0;
-                for (n = 1; n <= o; n++)
-                    if (cube(x,y,n))
-                        count++;
+                count = count_bits(solver->cand[cubesq(x,y)]);
 
                 /*
                  * We should have found any impossibilities
@@ -805,6 +831,7 @@ static int latin_solver_recurse
             solver_recurse_depth++;
 #endif
 
+            genstat_count(GENSTAT_BACKTRACKS);
 	    if (ctxnew) {
 		newctx = ctxnew(ctx);
 	    } else {
@@ -877,6 +904,23 @@ static int latin_solver_recurse
     }
 }
 
+/* Print the candidates, by unpacking them into a cube of booleans. */
+static void latin_solver_debug_cand(struct latin_solver *solver)
+{
+#ifdef STANDALONE_SOLVER
+    if (solver_show_working > 1) {
+        int o = solver->o, sq, n;
+        unsigned char *cube = snewn(o*o*o, unsigned char);
+
+        for (sq = 0; sq < o*o; sq++)
+            for (n = 1; n <= o; n++)
+                cube[sq*o+n-1] = cube2(sq, n);
+        latin_solver_debug(cube, o);
+        sfree(cube);
+    }
+#endif
+}
+
 static int latin_solver_top(struct latin_solver *solver, int maxdiff,
 			    int diff_simple, int diff_set_0, int diff_set_1,
 			    int diff_forcing, int diff_recursive,
@@ -899,7 +943,7 @@ static int latin_solver_top(struct latin_solver *solver, int maxdiff,
 
 	cont:
 
-        latin_solver_debug(solver->cube, solver->o);
+        latin_solver_debug_cand(solver);
 
 	for (i = 0; i <= maxdiff; i++) {
 	    if (usersolvers[i])
@@ -1037,6 +1081,7 @@ int latin_solver_main(struct latin_solver *solver, int maxdiff,
     }
 #endif
 
+    genstat_count(GENSTAT_SOLVER_CALLS);
     diff = latin_solver_top(solver, maxdiff,
 			    diff_simple, diff_set_0, diff_set_1,
 			    diff_forcing, diff_recursive,
@@ -1068,21 +1113,32 @@ int latin_solver(digit *grid, int o, int maxdiff,
     return diff;
 }
 
+void latin_count_rejection(int ret, int diff)
+{
+    if (ret == diff_ambiguous)
+        genstat_count(GENSTAT_REJECT_AMBIGUOUS);
+    else if (ret == diff_unfinished)
+        genstat_count(GENSTAT_REJECT_TOO_HARD);
+    else if (ret == diff_impossible)
+        genstat_count(GENSTAT_REJECT_OTHER);
+    else if (ret < diff)
+        genstat_count(GENSTAT_REJECT_TOO_EASY);
+    else
+        genstat_count(GENSTAT_REJECT_TOO_HARD);
+}
+
 void latin_solver_debug(unsigned char *cube, int o)
 {
 #ifdef STANDALONE_SOLVER
     if (solver_show_working > 1) {
-        struct latin_solver ls, *solver = &ls;
         char *dbg;
         int x, y, i, c = 0;
 
-        ls.cube = cube; ls.o = o; /* for cube() to work */
-
         dbg = snewn(3*o*o*o, char);
         for (y = 0; y < o; y++) {
             for (x = 0; x < o; x++) {
                 for (i = 1; i <= o; i++) {
-                    if (cube(x,y,i))
+                    if (cube[(x*o+y)*o+i-1])
                         dbg[c++] = i + '0';
                     else
                         dbg[c++] = '.';
@@ -12,20 +12,33 @@ extern int solver_show_working, solver_recurse_depth;
 #endif
 
 struct latin_solver {
-  int o;                /* order of latin square */
-  unsigned char *cube;  /* o^3, indexed by x, y, and digit:
-                           true in that position indicates a possibility */
+  int o;                /* order of latin square (at most 32) */
+  unsigned long *cand;  /* o^2, indexed by x*o+y: the set of digits
+                           still possible in that square, with digit n
+                           in bit n-1 */
   digit *grid;          /* o^2, indexed by x and y: for final deductions */
 
-  unsigned char *row;   /* o^2: row[y*cr+n-1] true if n is in row y */
-  unsigned char *col;   /* o^2: col[x*cr+n-1] true if n is in col x */
+  unsigned long *row;   /* o: bit n-1 of row[y] set if n is in row y */
+  unsigned long *col;   /* o: bit n-1 of col[x] set if n is in col x */
 
 #ifdef STANDALONE_SOLVER
   char **names;         /* o: names[n-1] gives name of 'digit' n */
 #endif
 };
-#define cubepos(x,y,n) (((x)*solver->o+(y))*solver->o+(n)-1)
-#define cube(x,y,n) (solver->cube[cubepos(x,y,n)])
+/*
+ * The candidates make up a notional o^3 cube of booleans, indexed by
+ * x, y and digit; cubepos gives a position in it, as used by
+ * latin_solver_elim and latin_solver_set. cubesq gives the index of
+ * a square in cand[]. cube and cube2 test a candidate, and
+ * cubeclear and cubeclear2 rule one out.
+ */
+#define LATIN_BIT(n) (1UL << ((n)-1))
+#define cubesq(x,y) ((x)*solver->o+(y))
+#define cubepos(x,y,n) (cubesq(x,y)*solver->o+(n)-1)
+#define cube2(sq,n) ((solver->cand[sq] & LATIN_BIT(n)) != 0)
+#define cube(x,y,n) cube2(cubesq(x,y),n)
+#define cubeclear2(sq,n) (solver->cand[sq] &= ~LATIN_BIT(n))
+#define cubeclear(x,y,n) cubeclear2(cubesq(x,y),n)
 
 #define gridpos(x,y) ((y)*solver->o+(x))
 #define grid(x,y) (solver->grid[gridpos(x,y)])
@@ -107,6 +120,11 @@ int latin_solver_main(struct latin_solver *solver, int maxdiff,
 		      usersolver_t const *usersolvers, validator_t valid,
                       void *ctx, ctxnew_t ctxnew, ctxfree_t ctxfree);
 
+/* For generators: report to genstats why a candidate was rejected,
+ * given what the solver returned and the difficulty that was wanted. */
+void latin_count_rejection(int ret, int diff);
+
+/* Print a cube of o^3 booleans, laid out as described above. */
 void latin_solver_debug(unsigned char *cube, int o);
 
 /* --- Generation and checking --- */
@@ -1870,6 +1870,7 @@ struct game_drawstate {
     int w, h;
     unsigned int *flags;         /* width * height */
     bool started;
+    bool draw_blobs_when_lit;
 };
 
 
@@ -2060,6 +2061,12 @@ static game_drawstate *game_new_drawstate(drawing *dr, const game_state *state)
 
     ds->started = false;
 
+    {
+        char *env = getenv("LIGHTUP_LIT_BLOBS");
+        ds->draw_blobs_when_lit = (!env || (env[0] == 'y' ||
+                                            env[0] == 'Y'));
+    }
+
     return ds;
 }
 
@@ -2141,13 +2148,7 @@ static void tile_redraw(drawing *dr, game_drawstate *ds,
             draw_circle(dr, dx + TILE_SIZE/2, dy + TILE_SIZE/2, TILE_RADIUS,
                         lcol, COL_BLACK);
         } else if ((ds_flags & DF_IMPOSSIBLE)) {
-            static int draw_blobs_when_lit = -1;
-            if (draw_blobs_when_lit < 0) {
-		char *env = getenv("LIGHTUP_LIT_BLOBS");
-		draw_blobs_when_lit = (!env || (env[0] == 'y' ||
-                                                env[0] == 'Y'));
-            }
-            if (!(ds_flags & DF_LIT) || draw_blobs_when_lit) {
+            if (!(ds_flags & DF_LIT) || ds->draw_blobs_when_lit) {
                 int rlen = TILE_SIZE / 4;
                 draw_rect(dr, dx + TILE_SIZE/2 - rlen/2,
                           dy + TILE_SIZE/2 - rlen/2,
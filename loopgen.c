@@ -72,6 +72,17 @@ static int black_sort_cmpfn(void *v1, void *v2)
     return generic_sort_cmpfn(v1, v2, offsetof(struct face_score,black_score));
 }
 
+/* As FACE_COLOUR, but taking a face index, with -1 for the infinite
+ * face as in the grid's index arrays. */
+#define FACE_INDEX_COLOUR(fi) ( (fi) < 0 ? FACE_BLACK : board[fi] )
+
+/* The face on the other side of edge 'e' from face 'fi'. */
+static inline int face_across(const grid *g, int e, int fi)
+{
+    const int *ef = g->edge_faces + 2*e;
+    return ef[0] == fi ? ef[1] : ef[0];
+}
+
 /* 'board' is an array of enum face_colour, indicating which faces are
  * currently black/white/grey.  'colour' is FACE_WHITE or FACE_BLACK.
  * Returns whether it's legal to colour the given face with this colour. */
@@ -89,10 +100,9 @@ static bool can_colour_face(grid *g, char* board, int face_index,
 
     /* Can only consider a face for colouring if it's adjacent to a face
      * with the same colour. */
-    for (i = 0; i < test_face->order; i++) {
-        grid_edge *e = test_face->edges[i];
-        grid_face *f = (e->face1 == test_face) ? e->face2 : e->face1;
-        if (FACE_COLOUR(f) == colour) {
+    for (i = g->face_start[face_index]; i < g->face_start[face_index+1]; i++) {
+        int f = face_across(g, g->face_edges[i], face_index);
+        if (FACE_INDEX_COLOUR(f) == colour) {
             found_same_coloured_neighbour = true;
             break;
         }
@@ -214,13 +224,11 @@ static int face_num_neighbours(grid *g, char *board, grid_face *face,
                                enum face_colour colour)
 {
     int colour_count = 0;
+    int fi = face - g->faces;
     int i;
-    grid_face *f;
-    grid_edge *e;
-    for (i = 0; i < face->order; i++) {
-        e = face->edges[i];
-        f = (e->face1 == face) ? e->face2 : e->face1;
-        if (FACE_COLOUR(f) == colour)
+    for (i = g->face_start[fi]; i < g->face_start[fi+1]; i++) {
+        int f = face_across(g, g->face_edges[i], fi);
+        if (FACE_INDEX_COLOUR(f) == colour)
             ++colour_count;
     }
     return colour_count;
@@ -230,6 +230,7 @@ struct game_drawstate {
     char *lines;
     bool *clue_error;
     bool *clue_satisfied;
+    bool draw_faint_lines;
 };
 
 static const char *validate_desc(const game_params *params, const char *desc);
@@ -300,13 +301,16 @@ static const struct {
     const char *aerr, *oerr;
 } grid_size_limits[] = { GRIDLIST(GRID_SIZES) };
 
-/* Generates a (dynamically allocated) new grid, according to the
- * type and size requested in params.  Does nothing if the grid is already
- * generated. */
+/* Returns a reference to a grid of the type and size requested in
+ * params.  Generating a game builds the same grid several times over
+ * (for new_game_desc, validate_desc and new_game), and a batch of games
+ * with fixed parameters builds the same one over and over, so this
+ * goes through the shared grid cache. */
 static grid *loopy_generate_grid(const game_params *params,
                                  const char *grid_desc)
 {
-    return grid_new(grid_types[params->type], params->w, params->h, grid_desc);
+    return grid_new_shared(grid_types[params->type], params->w, params->h,
+                           grid_desc);
 }
 
 /* ----------------------------------------------------------------------
@@ -958,6 +962,11 @@ static game_drawstate *game_new_drawstate(drawing *dr, const game_state *state)
     ds->texty = snewn(num_faces, int);
     ds->flashing = false;
 
+    {
+        char *env = getenv("LOOPY_FAINT_LINES");
+        ds->draw_faint_lines = (!env || (env[0] == 'y' || env[0] == 'Y'));
+    }
+
     memset(ds->lines, LINE_UNKNOWN, num_edges);
     memset(ds->clue_error, 0, num_faces * sizeof(bool));
     memset(ds->clue_satisfied, 0, num_faces * sizeof(bool));
@@ -1120,7 +1129,7 @@ static bool solver_set_line(solver_state *sstate, int i,
 {
     game_state *state = sstate->state;
     grid *g;
-    grid_edge *e;
+    const int *ed, *ef;
 
     assert(line_new != LINE_UNKNOWN);
 
@@ -1138,26 +1147,27 @@ static bool solver_set_line(solver_state *sstate, int i,
 #endif
 
     g = state->game_grid;
-    e = g->edges + i;
+    ed = g->edge_dots + 2*i;
+    ef = g->edge_faces + 2*i;
 
     /* Update the cache for both dots and both faces affected by this. */
     if (line_new == LINE_YES) {
-        sstate->dot_yes_count[e->dot1 - g->dots]++;
-        sstate->dot_yes_count[e->dot2 - g->dots]++;
-        if (e->face1) {
-            sstate->face_yes_count[e->face1 - g->faces]++;
+        sstate->dot_yes_count[ed[0]]++;
+        sstate->dot_yes_count[ed[1]]++;
+        if (ef[0] >= 0) {
+            sstate->face_yes_count[ef[0]]++;
         }
-        if (e->face2) {
-            sstate->face_yes_count[e->face2 - g->faces]++;
+        if (ef[1] >= 0) {
+            sstate->face_yes_count[ef[1]]++;
         }
     } else {
-        sstate->dot_no_count[e->dot1 - g->dots]++;
-        sstate->dot_no_count[e->dot2 - g->dots]++;
-        if (e->face1) {
-            sstate->face_no_count[e->face1 - g->faces]++;
+        sstate->dot_no_count[ed[0]]++;
+        sstate->dot_no_count[ed[1]]++;
+        if (ef[0] >= 0) {
+            sstate->face_no_count[ef[0]]++;
         }
-        if (e->face2) {
-            sstate->face_no_count[e->face2 - g->faces]++;
+        if (ef[1] >= 0) {
+            sstate->face_no_count[ef[1]]++;
         }
     }
 
@@ -1181,10 +1191,9 @@ static bool merge_dots(solver_state *sstate, int edge_index)
 {
     int i, j, len;
     grid *g = sstate->state->game_grid;
-    grid_edge *e = g->edges + edge_index;
 
-    i = e->dot1 - g->dots;
-    j = e->dot2 - g->dots;
+    i = g->edge_dots[2*edge_index];
+    j = g->edge_dots[2*edge_index+1];
 
     i = dsf_canonify(sstate->dotdsf, i);
     j = dsf_canonify(sstate->dotdsf, j);
@@ -1242,12 +1251,10 @@ static int dot_order(const game_state* state, int dot, char line_type)
 {
     int n = 0;
     grid *g = state->game_grid;
-    grid_dot *d = g->dots + dot;
     int i;
 
-    for (i = 0; i < d->order; i++) {
-        grid_edge *e = d->edges[i];
-        if (state->lines[e - g->edges] == line_type)
+    for (i = g->dot_start[dot]; i < g->dot_start[dot+1]; i++) {
+        if (state->lines[g->dot_edges[i]] == line_type)
             ++n;
     }
     return n;
@@ -1259,12 +1266,10 @@ static int face_order(const game_state* state, int face, char line_type)
 {
     int n = 0;
     grid *g = state->game_grid;
-    grid_face *f = g->faces + face;
     int i;
 
-    for (i = 0; i < f->order; i++) {
-        grid_edge *e = f->edges[i];
-        if (state->lines[e - g->edges] == line_type)
+    for (i = g->face_start[face]; i < g->face_start[face+1]; i++) {
+        if (state->lines[g->face_edges[i]] == line_type)
             ++n;
     }
     return n;
@@ -1278,17 +1283,15 @@ static bool dot_setall(solver_state *sstate, int dot,
     bool retval = false, r;
     game_state *state = sstate->state;
     grid *g;
-    grid_dot *d;
     int i;
 
     if (old_type == new_type)
         return false;
 
     g = state->game_grid;
-    d = g->dots + dot;
 
-    for (i = 0; i < d->order; i++) {
-        int line_index = d->edges[i] - g->edges;
+    for (i = g->dot_start[dot]; i < g->dot_start[dot+1]; i++) {
+        int line_index = g->dot_edges[i];
         if (state->lines[line_index] == old_type) {
             r = solver_set_line(sstate, line_index, new_type);
             assert(r);
@@ -1305,17 +1308,15 @@ static bool face_setall(solver_state *sstate, int face,
     bool retval = false, r;
     game_state *state = sstate->state;
     grid *g;
-    grid_face *f;
     int i;
 
     if (old_type == new_type)
         return false;
 
     g = state->game_grid;
-    f = g->faces + face;
 
-    for (i = 0; i < f->order; i++) {
-        int line_index = f->edges[i] - g->edges;
+    for (i = g->face_start[face]; i < g->face_start[face+1]; i++) {
+        int line_index = g->face_edges[i];
         if (state->lines[line_index] == old_type) {
             r = solver_set_line(sstate, line_index, new_type);
             assert(r);
@@ -1366,6 +1367,7 @@ static bool game_has_unique_soln(const game_state *state, int diff)
     solver_state *sstate_new;
     solver_state *sstate = new_solver_state((game_state *)state, diff);
 
+    genstat_count(GENSTAT_SOLVER_CALLS);
     sstate_new = solve_game_rec(sstate);
 
     assert(sstate_new->solver_status != SOLVER_MISTAKE);
@@ -1444,10 +1446,17 @@ static char *new_game_desc(const game_params *params, random_state *rs,
 
     /* Get a new random solvable board with all its clues filled in.  Yes, this
      * can loop for ever if the params are suitably unfavourable, but
-     * preventing games smaller than 4x4 seems to stop this happening */
-    do {
+     * preventing games smaller than 4x4 seems to stop this happening.
+     * (The solver can't distinguish boards that are ambiguous from ones
+     * that are too hard for it, so the rejections all count as the
+     * latter.) */
+    while (1) {
+        genstat_count(GENSTAT_ATTEMPTS);
         add_full_clues(state, rs);
-    } while (!game_has_unique_soln(state, params->diff));
+        if (game_has_unique_soln(state, params->diff))
+            break;
+        genstat_count(GENSTAT_REJECT_TOO_HARD);
+    }
 
     state_new = remove_clues(state, rs, params->diff);
     free_game(state);
@@ -1458,6 +1467,7 @@ static char *new_game_desc(const game_params *params, random_state *rs,
 #ifdef SHOW_WORKING
         fprintf(stderr, "Rejecting board, it is too easy\n");
 #endif
+        genstat_count(GENSTAT_REJECT_TOO_EASY);
         goto newboard_please;
     }
 
@@ -1817,19 +1827,19 @@ static bool check_completion(game_state *state)
  * the dot. */
 static int dline_index_from_dot(grid *g, grid_dot *d, int i)
 {
-    grid_edge *e = d->edges[i];
+    int di = d - g->dots;
+    int e = g->dot_edges[g->dot_start[di] + i];
     int ret;
 #ifdef DEBUG_DLINES
-    grid_edge *e2;
+    int e2;
     int i2 = i+1;
     if (i2 == d->order) i2 = 0;
-    e2 = d->edges[i2];
+    e2 = g->dot_edges[g->dot_start[di] + i2];
 #endif
-    ret = 2 * (e - g->edges) + ((e->dot1 == d) ? 1 : 0);
+    ret = 2 * e + ((g->edge_dots[2*e] == di) ? 1 : 0);
 #ifdef DEBUG_DLINES
     printf("dline_index_from_dot: d=%d,i=%d, edges [%d,%d] - %d\n",
-           (int)(d - g->dots), i, (int)(e - g->edges),
-           (int)(e2 - g->edges), ret);
+           di, i, e, e2, ret);
 #endif
     return ret;
 }
@@ -1839,20 +1849,20 @@ static int dline_index_from_dot(grid *g, grid_dot *d, int i)
  * of the dline will be f->dots[i] */
 static int dline_index_from_face(grid *g, grid_face *f, int i)
 {
-    grid_edge *e = f->edges[i];
-    grid_dot *d = f->dots[i];
+    int fs = g->face_start[f - g->faces];
+    int e = g->face_edges[fs + i];
+    int d = g->face_dots[fs + i];
     int ret;
 #ifdef DEBUG_DLINES
-    grid_edge *e2;
+    int e2;
     int i2 = i - 1;
     if (i2 < 0) i2 += f->order;
-    e2 = f->edges[i2];
+    e2 = g->face_edges[fs + i2];
 #endif
-    ret = 2 * (e - g->edges) + ((e->dot1 == d) ? 1 : 0);
+    ret = 2 * e + ((g->edge_dots[2*e] == d) ? 1 : 0);
 #ifdef DEBUG_DLINES
     printf("dline_index_from_face: f=%d,i=%d, edges [%d,%d] - %d\n",
-           (int)(f - g->faces), i, (int)(e - g->edges),
-           (int)(e2 - g->edges), ret);
+           (int)(f - g->faces), i, e, e2, ret);
 #endif
     return ret;
 }
@@ -1897,6 +1907,7 @@ static bool dline_set_opp_atleastone(solver_state *sstate,
 {
     game_state *state = sstate->state;
     grid *g = state->game_grid;
+    const int *de = g->dot_edges + g->dot_start[d - g->dots];
     int N = d->order;
     int opp, opp2;
     for (opp = 0; opp < N; opp++) {
@@ -1910,9 +1921,9 @@ static bool dline_set_opp_atleastone(solver_state *sstate,
         opp2 = opp + 1;
         if (opp2 == N) opp2 = 0;
         /* Check if opp, opp2 point to LINE_UNKNOWNs */
-        if (state->lines[d->edges[opp] - g->edges] != LINE_UNKNOWN)
+        if (state->lines[de[opp]] != LINE_UNKNOWN)
             continue;
-        if (state->lines[d->edges[opp2] - g->edges] != LINE_UNKNOWN)
+        if (state->lines[de[opp2]] != LINE_UNKNOWN)
             continue;
         /* Found opposite UNKNOWNS and they're next to each other */
         opp_dline_index = dline_index_from_dot(g, d, opp);
@@ -1934,18 +1945,18 @@ static bool face_setall_identical(solver_state *sstate, int face_index,
     bool retval = false;
     game_state *state = sstate->state;
     grid *g = state->game_grid;
-    grid_face *f = g->faces + face_index;
-    int N = f->order;
+    const int *fe = g->face_edges + g->face_start[face_index];
+    int N = g->faces[face_index].order;
     int i, j;
     int can1, can2;
     bool inv1, inv2;
 
     for (i = 0; i < N; i++) {
-        int line1_index = f->edges[i] - g->edges;
+        int line1_index = fe[i];
         if (state->lines[line1_index] != LINE_UNKNOWN)
             continue;
         for (j = i + 1; j < N; j++) {
-            int line2_index = f->edges[j] - g->edges;
+            int line2_index = fe[j];
             if (state->lines[line2_index] != LINE_UNKNOWN)
                 continue;
 
@@ -1964,14 +1975,13 @@ static bool face_setall_identical(solver_state *sstate, int face_index,
 /* Given a dot or face, and a count of LINE_UNKNOWNs, find them and
  * return the edge indices into e. */
 static void find_unknowns(game_state *state,
-    grid_edge **edge_list, /* Edge list to search (from a face or a dot) */
+    const int *edge_list, /* Edge list to search (from a face or a dot) */
     int expected_count, /* Number of UNKNOWNs (comes from solver's cache) */
     int *e /* Returned edge indices */)
 {
     int c = 0;
-    grid *g = state->game_grid;
     while (c < expected_count) {
-        int line_index = *edge_list - g->edges;
+        int line_index = *edge_list;
         if (state->lines[line_index] == LINE_UNKNOWN) {
             e[c] = line_index;
             c++;
@@ -1986,7 +1996,7 @@ static void find_unknowns(game_state *state,
  * Returns the difficulty level of the next solver that should be used,
  * or DIFF_MAX if no progress was made. */
 static int parity_deductions(solver_state *sstate,
-    grid_edge **edge_list, /* Edge list (from a face or a dot) */
+    const int *edge_list, /* Edge list (from a face or a dot) */
     int total_parity, /* Expected number of YESs modulo 2 (either 0 or 1) */
     int unknown_count)
 {
@@ -2299,6 +2309,7 @@ static int dline_deductions(solver_state *sstate)
         int maxs[MAX_FACE_SIZE][MAX_FACE_SIZE];
         int mins[MAX_FACE_SIZE][MAX_FACE_SIZE];
         grid_face *f = g->faces + i;
+        const int *fe = g->face_edges + g->face_start[i];
         int N = f->order;
         int j,m;
         int clue = state->clues[i];
@@ -2309,7 +2320,7 @@ static int dline_deductions(solver_state *sstate)
 
         /* Calculate the (j,j+1) entries */
         for (j = 0; j < N; j++) {
-            int edge_index = f->edges[j] - g->edges;
+            int edge_index = fe[j];
             int dline_index;
             enum line_state line1 = state->lines[edge_index];
             enum line_state line2;
@@ -2320,7 +2331,7 @@ static int dline_deductions(solver_state *sstate)
             mins[j][k] = (line1 == LINE_YES) ? 1 : 0;
             /* Calculate the (j,j+2) entries */
             dline_index = dline_index_from_face(g, f, k);
-            edge_index = f->edges[k] - g->edges;
+            edge_index = fe[k];
             line2 = state->lines[edge_index];
             k++;
             if (k >= N) k = 0;
@@ -2364,8 +2375,7 @@ static int dline_deductions(solver_state *sstate)
         /* See if we can make any deductions */
         for (j = 0; j < N; j++) {
             int k;
-            grid_edge *e = f->edges[j];
-            int line_index = e - g->edges;
+            int line_index = fe[j];
             int dline_index;
 
             if (state->lines[line_index] != LINE_UNKNOWN)
@@ -2399,8 +2409,7 @@ static int dline_deductions(solver_state *sstate)
              * in square grids. */
             if (sstate->diff >= DIFF_TRICKY) {
                 /* Now see if we can make dline deduction for edges{j,j+1} */
-                e = f->edges[k];
-                if (state->lines[e - g->edges] != LINE_UNKNOWN)
+                if (state->lines[fe[k]] != LINE_UNKNOWN)
                     /* Only worth doing this for an UNKNOWN,UNKNOWN pair.
                      * Dlines where one of the edges is known, are handled in the
                      * dot-deductions */
@@ -2433,6 +2442,7 @@ static int dline_deductions(solver_state *sstate)
 
     for (i = 0; i < g->num_dots; i++) {
         grid_dot *d = g->dots + i;
+        const int *de = g->dot_edges + g->dot_start[i];
         int N = d->order;
         int yes, no, unknown;
         int j;
@@ -2450,8 +2460,8 @@ static int dline_deductions(solver_state *sstate)
             k = j + 1;
             if (k >= N) k = 0;
             dline_index = dline_index_from_dot(g, d, j);
-            line1_index = d->edges[j] - g->edges;
-            line2_index = d->edges[k] - g->edges;
+            line1_index = de[j];
+            line2_index = de[k];
             line1 = state->lines[line1_index];
             line2 = state->lines[line2_index];
 
@@ -2548,7 +2558,7 @@ static int dline_deductions(solver_state *sstate)
                                 int opp_index;
                                 if (opp == j || opp == k)
                                     continue;
-                                opp_index = d->edges[opp] - g->edges;
+                                opp_index = de[opp];
                                 if (state->lines[opp_index] == LINE_UNKNOWN) {
                                     solver_set_line(sstate, opp_index,
                                                     LINE_YES);
@@ -2617,7 +2627,7 @@ static int linedsf_deductions(solver_state *sstate)
 
         /* Deductions with small number of LINE_UNKNOWNs, based on overall
          * parity of lines. */
-        diff_tmp = parity_deductions(sstate, g->faces[i].edges,
+        diff_tmp = parity_deductions(sstate, g->face_edges + g->face_start[i],
                                      (clue - yes) % 2, unknown);
         diff = min(diff, diff_tmp);
     }
@@ -2625,6 +2635,7 @@ static int linedsf_deductions(solver_state *sstate)
     /* ------ Dot deductions ------ */
     for (i = 0; i < g->num_dots; i++) {
         grid_dot *d = g->dots + i;
+        const int *de = g->dot_edges + g->dot_start[i];
         int N = d->order;
         int j;
         int yes, no, unknown;
@@ -2637,12 +2648,12 @@ static int linedsf_deductions(solver_state *sstate)
             int can1, can2;
             bool inv1, inv2;
             int j2;
-            line1_index = d->edges[j] - g->edges;
+            line1_index = de[j];
             if (state->lines[line1_index] != LINE_UNKNOWN)
                 continue;
             j2 = j + 1;
             if (j2 == N) j2 = 0;
-            line2_index = d->edges[j2] - g->edges;
+            line2_index = de[j2];
             if (state->lines[line2_index] != LINE_UNKNOWN)
                 continue;
             /* Infer dline flags from linedsf */
@@ -2669,7 +2680,7 @@ static int linedsf_deductions(solver_state *sstate)
         yes = sstate->dot_yes_count[i];
         no = sstate->dot_no_count[i];
         unknown = N - yes - no;
-        diff_tmp = parity_deductions(sstate, d->edges,
+        diff_tmp = parity_deductions(sstate, g->dot_edges + g->dot_start[i],
                                      yes % 2, unknown);
         diff = min(diff, diff_tmp);
     }
@@ -3024,18 +3035,19 @@ static char *interpret_move(const game_state *state, game_ui *ui,
     movebuf = snewn(movesize, char);
     movelen = sprintf(movebuf, "%d%c", i, (int)button_char);
     {
-        static enum { OFF, FIXED, ADAPTIVE, DUNNO } autofollow = DUNNO;
-        if (autofollow == DUNNO) {
-            const char *env = getenv("LOOPY_AUTOFOLLOW");
-            if (env && !strcmp(env, "off"))
-                autofollow = OFF;
-            else if (env && !strcmp(env, "fixed"))
-                autofollow = FIXED;
-            else if (env && !strcmp(env, "adaptive"))
-                autofollow = ADAPTIVE;
-            else
-                autofollow = OFF;
-        }
+        /*
+         * (We look this up afresh every time rather than caching it
+         * in a static, so as not to have any writable global state.
+         * It's only once per click.)
+         */
+        enum { OFF, FIXED, ADAPTIVE } autofollow;
+        const char *env = getenv("LOOPY_AUTOFOLLOW");
+        if (env && !strcmp(env, "fixed"))
+            autofollow = FIXED;
+        else if (env && !strcmp(env, "adaptive"))
+            autofollow = ADAPTIVE;
+        else
+            autofollow = OFF;
 
         if (autofollow != OFF) {
             int dotid;
@@ -3286,13 +3298,7 @@ static void game_redraw_line(drawing *dr, game_drawstate *ds,
     grid_to_screen(ds, g, e->dot2->x, e->dot2->y, &x2, &y2);
 
     if (line_colour == COL_FAINT) {
-	static int draw_faint_lines = -1;
-	if (draw_faint_lines < 0) {
-	    char *env = getenv("LOOPY_FAINT_LINES");
-	    draw_faint_lines = (!env || (env[0] == 'y' ||
-					 env[0] == 'Y'));
-	}
-	if (draw_faint_lines)
+	if (ds->draw_faint_lines)
 	    draw_line(dr, x1, y1, x2, y2, line_colour);
     } else {
 	draw_thick_line(dr, 3.0,
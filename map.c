@@ -40,12 +40,6 @@ bool verbose = false;
 #define FIVE (FOUR+1)
 #define SIX (FOUR+2)
 
-/*
- * Ghastly run-time configuration option, just for Gareth (again).
- */
-static int flash_type = -1;
-static float flash_length;
-
 /*
  * Difficulty levels. I do some macro ickery here to ensure that my
  * enum and the various forms of my name list always match up.
@@ -2278,11 +2272,20 @@ struct game_ui {
 
     int cur_x, cur_y, cur_lastmove;
     bool cur_visible, cur_moved;
+
+    /*
+     * Ghastly run-time configuration option, just for Gareth (again):
+     * the completion flash, from MAP_ALTERNATIVE_FLASH.
+     */
+    int flash_type;
+    float flash_length;
 };
 
 static game_ui *new_ui(const game_state *state)
 {
     game_ui *ui = snew(game_ui);
+    char *env;
+
     ui->dragx = ui->dragy = -1;
     ui->drag_colour = -2;
     ui->drag_pencil = 0;
@@ -2291,6 +2294,11 @@ static game_ui *new_ui(const game_state *state)
     ui->cur_visible = false;
     ui->cur_moved = false;
     ui->cur_lastmove = 0;
+
+    env = getenv("MAP_ALTERNATIVE_FLASH");
+    ui->flash_type = env ? atoi(env) : 0;
+    ui->flash_length = (ui->flash_type == 1 ? 0.50F : 0.30F);
+
     return ui;
 }
 
@@ -2880,10 +2888,10 @@ static void game_redraw(drawing *dr, game_drawstate *ds,
     }
 
     if (flashtime) {
-	if (flash_type == 1)
-	    flash = (int)(flashtime * FOUR / flash_length);
+	if (ui->flash_type == 1)
+	    flash = (int)(flashtime * FOUR / ui->flash_length);
 	else
-	    flash = 1 + (int)(flashtime * THREE / flash_length);
+	    flash = 1 + (int)(flashtime * THREE / ui->flash_length);
     } else
 	flash = -1;
 
@@ -2902,12 +2910,12 @@ static void game_redraw(drawing *dr, game_drawstate *ds,
 		bv = FOUR;
 
 	    if (flash >= 0) {
-		if (flash_type == 1) {
+		if (ui->flash_type == 1) {
 		    if (tv == flash)
 			tv = FOUR;
 		    if (bv == flash)
 			bv = FOUR;
-		} else if (flash_type == 2) {
+		} else if (ui->flash_type == 2) {
 		    if (flash % 2)
 			tv = bv = FOUR;
 		} else {
@@ -3037,15 +3045,7 @@ static float game_flash_length(const game_state *oldstate,
 {
     if (!oldstate->completed && newstate->completed &&
 	!oldstate->cheated && !newstate->cheated) {
-	if (flash_type < 0) {
-	    char *env = getenv("MAP_ALTERNATIVE_FLASH");
-	    if (env)
-		flash_type = atoi(env);
-	    else
-		flash_type = 0;
-	    flash_length = (flash_type == 1 ? 0.50F : 0.30F);
-	}
-	return flash_length;
+	return ui->flash_length;
     } else
 	return 0.0F;
 }
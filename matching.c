@@ -319,6 +319,359 @@ int matching(int nl, int nr, int **adjlists, int *adjsizes,
     return ret;
 }
 
+/*
+ * The incremental matcher. The graph is kept as an adjacency list per
+ * left vertex, in arrays that grow as needed. The search scratch is
+ * allocated once, and its 'visited' marks are generation stamps, so
+ * that nothing needs clearing at the start of each search.
+ */
+struct imatching {
+    int nl, nr;
+    int **adj, *deg, *cap;
+    int *LtoR, *RtoL;
+    int size;
+
+    int *Lqueue, *Rparent;
+    unsigned *Lstamp, *Rstamp, stamp;
+};
+
+imatching *imatching_new(int nl, int nr)
+{
+    imatching *im = snew(imatching);
+    int i;
+
+    im->nl = nl;
+    im->nr = nr;
+    im->adj = snewn(nl, int *);
+    im->deg = snewn(nl, int);
+    im->cap = snewn(nl, int);
+    im->LtoR = snewn(nl, int);
+    im->RtoL = snewn(nr, int);
+    im->Lqueue = snewn(nl, int);
+    im->Rparent = snewn(nr, int);
+    im->Lstamp = snewn(nl, unsigned);
+    im->Rstamp = snewn(nr, unsigned);
+    for (i = 0; i < nl; i++) {
+        im->adj[i] = NULL;
+        im->deg[i] = im->cap[i] = 0;
+        im->LtoR[i] = -1;
+        im->Lstamp[i] = 0;
+    }
+    for (i = 0; i < nr; i++) {
+        im->RtoL[i] = -1;
+        im->Rstamp[i] = 0;
+    }
+    im->size = 0;
+    im->stamp = 0;
+    return im;
+}
+
+void imatching_free(imatching *im)
+{
+    int i;
+
+    for (i = 0; i < im->nl; i++)
+        sfree(im->adj[i]);
+    sfree(im->adj);
+    sfree(im->deg);
+    sfree(im->cap);
+    sfree(im->LtoR);
+    sfree(im->RtoL);
+    sfree(im->Lqueue);
+    sfree(im->Rparent);
+    sfree(im->Lstamp);
+    sfree(im->Rstamp);
+    sfree(im);
+}
+
+static void imatching_new_stamp(imatching *im)
+{
+    if (++im->stamp == 0) {
+        /* Wrapped round: clear out the old stamps and start again. */
+        int i;
+        for (i = 0; i < im->nl; i++)
+            im->Lstamp[i] = 0;
+        for (i = 0; i < im->nr; i++)
+            im->Rstamp[i] = 0;
+        im->stamp = 1;
+    }
+}
+
+/*
+ * Breadth-first search, from all the free left vertices at once, for
+ * a single augmenting path; apply it if there is one. The matching was
+ * maximum before the one edge change that led to this call, so one
+ * path is all there can be.
+ */
+static bool imatching_augment(imatching *im)
+{
+    int qhead = 0, qtail = 0, L, R, i;
+
+    if (im->size == im->nl || im->size == im->nr)
+        return false;
+
+    imatching_new_stamp(im);
+    for (L = 0; L < im->nl; L++)
+        if (im->LtoR[L] == -1) {
+            im->Lstamp[L] = im->stamp;
+            im->Lqueue[qtail++] = L;
+        }
+
+    while (qhead < qtail) {
+        L = im->Lqueue[qhead++];
+        for (i = 0; i < im->deg[L]; i++) {
+            R = im->adj[L][i];
+            if (im->Rstamp[R] == im->stamp)
+                continue;
+            im->Rstamp[R] = im->stamp;
+            im->Rparent[R] = L;
+
+            if (im->RtoL[R] == -1) {
+                /*
+                 * Found a free right vertex. Walk back to the free
+                 * left vertex we started from, moving each left
+                 * vertex's match to the right vertex we reached it
+                 * from.
+                 */
+                while (R != -1) {
+                    int L2 = im->Rparent[R], R2 = im->LtoR[L2];
+                    im->LtoR[L2] = R;
+                    im->RtoL[R] = L2;
+                    R = R2;
+                }
+                im->size++;
+                return true;
+            }
+
+            if (im->Lstamp[im->RtoL[R]] != im->stamp) {
+                im->Lstamp[im->RtoL[R]] = im->stamp;
+                im->Lqueue[qtail++] = im->RtoL[R];
+            }
+        }
+    }
+    return false;
+}
+
+void imatching_add_edge(imatching *im, int L, int R)
+{
+    int i;
+
+    assert(0 <= L && L < im->nl && 0 <= R && R < im->nr);
+    for (i = 0; i < im->deg[L]; i++)
+        assert(im->adj[L][i] != R);
+
+    if (im->deg[L] == im->cap[L]) {
+        im->cap[L] = im->cap[L] * 3 / 2 + 4;
+        im->adj[L] = sresize(im->adj[L], im->cap[L], int);
+    }
+    im->adj[L][im->deg[L]++] = R;
+
+    if (im->LtoR[L] == -1 && im->RtoL[R] == -1) {
+        im->LtoR[L] = R;
+        im->RtoL[R] = L;
+        im->size++;
+    } else {
+        imatching_augment(im);
+    }
+}
+
+void imatching_remove_edge(imatching *im, int L, int R)
+{
+    int i;
+
+    assert(0 <= L && L < im->nl && 0 <= R && R < im->nr);
+    for (i = 0; i < im->deg[L]; i++)
+        if (im->adj[L][i] == R)
+            break;
+    assert(i < im->deg[L]);
+    im->adj[L][i] = im->adj[L][--im->deg[L]];
+
+    if (im->LtoR[L] == R) {
+        im->LtoR[L] = -1;
+        im->RtoL[R] = -1;
+        im->size--;
+        imatching_augment(im);
+    }
+}
+
+int imatching_size(const imatching *im)
+{
+    return im->size;
+}
+
+int imatching_left(const imatching *im, int L)
+{
+    assert(0 <= L && L < im->nl);
+    return im->LtoR[L];
+}
+
+int imatching_right(const imatching *im, int R)
+{
+    assert(0 <= R && R < im->nr);
+    return im->RtoL[R];
+}
+
+void imatching_forced(imatching *im, bool *forced)
+{
+    int nl = im->nl, nr = im->nr;
+    int *Rstart, *Radj, *index, *low, *stack, *cstack, *cpos;
+    bool *onstack;
+    int L, R, i, n, sp, csp, counter;
+
+    for (L = 0; L < nl; L++)
+        forced[L] = (im->LtoR[L] != -1);
+
+    /*
+     * Swapping along an alternating path from a free left vertex can
+     * unmatch any left vertex the path reaches, so none of those have
+     * forced edges. The BFS follows unmatched edges left to right and
+     * matched ones back again.
+     */
+    imatching_new_stamp(im);
+    n = 0;
+    for (L = 0; L < nl; L++)
+        if (im->LtoR[L] == -1) {
+            im->Lstamp[L] = im->stamp;
+            im->Lqueue[n++] = L;
+        }
+    for (i = 0; i < n; i++) {
+        int j;
+        L = im->Lqueue[i];
+        for (j = 0; j < im->deg[L]; j++) {
+            int L2 = im->RtoL[im->adj[L][j]];
+            if (L2 != -1 && im->Lstamp[L2] != im->stamp) {
+                im->Lstamp[L2] = im->stamp;
+                im->Lqueue[n++] = L2;
+                forced[L2] = false;
+            }
+        }
+    }
+
+    /*
+     * The same from the free right vertices, for which we need the
+     * graph's adjacency lists the other way round.
+     */
+    Rstart = snewn(nr + 1, int);
+    for (R = 0; R <= nr; R++)
+        Rstart[R] = 0;
+    for (L = 0; L < nl; L++)
+        for (i = 0; i < im->deg[L]; i++)
+            Rstart[im->adj[L][i] + 1]++;
+    for (R = 0; R < nr; R++)
+        Rstart[R+1] += Rstart[R];
+    Radj = snewn(Rstart[nr] + 1, int);
+    cpos = snewn(nr + 1, int);
+    for (R = 0; R < nr; R++)
+        cpos[R] = Rstart[R];
+    for (L = 0; L < nl; L++)
+        for (i = 0; i < im->deg[L]; i++)
+            Radj[cpos[im->adj[L][i]]++] = L;
+
+    stack = snewn(nr + 1, int);
+    imatching_new_stamp(im);
+    n = 0;
+    for (R = 0; R < nr; R++)
+        if (im->RtoL[R] == -1) {
+            im->Rstamp[R] = im->stamp;
+            stack[n++] = R;
+        }
+    for (i = 0; i < n; i++) {
+        int j;
+        R = stack[i];
+        for (j = Rstart[R]; j < Rstart[R+1]; j++) {
+            int R2 = im->LtoR[Radj[j]];
+            if (R2 != -1 && im->Rstamp[R2] != im->stamp) {
+                im->Rstamp[R2] = im->stamp;
+                stack[n++] = R2;
+                forced[im->RtoL[R2]] = false;
+            }
+        }
+    }
+    sfree(stack);
+    sfree(cpos);
+    sfree(Radj);
+    sfree(Rstart);
+
+    /*
+     * Finally, a matched edge can be exchanged round an alternating
+     * cycle. Contract each matched edge to its left vertex, giving a
+     * directed graph in which L points to the partner of each
+     * unmatched neighbour of L; the edges on alternating cycles are
+     * those whose left vertex is in a strongly connected component of
+     * more than one vertex. Find those by Tarjan's algorithm, done
+     * iteratively: cstack holds the current DFS path and cpos the
+     * progress through each vertex's adjacency list.
+     */
+    index = snewn(nl, int);
+    low = snewn(nl, int);
+    stack = snewn(nl, int);
+    cstack = snewn(nl, int);
+    cpos = snewn(nl, int);
+    onstack = snewn(nl, bool);
+    for (L = 0; L < nl; L++) {
+        index[L] = -1;
+        onstack[L] = false;
+    }
+    counter = sp = 0;
+    for (L = 0; L < nl; L++) {
+        if (index[L] != -1 || im->LtoR[L] == -1)
+            continue;
+
+        csp = 0;
+        cstack[csp++] = L;
+        cpos[L] = 0;
+        index[L] = low[L] = counter++;
+        stack[sp++] = L;
+        onstack[L] = true;
+
+        while (csp > 0) {
+            int v = cstack[csp-1], w = -1;
+
+            while (cpos[v] < im->deg[v]) {
+                R = im->adj[v][cpos[v]++];
+                if (R != im->LtoR[v] && (w = im->RtoL[R]) != -1)
+                    break;
+                w = -1;
+            }
+
+            if (w != -1) {
+                if (index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    stack[sp++] = w;
+                    onstack[w] = true;
+                    cpos[w] = 0;
+                    cstack[csp++] = w;
+                } else if (onstack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            /* Finished with v. */
+            csp--;
+            if (csp > 0 && low[v] < low[cstack[csp-1]])
+                low[cstack[csp-1]] = low[v];
+            if (low[v] == index[v]) {
+                int w2, size = 0, top = sp;
+                do {
+                    w2 = stack[--sp];
+                    onstack[w2] = false;
+                    size++;
+                } while (w2 != v);
+                if (size > 1)
+                    for (i = sp; i < top; i++)
+                        forced[stack[i]] = false;
+            }
+        }
+    }
+    sfree(index);
+    sfree(low);
+    sfree(stack);
+    sfree(cstack);
+    sfree(cpos);
+    sfree(onstack);
+}
+
 #ifdef STANDALONE_MATCHING_TEST
 
 /*
@@ -681,6 +1034,96 @@ void test_subsets(void)
     }
 }
 
+/*
+ * Check the incremental matcher against the from-scratch one, on
+ * small random graphs undergoing random edge insertions and
+ * deletions. Every so often, also check imatching_forced against the
+ * definition: an edge of the matching is in every maximum matching
+ * if and only if deleting it makes the maximum matching smaller.
+ */
+static int max_matching_size(int nl_, int nr_, bool *edges)
+{
+    int L, R, ret;
+    int **lists = snewn(nl_, int *), *sizes = snewn(nl_, int);
+    int *data = snewn(nl_ * nr_ + 1, int), *p = data;
+
+    for (L = 0; L < nl_; L++) {
+        lists[L] = p;
+        for (R = 0; R < nr_; R++)
+            if (edges[L*nr_+R])
+                *p++ = R;
+        sizes[L] = p - lists[L];
+    }
+    ret = matching(nl_, nr_, lists, sizes, NULL, NULL, NULL);
+    sfree(lists);
+    sfree(sizes);
+    sfree(data);
+    return ret;
+}
+
+void test_incremental(void)
+{
+    static const char seed[] = "incremental matching test seed";
+    random_state *trs = random_new(seed, strlen(seed));
+    int graph, step;
+
+    for (graph = 0; graph < 2000; graph++) {
+        int nl_ = 1 + random_upto(trs, 10), nr_ = 1 + random_upto(trs, 10);
+        int density = 1 + random_upto(trs, 4);
+        bool *edges = snewn(nl_ * nr_, bool), *forced = snewn(nl_, bool);
+        imatching *im = imatching_new(nl_, nr_);
+        int L, R;
+
+        for (L = 0; L < nl_ * nr_; L++)
+            edges[L] = false;
+
+        for (step = 0; step < 100; step++) {
+            L = random_upto(trs, nl_);
+            R = random_upto(trs, nr_);
+            if (!edges[L*nr_+R]) {
+                /* Keep the graph at about the chosen density. */
+                if (random_upto(trs, density) == 0) {
+                    imatching_add_edge(im, L, R);
+                    edges[L*nr_+R] = true;
+                }
+            } else if (random_upto(trs, 4) == 0) {
+                imatching_remove_edge(im, L, R);
+                edges[L*nr_+R] = false;
+            }
+
+            assert(imatching_size(im) == max_matching_size(nl_, nr_, edges));
+            for (L = 0; L < nl_; L++) {
+                R = imatching_left(im, L);
+                if (R != -1) {
+                    assert(edges[L*nr_+R]);
+                    assert(imatching_right(im, R) == L);
+                }
+            }
+
+            if (step % 10 == 9) {
+                imatching_forced(im, forced);
+                for (L = 0; L < nl_; L++) {
+                    bool expected = false;
+                    R = imatching_left(im, L);
+                    if (R != -1) {
+                        edges[L*nr_+R] = false;
+                        expected = (max_matching_size(nl_, nr_, edges) <
+                                    imatching_size(im));
+                        edges[L*nr_+R] = true;
+                    }
+                    assert(forced[L] == expected);
+                }
+            }
+        }
+
+        imatching_free(im);
+        sfree(edges);
+        sfree(forced);
+    }
+    random_free(trs);
+    printf("incremental matching: OK\n");
+}
+
 int main(int argc, char **argv)
 {
     static const char stdin_identifier[] = "<standard input>";
@@ -745,6 +1188,7 @@ int main(int argc, char **argv)
         }
 
         test_subsets();
+        test_incremental();
     }
 
     return 0;
@@ -77,4 +77,36 @@ size_t matching_scratch_size(int nl, int nr);
 int matching(int nl, int nr, int **adjlists, int *adjsizes,
              random_state *rs, int *outl, int *outr);
 
+/*
+ * Incremental version, for callers that make a series of small
+ * changes to one graph and want a maximum matching after each.
+ *
+ * An imatching holds a bipartite graph on nl left and nr right
+ * vertices, initially with no edges, along with a maximum matching
+ * of it. Adding or removing an edge repairs the matching by looking
+ * for a single augmenting path, which takes time linear in the size
+ * of the graph, rather than recomputing it from scratch. Each edge
+ * may be added at most once, and only edges present may be removed.
+ *
+ * imatching_left(L) returns the right vertex matched to L, or -1, and
+ * imatching_right(R) is the reverse.
+ *
+ * imatching_forced() works out, for every left vertex L at once,
+ * whether L's edge in the current matching is in _every_ maximum
+ * matching of the graph, and writes the answer into forced[L]. (It
+ * writes false for unmatched L.) An edge not in the current matching
+ * is in every maximum matching only if it's the only one at both
+ * ends, so the question is only interesting for matched edges. This
+ * also takes linear time.
+ */
+typedef struct imatching imatching;
+imatching *imatching_new(int nl, int nr);
+void imatching_free(imatching *im);
+void imatching_add_edge(imatching *im, int L, int R);
+void imatching_remove_edge(imatching *im, int L, int R);
+int imatching_size(const imatching *im);
+int imatching_left(const imatching *im, int L);
+int imatching_right(const imatching *im, int R);
+void imatching_forced(imatching *im, bool *forced);
+
 #endif /* MATCHING_MATCHING_H */
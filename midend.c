@@ -62,6 +62,7 @@ struct midend {
      * may also be typed directly into Mines if you like.)
      */
     char *desc, *privdesc, *seedstr;
+    bool fastseed;                     /* seedstr is for random_new_fast */
     char *aux_info;
     enum { GOT_SEED, GOT_DESC, GOT_NOTHING } genmode;
 
@@ -93,6 +94,16 @@ struct midend {
 
     void (*game_id_change_notify_function)(void *);
     void *game_id_change_notify_ctx;
+
+    /*
+     * Optional instrumentation of the phases of setting up a game;
+     * see midend_set_phase_clock().
+     */
+    midend_clock_fn phase_clock;
+    void *phase_clock_ctx;
+    int phase_count[MIDEND_NPHASES];
+    double phase_wall[MIDEND_NPHASES], phase_cpu[MIDEND_NPHASES];
+    struct genstats genstats;          /* reported by new_desc() */
 };
 
 #define ensure(me) do { \
@@ -111,6 +122,7 @@ struct midend {
  */
 struct deserialise_data {
     char *seed, *parstr, *desc, *privdesc;
+    bool fastseed;
     char *auxinfo, *uistr, *cparstr;
     float elapsed;
     game_params *params, *cparams;
@@ -172,6 +184,9 @@ midend *midend_new(frontend *fe, const game *ourgame,
     me->params = ourgame->default_params();
     me->game_id_change_notify_function = NULL;
     me->game_id_change_notify_ctx = NULL;
+    me->phase_clock = NULL;
+    me->phase_clock_ctx = NULL;
+    midend_reset_phase_times(me);
     me->encoded_presets = NULL;
     me->n_encoded_presets = 0;
 
@@ -194,6 +209,7 @@ midend *midend_new(frontend *fe, const game *ourgame,
     me->curparams = NULL;
     me->desc = me->privdesc = NULL;
     me->seedstr = NULL;
+    me->fastseed = false;
     me->aux_info = NULL;
     me->genmode = GOT_NOTHING;
     me->drawstate = NULL;
@@ -420,8 +436,142 @@ static void newgame_serialise_write(void *ctx, const void *buf, int len)
     ser->len = new_len;
 }
 
+/*
+ * Instrumentation of the phases of setting up a new game, for front
+ * ends that want to know where the time is going (e.g. to benchmark
+ * puzzle generation). A front end supplies a clock function reporting
+ * the current wall-clock and CPU time in seconds, and the midend then
+ * accumulates the time spent in each phase until told to reset.
+ */
+void midend_set_phase_clock(midend *me, midend_clock_fn clock, void *ctx)
+{
+    me->phase_clock = clock;
+    me->phase_clock_ctx = ctx;
+}
+
+void midend_reset_phase_times(midend *me)
+{
+    int i;
+
+    for (i = 0; i < MIDEND_NPHASES; i++) {
+        me->phase_count[i] = 0;
+        me->phase_wall[i] = me->phase_cpu[i] = 0.0;
+    }
+    genstats_reset(&me->genstats);
+}
+
+int midend_get_phase_times(midend *me, int phase, double *wall, double *cpu)
+{
+    assert(phase >= 0 && phase < MIDEND_NPHASES);
+    *wall = me->phase_wall[phase];
+    *cpu = me->phase_cpu[phase];
+    return me->phase_count[phase];
+}
+
+/*
+ * The counters reported by the game's generator (see genstats.c),
+ * accumulated over every game generated since the last call to
+ * midend_reset_phase_times().
+ */
+const struct genstats *midend_get_genstats(midend *me)
+{
+    return &me->genstats;
+}
+
+const char *midend_phase_name(int phase)
+{
+    static const char *const names[MIDEND_NPHASES] = {
+        "desc", "validate", "newgame", "auxcheck", "solve",
+    };
+    assert(phase >= 0 && phase < MIDEND_NPHASES);
+    return names[phase];
+}
+
+static void midend_phase_begin(midend *me, double *wall, double *cpu)
+{
+    if (me->phase_clock)
+        me->phase_clock(me->phase_clock_ctx, wall, cpu);
+}
+
+static void midend_phase_end(midend *me, int phase, double wall, double cpu)
+{
+    if (me->phase_clock) {
+        double endwall, endcpu;
+        me->phase_clock(me->phase_clock_ctx, &endwall, &endcpu);
+        me->phase_count[phase]++;
+        me->phase_wall[phase] += endwall - wall;
+        me->phase_cpu[phase] += endcpu - cpu;
+    }
+}
+
+/*
+ * A random-seed game id with this character at the end of its params
+ * (as in '9dx~#123456') generates its game using the fast random
+ * number generator (see random.c); plain 'params#seed' ids use the
+ * SHA-1 one, as every id did before the fast one existed, so old ids
+ * still produce the same games. The marker can't go in the seed,
+ * because any text at all is a valid seed and so any marker there
+ * might already be in use; but no game's encode_params writes a '~'.
+ */
+#define FAST_SEED_MARKER '~'
+
+static random_state *midend_seed_random(midend *me)
+{
+    if (me->fastseed)
+        return random_new_fast(me->seedstr, strlen(me->seedstr));
+    else
+        return random_new(me->seedstr, strlen(me->seedstr));
+}
+
+/*
+ * The params part of the current random-seed game id: the full
+ * parameters, followed by FAST_SEED_MARKER if necessary.
+ */
+static char *midend_seed_params(midend *me)
+{
+    char *parstr = me->ourgame->encode_params(me->curparams, true);
+
+    if (me->fastseed) {
+        int len = strlen(parstr);
+        parstr = sresize(parstr, len + 2, char);
+        parstr[len] = FAST_SEED_MARKER;
+        parstr[len+1] = '\0';
+    }
+    return parstr;
+}
+
+static void midend_new_seed(midend *me)
+{
+    /*
+     * Generate a new random seed. 15 digits comes to about 48 bits,
+     * which should be more than enough.
+     *
+     * I'll avoid putting a leading zero on the number, just in case
+     * it confuses anybody who thinks it's processed as an integer
+     * rather than a string.
+     *
+     * Seeds we invent ourselves are always for the fast random
+     * number generator.
+     */
+    char newseed[16];
+    int i;
+    newseed[15] = '\0';
+    newseed[0] = '1' + (char)random_upto(me->random, 9);
+    for (i = 1; i < 15; i++)
+        newseed[i] = '0' + (char)random_upto(me->random, 10);
+    sfree(me->seedstr);
+    me->seedstr = dupstr(newseed);
+    me->fastseed = true;
+
+    if (me->curparams)
+        me->ourgame->free_params(me->curparams);
+    me->curparams = me->ourgame->dup_params(me->params);
+}
+
 void midend_new_game(midend *me)
 {
+    double wall = 0.0, cpu = 0.0;
+
     me->newgame_undo.len = 0;
     if (me->newgame_can_store_undo) {
         /*
@@ -451,30 +601,12 @@ void midend_new_game(midend *me)
 	me->genmode = GOT_NOTHING;
     } else {
         random_state *rs;
+        struct genstats *prevstats;
 
         if (me->genmode == GOT_SEED) {
             me->genmode = GOT_NOTHING;
         } else {
-            /*
-             * Generate a new random seed. 15 digits comes to about
-             * 48 bits, which should be more than enough.
-             * 
-             * I'll avoid putting a leading zero on the number,
-             * just in case it confuses anybody who thinks it's
-             * processed as an integer rather than a string.
-             */
-            char newseed[16];
-            int i;
-            newseed[15] = '\0';
-            newseed[0] = '1' + (char)random_upto(me->random, 9);
-            for (i = 1; i < 15; i++)
-                newseed[i] = '0' + (char)random_upto(me->random, 10);
-            sfree(me->seedstr);
-            me->seedstr = dupstr(newseed);
-
-	    if (me->curparams)
-		me->ourgame->free_params(me->curparams);
-	    me->curparams = me->ourgame->dup_params(me->params);
+            midend_new_seed(me);
         }
 
 	sfree(me->desc);
@@ -482,15 +614,19 @@ void midend_new_game(midend *me)
         sfree(me->aux_info);
 	me->aux_info = NULL;
 
-        rs = random_new(me->seedstr, strlen(me->seedstr));
+        rs = midend_seed_random(me);
 	/*
 	 * If this midend has been instantiated without providing a
 	 * drawing API, it is non-interactive. This means that it's
 	 * being used for bulk game generation, and hence we should
 	 * pass the non-interactive flag to new_desc.
 	 */
+        midend_phase_begin(me, &wall, &cpu);
+        prevstats = genstats_collect(&me->genstats);
         me->desc = me->ourgame->new_desc(me->curparams, rs,
 					 &me->aux_info, (me->drawing != NULL));
+        genstats_collect(prevstats);
+        midend_phase_end(me, MIDEND_PHASE_NEW_DESC, wall, cpu);
 	me->privdesc = NULL;
         random_free(rs);
     }
@@ -511,8 +647,10 @@ void midend_new_game(midend *me)
      * case where a game has failed to encode a play-time parameter
      * in the non-full version of encode_params().
      */
+    midend_phase_begin(me, &wall, &cpu);
     me->states[me->nstates].state =
 	me->ourgame->new_game(me, me->params, me->desc);
+    midend_phase_end(me, MIDEND_PHASE_NEW_GAME, wall, cpu);
 
     /*
      * As part of our commitment to self-testing, test the aux
@@ -524,6 +662,7 @@ void midend_new_game(midend *me)
         char *movestr;
 
 	msg = NULL;
+        midend_phase_begin(me, &wall, &cpu);
 	movestr = me->ourgame->solve(me->states[0].state,
 				     me->states[0].state,
 				     me->aux_info, &msg);
@@ -532,6 +671,7 @@ void midend_new_game(midend *me)
 	assert(s);
 	me->ourgame->free_game(s);
 	sfree(movestr);
+        midend_phase_end(me, MIDEND_PHASE_AUX_CHECK, wall, cpu);
     }
 
     me->states[me->nstates].movestr = NULL;
@@ -1571,20 +1711,22 @@ config_item *midend_get_config(midend *me, int which, char **wintitle)
          * For CFG_DESC the text going in here will be a string
          * encoding of the restricted parameters, plus a colon,
          * plus the game description. For CFG_SEED it will be the
-         * full parameters, plus a hash, plus the random seed data.
+         * full parameters (and FAST_SEED_MARKER if the seed is for
+         * the fast generator), plus a hash, plus the random seed data.
          * Either of these is a valid full game ID (although only
          * the former is likely to persist across many code
          * changes).
          */
-        parstr = me->ourgame->encode_params(me->curparams, which == CFG_SEED);
-        assert(parstr);
         if (which == CFG_DESC) {
+            parstr = me->ourgame->encode_params(me->curparams, false);
             rest = me->desc ? me->desc : "";
             sep = ':';
         } else {
+            parstr = midend_seed_params(me);
             rest = me->seedstr ? me->seedstr : "";
             sep = '#';
         }
+        assert(parstr);
         ret[0].u.string.sval = snewn(strlen(parstr) + strlen(rest) + 2, char);
         sprintf(ret[0].u.string.sval, "%s%c%s", parstr, sep, rest);
         sfree(parstr);
@@ -1605,7 +1747,8 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
     char *par = NULL;
     const char *desc, *seed;
     game_params *newcurparams, *newparams, *oldparams1, *oldparams2;
-    bool free_params;
+    bool free_params, fastseed = false;
+    double wall = 0.0, cpu = 0.0;
 
     seed = strchr(id, '#');
     desc = strchr(id, ':');
@@ -1625,11 +1768,16 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
         /*
          * We have a hash separating parameters from random seed.
          * So `par' now points to the parameters string, and `seed'
-         * to the seed string.
+         * to the seed string. A FAST_SEED_MARKER on the end of the
+         * parameters isn't part of them.
          */
         par = snewn(seed-id + 1, char);
         strncpy(par, id, seed-id);
         par[seed-id] = '\0';
+        if (seed > id && par[seed-id-1] == FAST_SEED_MARKER) {
+            par[seed-id-1] = '\0';
+            fastseed = true;
+        }
         seed++;
         desc = NULL;
     } else {
@@ -1701,7 +1849,9 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
             newcurparams = me->ourgame->default_params();
         }
         me->ourgame->decode_params(newcurparams, par);
+        midend_phase_begin(me, &wall, &cpu);
         error = me->ourgame->validate_params(newcurparams, desc == NULL);
+        midend_phase_end(me, MIDEND_PHASE_VALIDATE, wall, cpu);
         if (error) {
             me->ourgame->free_params(newcurparams);
             return error;
@@ -1735,7 +1885,9 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
     }
 
     if (desc) {
+        midend_phase_begin(me, &wall, &cpu);
         error = me->ourgame->validate_desc(newparams, desc);
+        midend_phase_end(me, MIDEND_PHASE_VALIDATE, wall, cpu);
         if (error) {
             if (free_params) {
                 if (newcurparams)
@@ -1763,6 +1915,7 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
     me->desc = me->privdesc = NULL;
     sfree(me->seedstr);
     me->seedstr = NULL;
+    me->fastseed = false;
 
     if (desc) {
         me->desc = dupstr(desc);
@@ -1773,6 +1926,7 @@ static const char *midend_game_id_int(midend *me, const char *id, int defmode)
 
     if (seed) {
         me->seedstr = dupstr(seed);
+        me->fastseed = fastseed;
         me->genmode = GOT_SEED;
     }
 
@@ -1808,7 +1962,7 @@ char *midend_get_random_seed(midend *me)
     if (!me->seedstr)
         return NULL;
 
-    parstr = me->ourgame->encode_params(me->curparams, true);
+    parstr = midend_seed_params(me);
     assert(parstr);
     ret = snewn(strlen(parstr) + strlen(me->seedstr) + 2, char);
     sprintf(ret, "%s#%s", parstr, me->seedstr);
@@ -1816,6 +1970,36 @@ char *midend_get_random_seed(midend *me)
     return ret;
 }
 
+/*
+ * Return the game id that the next call to midend_new_game() would
+ * start, without actually generating it: a random-seed id if the
+ * game is to be generated, or a descriptive id if one has already
+ * been supplied. The midend's random state is advanced exactly as
+ * midend_new_game() would have advanced it, so that a sequence of
+ * calls to this function hands out the same sequence of games that
+ * a sequence of calls to midend_new_game() would have generated.
+ *
+ * This is for front ends doing bulk generation, which can give the
+ * ids out to other midends (perhaps in other threads) and still
+ * produce the same output as if they had done all the work in this
+ * one.
+ */
+char *midend_next_game_id(midend *me)
+{
+    char *ret;
+
+    if (me->genmode == GOT_DESC) {
+        ret = midend_get_game_id(me);
+    } else {
+        if (me->genmode != GOT_SEED)
+            midend_new_seed(me);
+        ret = midend_get_random_seed(me);
+    }
+    me->genmode = GOT_NOTHING;
+
+    return ret;
+}
+
 const char *midend_set_config(midend *me, int which, config_item *cfg)
 {
     const char *error;
@@ -1869,6 +2053,7 @@ const char *midend_solve(midend *me)
     game_state *s;
     const char *msg;
     char *movestr;
+    double wall = 0.0, cpu = 0.0;
 
     if (!me->ourgame->can_solve)
 	return "This game does not support the Solve operation";
@@ -1877,9 +2062,11 @@ const char *midend_solve(midend *me)
 	return "No game set up to solve";   /* _shouldn't_ happen! */
 
     msg = NULL;
+    midend_phase_begin(me, &wall, &cpu);
     movestr = me->ourgame->solve(me->states[0].state,
 				 me->states[me->statepos-1].state,
 				 me->aux_info, &msg);
+    midend_phase_end(me, MIDEND_PHASE_SOLVE, wall, cpu);
     assert(movestr != UI_UPDATE);
     if (!movestr) {
 	if (!msg)
@@ -1921,6 +2108,33 @@ const char *midend_solve(midend *me)
     return NULL;
 }
 
+char *midend_get_solution(midend *me, const char **error)
+{
+    char *movestr;
+    double wall = 0.0, cpu = 0.0;
+
+    *error = NULL;
+
+    if (!me->ourgame->can_solve) {
+	*error = "This game does not support the Solve operation";
+        return NULL;
+    }
+
+    if (me->statepos < 1) {
+	*error = "No game set up to solve";
+        return NULL;
+    }
+
+    midend_phase_begin(me, &wall, &cpu);
+    movestr = me->ourgame->solve(me->states[0].state, me->states[0].state,
+				 me->aux_info, error);
+    midend_phase_end(me, MIDEND_PHASE_SOLVE, wall, cpu);
+    assert(movestr != UI_UPDATE);
+    if (!movestr && !*error)
+        *error = "Solve operation failed";
+    return movestr;
+}
+
 int midend_status(midend *me)
 {
     /*
@@ -2032,10 +2246,15 @@ void midend_serialise(midend *me,
     }
 
     /*
-     * The current game description, the privdesc, and the random seed.
+     * The current game description, the privdesc, and the random seed
+     * (with a note of which random number generator it's for, since
+     * the seed alone doesn't say; older versions ignore the note).
      */
-    if (me->seedstr)
+    if (me->seedstr) {
         wr("SEED", me->seedstr);
+        if (me->fastseed)
+            wr("FASTSEED", "1");
+    }
     if (me->desc)
         wr("DESC", me->desc);
     if (me->privdesc)
@@ -2142,6 +2361,7 @@ static const char *midend_deserialise_internal(
     const char *ret = "Data does not appear to be a saved game file";
 
     data.seed = data.parstr = data.desc = data.privdesc = NULL;
+    data.fastseed = false;
     data.auxinfo = data.uistr = data.cparstr = NULL;
     data.elapsed = 0.0F;
     data.params = data.cparams = NULL;
@@ -2239,6 +2459,8 @@ static const char *midend_deserialise_internal(
                 sfree(data.seed);
                 data.seed = val;
                 val = NULL;
+            } else if (!strcmp(key, "FASTSEED")) {
+                data.fastseed = atoi(val) != 0;
             } else if (!strcmp(key, "DESC")) {
                 sfree(data.desc);
                 data.desc = val;
@@ -2323,6 +2545,7 @@ static const char *midend_deserialise_internal(
          */
         sfree(data.seed);
         data.seed = NULL;
+        data.fastseed = false;
     }
     if (!data.desc) {
         ret = "Game description in save file is missing";
@@ -2398,6 +2621,7 @@ static const char *midend_deserialise_internal(
         tmp = me->seedstr;
         me->seedstr = data.seed;
         data.seed = tmp;
+        me->fastseed = data.fastseed;
 
         tmp = me->aux_info;
         me->aux_info = data.auxinfo;
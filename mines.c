@@ -14,7 +14,6 @@
 #include <ctype.h>
 #include <math.h>
 
-#include "tree234.h"
 #include "puzzles.h"
 
 enum {
@@ -293,50 +292,95 @@ static int bitcount16(int inword)
 }
 
 /*
- * We use a tree234 to store a large number of small localised
- * sets, each with a mine count. We also keep some of those sets
- * linked together into a to-do list.
+ * We store a large number of small localised sets, each with a mine
+ * count. We also keep some of those sets linked together into a
+ * to-do list.
+ *
+ * The sets are indexed by the grid square at their top left (which,
+ * since every set is normalised to its bounding rectangle, is always
+ * within the grid): each square has a bucket listing the sets
+ * anchored there, in increasing order of mask. So finding the sets
+ * near a given square is a matter of looking in a few buckets, with
+ * no searching. Iterating over the buckets in order of y, then x,
+ * visits the sets in the same (y, x, mask) order that a sorted tree
+ * would, which matters because the solver's choice of set to perturb
+ * is made by picking a random index in that order; so we also keep
+ * a count of the sets in each row, to find the set at a given index
+ * without looking at every bucket.
+ *
+ * Set structures are recycled through a free list, with fresh ones
+ * coming from an arena, since the solver creates and destroys huge
+ * numbers of them.
  */
 struct set {
     short x, y, mask, mines;
     bool todo;
     struct set *prev, *next;
+    struct set *bucketnext;
 };
 
-static int setcmp(void *av, void *bv)
-{
-    struct set *a = (struct set *)av;
-    struct set *b = (struct set *)bv;
-
-    if (a->y < b->y)
-	return -1;
-    else if (a->y > b->y)
-	return +1;
-    else if (a->x < b->x)
-	return -1;
-    else if (a->x > b->x)
-	return +1;
-    else if (a->mask < b->mask)
-	return -1;
-    else if (a->mask > b->mask)
-	return +1;
-    else
-	return 0;
-}
-
 struct setstore {
-    tree234 *sets;
+    int w, h;
+    struct set **buckets;              /* w*h, each sorted by mask */
+    int *rowcount;                     /* number of sets anchored per row */
+    int nsets;
+    struct set *freelist;
+    arena *pool;
     struct set *todo_head, *todo_tail;
 };
 
-static struct setstore *ss_new(void)
+static struct setstore *ss_new(int w, int h)
 {
     struct setstore *ss = snew(struct setstore);
-    ss->sets = newtree234(setcmp);
+    int i;
+
+    ss->w = w;
+    ss->h = h;
+    ss->buckets = snewn(w*h, struct set *);
+    for (i = 0; i < w*h; i++)
+        ss->buckets[i] = NULL;
+    ss->rowcount = snewn(h, int);
+    for (i = 0; i < h; i++)
+        ss->rowcount[i] = 0;
+    ss->nsets = 0;
+    ss->freelist = NULL;
+    ss->pool = arena_new();
     ss->todo_head = ss->todo_tail = NULL;
     return ss;
 }
 
+static void ss_free(struct setstore *ss)
+{
+    arena_free(ss->pool);
+    sfree(ss->buckets);
+    sfree(ss->rowcount);
+    sfree(ss);
+}
+
+/*
+ * Return the set at position i in (y, x, mask) order, or NULL if
+ * there aren't that many.
+ */
+static struct set *ss_index(struct setstore *ss, int i)
+{
+    int x, y;
+    struct set *s;
+
+    if (i < 0 || i >= ss->nsets)
+        return NULL;
+
+    for (y = 0; i >= ss->rowcount[y]; y++)
+        i -= ss->rowcount[y];
+
+    for (x = 0; x < ss->w; x++)
+        for (s = ss->buckets[y*ss->w+x]; s; s = s->bucketnext)
+            if (i-- == 0)
+                return s;
+
+    assert(!"rowcount out of step with buckets");
+    return NULL;
+}
+
 /*
  * Take two input sets, in the form (x,y,mask). Munge the first by
  * taking either its intersection with the second or its difference
@@ -409,7 +453,7 @@ static void ss_add_todo(struct setstore *ss, struct set *s)
 
 static void ss_add(struct setstore *ss, int x, int y, int mask, int mines)
 {
-    struct set *s;
+    struct set *s, **pos;
 
     assert(mask != 0);
 
@@ -422,33 +466,47 @@ static void ss_add(struct setstore *ss, int x, int y, int mask, int mines)
     while (!(mask & (1|2|4)))
 	mask >>= 3, y++;
 
+    assert(x >= 0 && x < ss->w && y >= 0 && y < ss->h);
+
+    /*
+     * Find where this set belongs in its bucket. If it's already
+     * there, there's nothing to do.
+     */
+    for (pos = &ss->buckets[y*ss->w+x]; *pos; pos = &(*pos)->bucketnext)
+        if ((*pos)->mask >= mask)
+            break;
+    if (*pos && (*pos)->mask == mask)
+        return;
+
     /*
-     * Create a set structure and add it to the tree.
+     * Create a set structure and add it to the bucket.
      */
-    s = snew(struct set);
+    if (ss->freelist) {
+        s = ss->freelist;
+        ss->freelist = s->bucketnext;
+    } else {
+        s = anew(ss->pool, struct set);
+    }
     s->x = x;
     s->y = y;
     s->mask = mask;
     s->mines = mines;
     s->todo = false;
-    if (add234(ss->sets, s) != s) {
-	/*
-	 * This set already existed! Free it and return.
-	 */
-	sfree(s);
-	return;
-    }
+    s->prev = s->next = NULL;
+    s->bucketnext = *pos;
+    *pos = s;
+    ss->rowcount[y]++;
+    ss->nsets++;
 
     /*
-     * We've added a new set to the tree, so put it on the todo
-     * list.
+     * We've added a new set, so put it on the todo list.
      */
     ss_add_todo(ss, s);
 }
 
 static void ss_remove(struct setstore *ss, struct set *s)
 {
-    struct set *next = s->next, *prev = s->prev;
+    struct set *next = s->next, *prev = s->prev, **pos;
 
 #ifdef SOLVER_DIAGNOSTICS
     printf("removing set %d,%d %03x\n", s->x, s->y, s->mask);
@@ -469,14 +527,20 @@ static void ss_remove(struct setstore *ss, struct set *s)
     s->todo = false;
 
     /*
-     * Remove s from the tree.
+     * Remove s from its bucket.
      */
-    del234(ss->sets, s);
+    for (pos = &ss->buckets[s->y*ss->w+s->x]; *pos != s;
+         pos = &(*pos)->bucketnext)
+        assert(*pos);
+    *pos = s->bucketnext;
+    ss->rowcount[s->y]--;
+    ss->nsets--;
 
     /*
-     * Destroy the actual set structure.
+     * Put the set structure on the free list for reuse.
      */
-    sfree(s);
+    s->bucketnext = ss->freelist;
+    ss->freelist = s;
 }
 
 /*
@@ -491,38 +555,27 @@ static struct set **ss_overlap(struct setstore *ss, int x, int y, int mask)
 
     for (xx = x-3; xx < x+3; xx++)
 	for (yy = y-3; yy < y+3; yy++) {
-	    struct set stmp, *s;
-	    int pos;
-
-	    /*
-	     * Find the first set with these top left coordinates.
-	     */
-	    stmp.x = xx;
-	    stmp.y = yy;
-	    stmp.mask = 0;
+	    struct set *s;
 
-	    if (findrelpos234(ss->sets, &stmp, NULL, REL234_GE, &pos)) {
-		while ((s = index234(ss->sets, pos)) != NULL &&
-		       s->x == xx && s->y == yy) {
-		    /*
-		     * This set potentially overlaps the input one.
-		     * Compute the intersection to see if they
-		     * really overlap, and add it to the list if
-		     * so.
-		     */
-		    if (setmunge(x, y, mask, s->x, s->y, s->mask, false)) {
-			/*
-			 * There's an overlap.
-			 */
-			if (nret >= retsize) {
-			    retsize = nret + 32;
-			    ret = sresize(ret, retsize, struct set *);
-			}
-			ret[nret++] = s;
-		    }
+            if (xx < 0 || xx >= ss->w || yy < 0 || yy >= ss->h)
+                continue;
 
-		    pos++;
-		}
+            for (s = ss->buckets[yy*ss->w+xx]; s; s = s->bucketnext) {
+                /*
+                 * This set potentially overlaps the input one.
+                 * Compute the intersection to see if they really
+                 * overlap, and add it to the list if so.
+                 */
+                if (setmunge(x, y, mask, s->x, s->y, s->mask, false)) {
+                    /*
+                     * There's an overlap.
+                     */
+                    if (nret >= retsize) {
+                        retsize = nret + 32;
+                        ret = sresize(ret, retsize, struct set *);
+                    }
+                    ret[nret++] = s;
+                }
 	    }
 	}
 
@@ -645,7 +698,7 @@ static int minesolve(int w, int h, int n, signed char *grid,
                      perturb_cb perturb,
 		     void *ctx, random_state *rs)
 {
-    struct setstore *ss = ss_new();
+    struct setstore *ss = ss_new(w, h);
     struct set **list;
     struct squaretodo astd, *std = &astd;
     int x, y, i, j;
@@ -966,7 +1019,7 @@ static int minesolve(int w, int h, int n, signed char *grid,
 	     * a bit slow for large n, so I artificially cap this
 	     * recursion at n=10 to avoid too much pain.
 	     */
-	    nsets = count234(ss->sets);
+	    nsets = ss->nsets;
 	    if (nsets <= lenof(setused)) {
 		/*
 		 * Doing this with actual recursive function calls
@@ -1011,7 +1064,7 @@ static int minesolve(int w, int h, int n, signed char *grid,
 		 */
 		struct set *sets[lenof(setused)];
 		for (i = 0; i < nsets; i++)
-		    sets[i] = index234(ss->sets, i);
+		    sets[i] = ss_index(ss, i);
 
 		cursor = 0;
 		while (1) {
@@ -1150,7 +1203,7 @@ static int minesolve(int w, int h, int n, signed char *grid,
 	{
 	    struct set *s;
 
-	    for (i = 0; (s = index234(ss->sets, i)) != NULL; i++)
+	    for (i = 0; (s = ss_index(ss, i)) != NULL; i++)
 		printf("remaining set: %d,%d %03x %d\n", s->x, s->y, s->mask, s->mines);
 	}
 #endif
@@ -1174,13 +1227,13 @@ static int minesolve(int w, int h, int n, signed char *grid,
 	     * 
 	     * If we have no sets at all, we must give up.
 	     */
-	    if (count234(ss->sets) == 0) {
+	    if (ss->nsets == 0) {
 #ifdef SOLVER_DIAGNOSTICS
 		printf("perturbing on entire unknown set\n");
 #endif
 		ret = perturb(ctx, grid, 0, 0, 0);
 	    } else {
-		s = index234(ss->sets, random_upto(rs, count234(ss->sets)));
+		s = ss_index(ss, random_upto(rs, ss->nsets));
 #ifdef SOLVER_DIAGNOSTICS
 		printf("perturbing on set %d,%d %03x\n", s->x, s->y, s->mask);
 #endif
@@ -1251,7 +1304,7 @@ static int minesolve(int w, int h, int n, signed char *grid,
 		{
 		    struct set *s;
 
-		    for (i = 0; (s = index234(ss->sets, i)) != NULL; i++)
+		    for (i = 0; (s = ss_index(ss, i)) != NULL; i++)
 			printf("remaining set: %d,%d %03x %d\n", s->x, s->y, s->mask, s->mines);
 		}
 #endif
@@ -1284,14 +1337,8 @@ static int minesolve(int w, int h, int n, signed char *grid,
     /*
      * Free the set list and square-todo list.
      */
-    {
-	struct set *s;
-	while ((s = delpos234(ss->sets, 0)) != NULL)
-	    sfree(s);
-	freetree234(ss->sets);
-	sfree(ss);
-	sfree(std->next);
-    }
+    ss_free(ss);
+    sfree(std->next);
 
     return nperturbs;
 }
@@ -178,6 +178,30 @@ unsigned char *hex2bin(const char *in, int outlen)
     return ret;
 }
 
+#if !defined __GNUC__
+/* Fallbacks for the macros in puzzles.h. */
+int count_bits(unsigned long bits)
+{
+    int n = 0;
+    while (bits) {
+        bits &= bits - 1;
+        n++;
+    }
+    return n;
+}
+
+int lowest_bit(unsigned long bits)
+{
+    int n = 0;
+    assert(bits);
+    while (!(bits & 1)) {
+        bits >>= 1;
+        n++;
+    }
+    return n;
+}
+#endif
+
 char *fgetline(FILE *fp)
 {
     char *ret = snewn(512, char);
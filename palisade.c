@@ -712,16 +712,18 @@ static const char *validate_desc(const game_params *params, const char *desc)
             squares += *desc - 'a' + 1;
         } else if (isdigit((unsigned char)*desc)) {
             if (*desc > '4') {
-                static char buf[] = "Invalid (too large) number: '5'";
-                assert (isdigit((unsigned char)buf[lenof(buf) - 3]));
-                buf[lenof(buf) - 3] = *desc; /* ... or 6, 7, 8, 9 :-) */
-                return buf;
+                static const char *const toolarge[] = {
+                    "Invalid (too large) number: '5'",
+                    "Invalid (too large) number: '6'",
+                    "Invalid (too large) number: '7'",
+                    "Invalid (too large) number: '8'",
+                    "Invalid (too large) number: '9'",
+                };
+                return toolarge[*desc - '5'];
             }
             ++squares;
         } else if (isprint((unsigned char)*desc)) {
-            static char buf[] = "Invalid character in data: '?'";
-            buf[lenof(buf) - 3] = *desc;
-            return buf;
+            return "Invalid character in data";
         } else return "Invalid (unprintable) character in data";
     }
 
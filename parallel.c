@@ -0,0 +1,84 @@
+/*
+ * parallel.c: lets a generator hand out independent pieces of work
+ * to other threads, if the front end has some to offer.
+ *
+ * Most front ends have no threads to spare (or no threads at all),
+ * so the generators themselves never create any. Instead a front end
+ * that can run work concurrently describes how in a struct
+ * parallel_runner and makes it current for the generating thread;
+ * parallel_run() uses it if so, and otherwise just runs every job
+ * itself, in order.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "puzzles.h"
+
+/*
+ * Per-thread, like the genstats pointer, because the Unix bulk
+ * generation mode has several generating threads of its own, each
+ * of which may have its own helper threads.
+ */
+static THREAD_LOCAL const struct parallel_runner *current_runner;
+
+const struct parallel_runner *parallel_use(const struct parallel_runner *pr)
+{
+    const struct parallel_runner *prev = current_runner;
+    current_runner = pr;
+    return prev;
+}
+
+int parallel_width(void)
+{
+    return current_runner ? current_runner->nthreads : 1;
+}
+
+/*
+ * Wrapper round each job, so that anything it counts via
+ * genstat_count() is kept, even though the thread running it has
+ * no genstats of its own collecting. The counts for each job are
+ * added into the calling thread's genstats once they've all
+ * finished.
+ */
+struct parallel_call {
+    parallel_job_fn job;
+    void *ctx;
+    struct genstats *stats;
+};
+
+static void parallel_wrapper(void *vctx, int index)
+{
+    struct parallel_call *call = (struct parallel_call *)vctx;
+    struct genstats *prev;
+
+    genstats_reset(&call->stats[index]);
+    prev = genstats_collect(&call->stats[index]);
+    call->job(call->ctx, index);
+    genstats_collect(prev);
+}
+
+void parallel_run(int njobs, parallel_job_fn job, void *ctx)
+{
+    const struct parallel_runner *pr = current_runner;
+    struct parallel_call call;
+    int i, j;
+
+    assert(njobs >= 0);
+
+    if (!pr || pr->nthreads <= 1 || njobs <= 1) {
+        for (i = 0; i < njobs; i++)
+            job(ctx, i);
+        return;
+    }
+
+    call.job = job;
+    call.ctx = ctx;
+    call.stats = snewn(njobs, struct genstats);
+    pr->run(pr, njobs, parallel_wrapper, &call);
+    for (i = 0; i < njobs; i++)
+        for (j = 0; j < GENSTAT_N; j++)
+            if (call.stats[i].count[j])
+                genstat_add(j, call.stats[i].count[j]);
+    sfree(call.stats);
+}
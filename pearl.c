@@ -1168,6 +1168,7 @@ static int new_clues(const game_params *params, random_state *rs,
 
     while (1) {
         ngen++;
+        genstat_count(GENSTAT_ATTEMPTS);
 	pearl_loopgen(w, h, grid, rs);
 
 #ifdef GENERATION_DIAGNOSTICS
@@ -1248,18 +1249,25 @@ static int new_clues(const game_params *params, random_state *rs,
              * See if we can solve the puzzle just like this.
              */
             ret = pearl_solve(w, h, clues, grid, diff, false);
+            genstat_count(GENSTAT_SOLVER_CALLS);
             assert(ret > 0);	       /* shouldn't be inconsistent! */
-            if (ret != 1)
+            if (ret != 1) {
+                /* (this includes the case where it's ambiguous) */
+                genstat_count(GENSTAT_REJECT_TOO_HARD);
                 continue;		       /* go round and try again */
+            }
 
             /*
              * Check this puzzle isn't too easy.
              */
             if (diff > DIFF_EASY) {
                 ret = pearl_solve(w, h, clues, grid, diff-1, false);
+                genstat_count(GENSTAT_SOLVER_CALLS);
                 assert(ret > 0);
-                if (ret == 1)
+                if (ret == 1) {
+                    genstat_count(GENSTAT_REJECT_TOO_EASY);
                     continue; /* too easy: try again */
+                }
             }
 
             /*
@@ -1324,6 +1332,7 @@ static int new_clues(const game_params *params, random_state *rs,
                 clues[y*w+x] = 0;	       /* try removing this clue */
 
                 ret = pearl_solve(w, h, clues, grid, diff, false);
+                genstat_count(GENSTAT_SOLVER_CALLS);
                 assert(ret > 0);
                 if (ret != 1)
                     clues[y*w+x] = clue;   /* oops, put it back again */
@@ -1867,18 +1876,19 @@ static void game_changed_state(game_ui *ui, const game_state *oldstate,
 
 enum { GUI_MASYU, GUI_LOOPY };
 
+/*
+ * This is consulted from places (such as BORDER) where there's no
+ * drawstate to cache it in, so we just read the environment every
+ * time; caching it in a static would make the back end unsafe to use
+ * from several threads at once.
+ */
 static int get_gui_style(void)
 {
-    static int gui_style = -1;
-
-    if (gui_style == -1) {
-        char *env = getenv("PEARL_GUI_LOOPY");
-        if (env && (env[0] == 'y' || env[0] == 'Y'))
-            gui_style = GUI_LOOPY;
-        else
-            gui_style = GUI_MASYU;
-    }
-    return gui_style;
+    char *env = getenv("PEARL_GUI_LOOPY");
+    if (env && (env[0] == 'y' || env[0] == 'Y'))
+        return GUI_LOOPY;
+    else
+        return GUI_MASYU;
 }
 
 struct game_drawstate {
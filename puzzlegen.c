@@ -0,0 +1,262 @@
+/*
+ * puzzlegen.c: headless command-line front end providing the bulk
+ * generation modes of the Unix puzzles ('--generate', '--print',
+ * '--save' and friends; see batchgen.c) for every puzzle in a single
+ * binary, without linking against GTK or needing a display. It can
+ * also run as a long-lived server reading generation requests on
+ * standard input (see batchgen_serve).
+ *
+ * Usage:
+ *
+ *   puzzlegen <puzzle> [options] [<params> | <game-id>]
+ *   puzzlegen --list
+ *   puzzlegen --server
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "puzzles.h"
+
+/* ----------------------------------------------------------------------
+ * Main program.
+ */
+
+/*
+ * Accept either the short name of a puzzle (the one its binary is
+ * normally called) or its full name, ignoring case and spaces, so
+ * that 'lightup', 'Light Up' and 'LIGHTUP' all work.
+ */
+static bool name_matches(const char *name, const char *query)
+{
+    if (!name)
+        return false;
+    while (*name || *query) {
+        if (*name == ' ') {
+            name++;
+        } else if (*query == ' ') {
+            query++;
+        } else if (!*name || !*query ||
+                   tolower((unsigned char)*name) !=
+                   tolower((unsigned char)*query)) {
+            return false;
+        } else {
+            name++;
+            query++;
+        }
+    }
+    return true;
+}
+
+static const game *find_game(const char *query)
+{
+    int i;
+
+    for (i = 0; i < gamecount; i++)
+        if (name_matches(gamelist[i]->htmlhelp_topic, query) ||
+            name_matches(gamelist[i]->name, query))
+            return gamelist[i];
+    return NULL;
+}
+
+static void usage(FILE *fp)
+{
+    fprintf(fp,
+            "usage: puzzlegen <puzzle> [options] [<params> | <game-id>]\n"
+            "       puzzlegen --list\n"
+            "       puzzlegen --server\n"
+            "options: --generate [<n>]    generate <n> game ids\n"
+            "         --jobs <n>          generate using <n> threads\n"
+            "         --threads <n>       let each game use <n> threads\n"
+            "         --time-generation   report time taken for each id\n"
+            "         --test-solve        check each game can be solved\n"
+            "         --print <w>x<h>     print games as PostScript\n"
+            "         --save <prefix>     write games to save files\n"
+            "         --save-suffix <suffix>\n"
+            "         --with-solutions    include solutions in output\n"
+            "         --scale <n>         scale factor for printing\n"
+            "         --colour            print in colour\n"
+            "         --list-presets      list preset parameter strings\n"
+            "         --version           report version and exit\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *pname = "puzzlegen";
+    const game *thegame;
+    struct batchgen_options opts;
+    bool doing_opts = true, list_presets = false;
+    int ac = argc;
+    char **av = argv;
+    int i;
+
+    batchgen_default_options(&opts);
+    opts.pname = pname;
+
+    if (ac < 2) {
+        usage(stderr);
+        return 1;
+    }
+
+    if (!strcmp(av[1], "--list")) {
+        for (i = 0; i < gamecount; i++)
+            printf("%s %s\n", gamelist[i]->htmlhelp_topic,
+                   gamelist[i]->name);
+        return 0;
+    } else if (!strcmp(av[1], "--server")) {
+        return batchgen_serve(find_game);
+    } else if (!strcmp(av[1], "--help")) {
+        usage(stdout);
+        return 0;
+    } else if (!strcmp(av[1], "--version")) {
+        printf("puzzlegen, from Simon Tatham's Portable Puzzle Collection\n"
+               "%s\n", ver);
+        return 0;
+    }
+
+    thegame = find_game(av[1]);
+    if (!thegame) {
+        fprintf(stderr, "%s: unrecognised puzzle '%s' "
+                "(try '%s --list')\n", pname, av[1], pname);
+        return 1;
+    }
+    ac--;
+    av++;
+
+    while (--ac > 0) {
+	char *p = *++av;
+	if (doing_opts && !strcmp(p, "--version")) {
+	    printf("%s, from Simon Tatham's Portable Puzzle Collection\n%s\n",
+		   thegame->name, ver);
+	    return 0;
+	} else if (doing_opts && !strcmp(p, "--generate")) {
+	    if (--ac > 0) {
+		opts.ngenerate = atoi(*++av);
+		if (!opts.ngenerate) {
+		    fprintf(stderr, "%s: '--generate' expected a number\n",
+			    pname);
+		    return 1;
+		}
+	    } else
+		opts.ngenerate = 1;
+	} else if (doing_opts && !strcmp(p, "--jobs")) {
+	    if (--ac > 0) {
+		opts.njobs = atoi(*++av);
+		if (opts.njobs < 1) {
+		    fprintf(stderr, "%s: '--jobs' expected a positive "
+			    "number\n", pname);
+		    return 1;
+		}
+	    } else {
+		fprintf(stderr, "%s: '--jobs' expected a number\n", pname);
+		return 1;
+	    }
+	} else if (doing_opts && !strcmp(p, "--threads")) {
+	    if (--ac > 0) {
+		opts.nthreads = atoi(*++av);
+		if (opts.nthreads < 1) {
+		    fprintf(stderr, "%s: '--threads' expected a positive "
+			    "number\n", pname);
+		    return 1;
+		}
+	    } else {
+		fprintf(stderr, "%s: '--threads' expected a number\n",
+			pname);
+		return 1;
+	    }
+	} else if (doing_opts && !strcmp(p, "--time-generation")) {
+            opts.time_generation = true;
+	} else if (doing_opts && !strcmp(p, "--test-solve")) {
+            opts.test_solve = true;
+	} else if (doing_opts && !strcmp(p, "--list-presets")) {
+            list_presets = true;
+	} else if (doing_opts && !strcmp(p, "--save")) {
+	    if (--ac > 0) {
+		opts.savefile = *++av;
+	    } else {
+		fprintf(stderr, "%s: '--save' expected a filename\n",
+			pname);
+		return 1;
+	    }
+	} else if (doing_opts && (!strcmp(p, "--save-suffix") ||
+				  !strcmp(p, "--savesuffix"))) {
+	    if (--ac > 0) {
+		opts.savesuffix = *++av;
+	    } else {
+		fprintf(stderr, "%s: '--save-suffix' expected a filename\n",
+			pname);
+		return 1;
+	    }
+	} else if (doing_opts && !strcmp(p, "--print")) {
+	    if (!thegame->can_print) {
+		fprintf(stderr, "%s: this game does not support printing\n",
+			pname);
+		return 1;
+	    }
+	    opts.print = true;
+	    if (--ac > 0) {
+		char *dim = *++av;
+		if (sscanf(dim, "%dx%d", &opts.px, &opts.py) != 2) {
+		    fprintf(stderr, "%s: unable to parse argument '%s' to "
+			    "'--print'\n", pname, dim);
+		    return 1;
+		}
+	    } else {
+		opts.px = opts.py = 1;
+	    }
+	} else if (doing_opts && !strcmp(p, "--scale")) {
+	    if (--ac > 0) {
+		opts.scale = atof(*++av);
+	    } else {
+		fprintf(stderr, "%s: no argument supplied to '--scale'\n",
+			pname);
+		return 1;
+	    }
+	} else if (doing_opts && (!strcmp(p, "--with-solutions") ||
+				  !strcmp(p, "--with-solution") ||
+				  !strcmp(p, "--with-solns") ||
+				  !strcmp(p, "--with-soln") ||
+				  !strcmp(p, "--solutions") ||
+				  !strcmp(p, "--solution") ||
+				  !strcmp(p, "--solns") ||
+				  !strcmp(p, "--soln"))) {
+	    opts.soln = true;
+	} else if (doing_opts && !strcmp(p, "--colour")) {
+	    if (!thegame->can_print_in_colour) {
+		fprintf(stderr, "%s: this game does not support colour"
+			" printing\n", pname);
+		return 1;
+	    }
+	    opts.colour = true;
+	} else if (doing_opts && !strcmp(p, "--")) {
+	    doing_opts = false;
+	} else if (!doing_opts || p[0] != '-') {
+	    if (opts.arg) {
+		fprintf(stderr, "%s: more than one argument supplied\n",
+			pname);
+		return 1;
+	    }
+	    opts.arg = p;
+	} else {
+	    fprintf(stderr, "%s: unrecognised option '%s'\n", pname, p);
+	    return 1;
+	}
+    }
+
+    if (list_presets) {
+        batchgen_list_presets(thegame);
+        return 0;
+    }
+
+    /*
+     * Unlike the GUI puzzles, we have nothing to do if we're not
+     * asked to print or save anything, so generating a single game
+     * id is the default action.
+     */
+    if (!opts.ngenerate && !opts.print && !opts.savefile && !opts.savesuffix)
+        opts.ngenerate = 1;
+
+    return batchgen_run(thegame, &opts);
+}
@@ -85,6 +85,22 @@ enum {
 
 #define IGNOREARG(x) ( (x) = (x) )
 
+/*
+ * Storage class for the few statics that have to be per-thread. On
+ * platforms where we don't know how to ask for thread-local storage
+ * this is an ordinary static, which is fine as long as the front end
+ * doesn't generate on more than one thread.
+ */
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#elif defined __GNUC__
+#define THREAD_LOCAL __thread
+#elif defined _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL
+#endif
+
 typedef struct frontend frontend;
 typedef struct config_item config_item;
 typedef struct midend midend;
@@ -320,9 +336,11 @@ const char *midend_set_config(midend *me, int which, config_item *cfg);
 const char *midend_game_id(midend *me, const char *id);
 char *midend_get_game_id(midend *me);
 char *midend_get_random_seed(midend *me);
+char *midend_next_game_id(midend *me);
 bool midend_can_format_as_text_now(midend *me);
 char *midend_text_format(midend *me);
 const char *midend_solve(midend *me);
+char *midend_get_solution(midend *me, const char **error);
 int midend_status(midend *me);
 bool midend_can_undo(midend *me);
 bool midend_can_redo(midend *me);
@@ -340,6 +358,21 @@ const char *identify_game(char **name,
                           void *rctx);
 void midend_request_id_changes(midend *me, void (*notify)(void *), void *ctx);
 bool midend_get_cursor_location(midend *me, int *x, int *y, int *w, int *h);
+/* Optional timing of the phases of setting up a game, for benchmarking */
+enum {
+    MIDEND_PHASE_NEW_DESC,      /* generating the game description */
+    MIDEND_PHASE_VALIDATE,      /* validating params and descriptions */
+    MIDEND_PHASE_NEW_GAME,      /* constructing the initial game_state */
+    MIDEND_PHASE_AUX_CHECK,     /* self-test of a new game's aux_info */
+    MIDEND_PHASE_SOLVE,         /* running the game's solver */
+    MIDEND_NPHASES
+};
+typedef void (*midend_clock_fn)(void *ctx, double *wall, double *cpu);
+void midend_set_phase_clock(midend *me, midend_clock_fn clock, void *ctx);
+void midend_reset_phase_times(midend *me);
+int midend_get_phase_times(midend *me, int phase, double *wall, double *cpu);
+const char *midend_phase_name(int phase);
+const struct genstats *midend_get_genstats(midend *me);
 
 /* Printing functions supplied by the mid-end */
 const char *midend_print_puzzle(midend *me, document *doc, bool with_soln);
@@ -359,6 +392,25 @@ char *dupstr(const char *s);
 #define sresize(array, number, type) \
     ( (type *) srealloc ((array), (number) * sizeof (type)) )
 
+/*
+ * arena.c
+ */
+typedef struct arena arena;
+typedef struct arena_mark {
+    struct arena_chunk *chunk;
+    size_t used;
+} arena_mark;
+arena *arena_new(void);
+void arena_free(arena *a);
+void *arena_alloc(arena *a, size_t size);
+void arena_reset(arena *a);
+arena_mark arena_get_mark(arena *a);
+void arena_release(arena *a, arena_mark m);
+#define anew(a, type) \
+    ( (type *) arena_alloc ((a), sizeof (type)) )
+#define anewn(a, number, type) \
+    ( (type *) arena_alloc ((a), (number) * sizeof (type)) )
+
 /*
  * misc.c
  */
@@ -372,6 +424,18 @@ char *fgetline(FILE *fp);
 char *bin2hex(const unsigned char *in, int inlen);
 unsigned char *hex2bin(const char *in, int outlen);
 
+/* The number of set bits in a word, and the index of the lowest one
+ * (which must exist). For solvers keeping sets of digits as bitmaps,
+ * which call these in their innermost loops, so where the compiler
+ * has builtins they are macros; otherwise misc.c provides them. */
+#if defined __GNUC__
+#define count_bits(bits) __builtin_popcountl(bits)
+#define lowest_bit(bits) __builtin_ctzl(bits)
+#else
+int count_bits(unsigned long bits);
+int lowest_bit(unsigned long bits);
+#endif
+
 /* Sets (and possibly dims) background from frontend default colour,
  * and auto-generates highlight and lowlight colours too. */
 void game_mkhighlight(frontend *fe, float *ret,
@@ -436,6 +500,32 @@ void edsf_merge(int *dsf, int v1, int v2, bool inverse);
 void dsf_merge(int *dsf, int v1, int v2);
 void dsf_init(int *dsf, int len);
 
+/*
+ * An alternative disjoint set forest, using union by rank and path
+ * halving, and optionally able to undo merges (at the cost of doing
+ * without the path halving). Unlike the plain dsf, the canonical
+ * element of a class is not necessarily its smallest member; use
+ * rdsf_minimal if you need that.
+ *
+ * rdsf_checkpoint returns a token representing the current state of an
+ * undoable rdsf, and rdsf_rollback undoes every merge made since, in
+ * time proportional to the number of merges rather than the size of
+ * the forest. Checkpoints nest in the obvious way. rdsf_reset empties
+ * the forest and invalidates all checkpoints.
+ */
+typedef struct rdsf rdsf;
+rdsf *rdsf_new(int size, bool undoable);
+void rdsf_free(rdsf *d);
+void rdsf_reset(rdsf *d);
+int erdsf_canonify(rdsf *d, int val, bool *inverse);
+int rdsf_canonify(rdsf *d, int val);
+void erdsf_merge(rdsf *d, int v1, int v2, bool inverse);
+void rdsf_merge(rdsf *d, int v1, int v2);
+int rdsf_size(rdsf *d, int val);
+int rdsf_minimal(rdsf *d, int val);
+int rdsf_checkpoint(rdsf *d);
+void rdsf_rollback(rdsf *d, int checkpoint);
+
 /*
  * tdq.c
  */
@@ -473,6 +563,112 @@ void tdq_add(tdq *tdq, int k);
 int tdq_remove(tdq *tdq);        /* returns -1 if nothing available */
 void tdq_fill(tdq *tdq);         /* add everything to the tdq at once */
 
+/*
+ * A worklist is a tdq with priority levels, for solvers that have
+ * cheap local deductions to try before expensive ones. It holds
+ * integers from 0 to n-1, each at most once, and each at one of
+ * 'nlevels' levels, with level 0 the most urgent. Removal always takes
+ * from the most urgent non-empty level, and within a level elements
+ * come out in FIFO order.
+ *
+ * worklist_add appends k to the back of a level and worklist_push
+ * puts it at the front. If k is already present at a less urgent
+ * level it's moved to the new one; if it's present at the same or a
+ * more urgent level, nothing happens.
+ *
+ * The remove functions only look at levels up to 'maxlevel', so that
+ * a solver can ask for just the cheap work. worklist_remove returns
+ * -1 if there's nothing there. worklist_remove_batch takes up to 'max'
+ * elements from the most urgent non-empty level and returns how many
+ * it took: useful for deductions that are most efficiently done over
+ * a set of elements at once. Both report the level they took from in
+ * *level, if it's not NULL.
+ *
+ * All operations are constant time, except that the remove functions
+ * are linear in the number of levels and remove_batch in the number
+ * of elements it returns.
+ */
+typedef struct worklist worklist;
+worklist *worklist_new(int n, int nlevels);
+void worklist_free(worklist *wl);
+void worklist_add(worklist *wl, int k, int level);
+void worklist_push(worklist *wl, int k, int level);
+bool worklist_contains(const worklist *wl, int k);
+int worklist_count(const worklist *wl);
+int worklist_remove(worklist *wl, int maxlevel, int *level);
+int worklist_remove_batch(worklist *wl, int maxlevel, int *out, int max,
+                          int *level);
+void worklist_fill(worklist *wl, int level);   /* add everything at once */
+
+/*
+ * genstats.c
+ */
+
+/*
+ * Counters describing how much work a generator did. The midend
+ * directs counts to its own genstats around each call to new_desc()
+ * (see midend_get_genstats()), and generators report into whichever
+ * genstats is currently collecting by calling genstat_count(); when
+ * nothing is collecting, that does nothing.
+ *
+ * Generators that report at all should count GENSTAT_ATTEMPTS once
+ * per candidate puzzle they construct, and one of the GENSTAT_REJECT_*
+ * counters for each candidate they throw away, so that the rejection
+ * rate of a preset can be read off directly.
+ */
+enum {
+    GENSTAT_ATTEMPTS,           /* candidate puzzles constructed */
+    GENSTAT_SOLVER_CALLS,       /* top-level calls to the solver */
+    GENSTAT_BACKTRACKS,         /* guesses or nodes in backtracking search */
+    GENSTAT_REJECT_AMBIGUOUS,   /* candidate had more than one solution */
+    GENSTAT_REJECT_TOO_HARD,    /* harder than the requested difficulty */
+    GENSTAT_REJECT_TOO_EASY,    /* easier than the requested difficulty */
+    GENSTAT_REJECT_OTHER,       /* thrown away for any other reason */
+    GENSTAT_N
+};
+struct genstats {
+    unsigned long count[GENSTAT_N];
+};
+/* Start counting into gs (or stop, if NULL); returns previous target */
+struct genstats *genstats_collect(struct genstats *gs);
+void genstats_reset(struct genstats *gs);
+void genstat_add(int which, unsigned long n);
+#define genstat_count(which) genstat_add(which, 1)
+const char *genstat_name(int which);
+
+/*
+ * parallel.c
+ */
+
+/*
+ * A way for generators to run independent jobs concurrently, on
+ * threads supplied by the front end. parallel_run() calls job(ctx, i)
+ * for each i from 0 to njobs-1, in no particular order and possibly
+ * on other threads, and returns once they have all finished. If no
+ * runner is current for the calling thread, it runs them all itself
+ * in order. Jobs must only write to memory belonging to their own
+ * index; they may call genstat_count().
+ *
+ * parallel_width() says how many jobs the current runner can
+ * usefully run at once (1 if there isn't one), so that a generator
+ * can decide how much speculative work is worth doing.
+ *
+ * A front end provides a runner by filling in a struct
+ * parallel_runner and making it current with parallel_use(), which
+ * returns the previously current one (NULL meaning none). Its run
+ * function must not return until every job has finished.
+ */
+typedef void (*parallel_job_fn)(void *ctx, int index);
+struct parallel_runner {
+    int nthreads;
+    void (*run)(const struct parallel_runner *pr, int njobs,
+                parallel_job_fn job, void *ctx);
+    void *ctx;
+};
+const struct parallel_runner *parallel_use(const struct parallel_runner *pr);
+int parallel_width(void);
+void parallel_run(int njobs, parallel_job_fn job, void *ctx);
+
 /*
  * laydomino.c
  */
@@ -488,7 +684,9 @@ extern char ver[];
  * random.c
  */
 random_state *random_new(const char *seed, int len);
+random_state *random_new_fast(const char *seed, int len);
 random_state *random_copy(random_state *tocopy);
+random_state *random_split(random_state *state, unsigned long i);
 unsigned long random_bits(random_state *state, int bits);
 unsigned long random_upto(random_state *state, unsigned long limit);
 void random_free(random_state *state);
@@ -534,6 +732,29 @@ psdata *ps_init(FILE *outfile, bool colour);
 void ps_free(psdata *ps);
 drawing *ps_drawing_api(psdata *ps);
 
+/*
+ * batchgen.c: non-interactive bulk generation of puzzles (the
+ * '--generate', '--print' and '--save' command-line modes, and
+ * puzzlegen's '--server' mode), shared by the Unix front ends.
+ */
+struct batchgen_options {
+    const char *pname;          /* program name, for error messages */
+    const char *arg;            /* params or game id from command line */
+    int ngenerate;              /* number to generate; 0 = read stdin */
+    int njobs;                  /* number of threads to generate with */
+    int nthreads;               /* threads each generator may use */
+    bool print;                 /* print PostScript to stdout */
+    int px, py;                 /* puzzles across and down each page */
+    float scale;
+    bool soln, colour;
+    bool time_generation, test_solve;
+    const char *savefile, *savesuffix;
+};
+void batchgen_default_options(struct batchgen_options *opts);
+int batchgen_run(const game *game, const struct batchgen_options *opts);
+void batchgen_list_presets(const game *game);
+int batchgen_serve(const game *(*find_game)(const char *name));
+
 /*
  * combi.c: provides a structure and functions for iterating over
  * combinations (i.e. choosing r things out of n).
@@ -601,6 +822,64 @@ bool findloop_is_loop_edge(struct findloopstate *state, int u, int v);
 bool findloop_is_bridge(
     struct findloopstate *pv, int u, int v, int *u_vertices, int *v_vertices);
 
+/*
+ * gf2.c: linear algebra over GF(2), on matrices with their rows
+ * packed into machine words.
+ */
+typedef struct gf2_matrix gf2_matrix;
+gf2_matrix *gf2_matrix_new(int rows, int cols);   /* all zero */
+void gf2_matrix_free(gf2_matrix *m);
+bool gf2_get(const gf2_matrix *m, int row, int col);
+void gf2_set(gf2_matrix *m, int row, int col, bool value);
+/*
+ * Reduce the matrix in place to reduced row echelon form, choosing
+ * pivots only from the first 'ncols' columns (so that any further
+ * columns can hold right-hand sides, which come along for the ride).
+ * Returns the rank; if 'pivots' is non-NULL, pivots[i] is set to the
+ * column of row i's pivot for each i below the rank.
+ */
+int gf2_reduce(gf2_matrix *m, int ncols, int *pivots);
+/*
+ * Solve the linear system whose coefficients are the first 'n'
+ * columns of 'm' and whose right-hand side is column n. Returns -1
+ * if there's no solution. Otherwise, writes the solution with the
+ * fewest 1s into x[0..n-1] (one 0 or 1 per byte) and returns the
+ * number of 1s in it. Finding that solution takes time exponential
+ * in the dimension of the solution space. 'm' is left reduced.
+ */
+int gf2_solve_min(gf2_matrix *m, int n, unsigned char *x);
+
+/*
+ * dlx.c: exact cover by Knuth's 'dancing links' Algorithm X. A dlx
+ * has nprimary columns that every solution must cover exactly once,
+ * followed by nsecondary that it may cover at most once; column
+ * indices run from 0 to nprimary+nsecondary-1. dlx_add_row adds a
+ * row with a 1 in each of the n columns listed, and returns its
+ * index (rows are numbered from 0 in the order added). The search
+ * only ever chooses a row to cover some primary column, so a row
+ * with no primary columns in it will never be part of a solution.
+ */
+typedef struct dlx dlx;
+dlx *dlx_new(int nprimary, int nsecondary);
+void dlx_free(dlx *d);
+int dlx_add_row(dlx *d, const int *cols, int n);
+int dlx_nrows(const dlx *d);
+/*
+ * Search for sets of rows covering the columns as above. Returns the
+ * number of solutions, but stops looking once it has found 'limit'
+ * of them (or never, if limit <= 0), so that asking whether a
+ * solution is unique costs only as much as finding a second one.
+ * The dlx is left as it was, ready to be searched again (perhaps
+ * after adding more rows).
+ */
+int dlx_solve(dlx *d, int limit);
+/*
+ * Write the rows making up the first solution found by the last
+ * dlx_solve into rows[] (if non-NULL; it needs room for nprimary
+ * entries), and return how many there are.
+ */
+int dlx_solution(const dlx *d, int *rows);
+
 /*
  * Hamilton-cycle and Hamilton-path finding apparatus in hamilton.c.
  */
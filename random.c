@@ -8,6 +8,14 @@
  * The generator is based on SHA-1. This is almost certainly
  * overkill, but I had the SHA-1 code kicking around and it was
  * easier to reuse it than to do anything else!
+ *
+ * It is also quite slow for generators which consume a lot of random
+ * numbers, so there's a second, much faster generator (xoshiro128**)
+ * available via random_new_fast(). That one still gets its initial
+ * state from SHA-1, so that any seed string gives a well-mixed state.
+ * Which generator a random seed uses has to be recorded in the game
+ * id alongside it, so that old ids keep producing the same games; the
+ * midend takes care of that.
  */
 
 #include <assert.h>
@@ -202,9 +210,15 @@ void SHA_Simple(const void *p, int len, unsigned char *output)
  */
 
 struct random_state {
+    bool fast;                         /* which generator this is */
+
+    /* State of the SHA-1 generator */
     unsigned char seedbuf[40];
     unsigned char databuf[20];
     int pos;
+
+    /* State of the fast generator */
+    uint32 s[4];
 };
 
 random_state *random_new(const char *seed, int len)
@@ -213,10 +227,37 @@ random_state *random_new(const char *seed, int len)
 
     state = snew(random_state);
 
+    state->fast = false;
     SHA_Simple(seed, len, state->seedbuf);
     SHA_Simple(state->seedbuf, 20, state->seedbuf + 20);
     SHA_Simple(state->seedbuf, 40, state->databuf);
     state->pos = 0;
+    memset(state->s, 0, sizeof(state->s));
+
+    return state;
+}
+
+random_state *random_new_fast(const char *seed, int len)
+{
+    random_state *state;
+    unsigned char hash[20];
+    int i;
+
+    state = snew(random_state);
+
+    state->fast = true;
+    memset(state->seedbuf, 0, sizeof(state->seedbuf));
+    memset(state->databuf, 0, sizeof(state->databuf));
+    state->pos = 0;
+
+    SHA_Simple(seed, len, hash);
+    for (i = 0; i < 4; i++)
+        state->s[i] = ((uint32)hash[4*i] << 24) | ((uint32)hash[4*i+1] << 16) |
+            ((uint32)hash[4*i+2] << 8) | (uint32)hash[4*i+3];
+
+    /* The one state xoshiro can't get out of. Vanishingly unlikely. */
+    if (!(state->s[0] | state->s[1] | state->s[2] | state->s[3]))
+        state->s[0] = 1;
 
     return state;
 }
@@ -225,17 +266,39 @@ random_state *random_copy(random_state *tocopy)
 {
     random_state *result;
     result = snew(random_state);
-    memcpy(result->seedbuf, tocopy->seedbuf, sizeof(result->seedbuf));
-    memcpy(result->databuf, tocopy->databuf, sizeof(result->databuf));
-    result->pos = tocopy->pos;
+    *result = *tocopy;                 /* structure copy */
     return result;
 }
 
+/*
+ * One step of xoshiro128**, by David Blackman and Sebastiano Vigna.
+ */
+static uint32 xoshiro_next(uint32 *s)
+{
+    uint32 ret = rol(s[1] * 5, 7) * 9;
+    uint32 t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rol(s[3], 11);
+
+    return ret;
+}
+
 unsigned long random_bits(random_state *state, int bits)
 {
     unsigned long ret = 0;
     int n;
 
+    if (state->fast) {
+        /* The top bits of xoshiro's output are the best ones. */
+        assert(bits >= 1 && bits <= 32);
+        return (unsigned long)(xoshiro_next(state->s) >> (32 - bits));
+    }
+
     for (n = 0; n < bits; n += 8) {
 	if (state->pos >= 20) {
 	    int i;
@@ -263,6 +326,29 @@ unsigned long random_bits(random_state *state, int bits)
     return ret;
 }
 
+/*
+ * A child stream is seeded from a hash of the parent's entire current
+ * state together with the child's index, so computing any one of them
+ * costs the same no matter what i is, and the children are related
+ * to each other only through SHA-1.
+ */
+random_state *random_split(random_state *state, unsigned long i)
+{
+    char *enc = random_state_encode(state);
+    char *seed = snewn(strlen(enc) + 40, char);
+    random_state *ret;
+
+    sprintf(seed, "%s/%lu", enc, i);
+    if (state->fast)
+        ret = random_new_fast(seed, strlen(seed));
+    else
+        ret = random_new(seed, strlen(seed));
+
+    sfree(seed);
+    sfree(enc);
+    return ret;
+}
+
 unsigned long random_upto(random_state *state, unsigned long limit)
 {
     int bits = 0;
@@ -290,11 +376,35 @@ void random_free(random_state *state)
     sfree(state);
 }
 
+static int hexval(int c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    else if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    else if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    else
+        return 0;
+}
+
+/*
+ * The encoded form of a SHA-1 generator is a string of hex digits.
+ * That of a fast generator is its state in hex, prefixed with 'x',
+ * which old versions of random_state_encode never produced.
+ */
 char *random_state_encode(random_state *state)
 {
     char retbuf[256];
     int len = 0, i;
 
+    if (state->fast) {
+        len += sprintf(retbuf+len, "x");
+        for (i = 0; i < 4; i++)
+            len += sprintf(retbuf+len, "%08lx", (unsigned long)state->s[i]);
+        return dupstr(retbuf);
+    }
+
     for (i = 0; i < lenof(state->seedbuf); i++)
 	len += sprintf(retbuf+len, "%02x", state->seedbuf[i]);
     for (i = 0; i < lenof(state->databuf); i++)
@@ -311,25 +421,28 @@ random_state *random_state_decode(const char *input)
 
     state = snew(random_state);
 
+    state->fast = false;
     memset(state->seedbuf, 0, sizeof(state->seedbuf));
     memset(state->databuf, 0, sizeof(state->databuf));
     state->pos = 0;
+    memset(state->s, 0, sizeof(state->s));
+
+    if (*input == 'x') {
+        state->fast = true;
+        input++;
+        for (pos = 0; pos < 4 && *input; pos++) {
+            for (digits = 0; digits < 8 && *input; digits++)
+                state->s[pos] = (state->s[pos] << 4) | hexval(*input++);
+        }
+        if (!(state->s[0] | state->s[1] | state->s[2] | state->s[3]))
+            state->s[0] = 1;
+        return state;
+    }
 
     byte = digits = 0;
     pos = 0;
     while (*input) {
-	int v = *input++;
-
-	if (v >= '0' && v <= '9')
-	    v = v - '0';
-	else if (v >= 'A' && v <= 'F')
-	    v = v - 'A' + 10;
-	else if (v >= 'a' && v <= 'f')
-	    v = v - 'a' + 10;
-	else
-	    v = 0;
-
-	byte = (byte << 4) | v;
+	byte = (byte << 4) | hexval(*input++);
 	digits++;
 
 	if (digits == 2) {
@@ -349,3 +462,97 @@ random_state *random_state_decode(const char *input)
 
     return state;
 }
+
+#ifdef RANDOM_TEST
+
+#include <stdlib.h>
+
+/*
+ * Check random_split on both kinds of generator (the SHA-1 one, and
+ * the xoshiro one used for '~' game ids): splitting the same parent
+ * state with the same index must always give the same stream,
+ * splitting must leave the parent alone, and no two children, nor a
+ * child and its parent, should produce the same output.
+ */
+#define NSPLIT 64
+#define NOUT 8
+
+static void outputs(random_state *rs, unsigned long *out)
+{
+    int i;
+    for (i = 0; i < NOUT; i++)
+        out[i] = random_bits(rs, 32);
+}
+
+static int test_split(const char *name, random_state *parent)
+{
+    static unsigned long out[NSPLIT + 1][NOUT];
+    unsigned long again[NOUT];
+    char *before, *after;
+    int i, j, errors = 0;
+
+    /* Move the parent away from its initial state first. */
+    for (i = 0; i < 100; i++)
+        random_bits(parent, 32);
+
+    before = random_state_encode(parent);
+    for (i = 0; i < NSPLIT; i++) {
+        random_state *child = random_split(parent, i);
+        random_state *copy = random_copy(parent);
+        random_state *child2 = random_split(copy, i);
+        char *enc = random_state_encode(child);
+
+        if ((enc[0] == 'x') != (before[0] == 'x')) {
+            printf("%s: child %d is a different kind of generator\n",
+                   name, i);
+            errors++;
+        }
+        outputs(child, out[i]);
+        outputs(child2, again);
+        if (memcmp(out[i], again, sizeof(again))) {
+            printf("%s: child %d differs between two splits\n", name, i);
+            errors++;
+        }
+
+        sfree(enc);
+        random_free(child2);
+        random_free(copy);
+        random_free(child);
+    }
+    after = random_state_encode(parent);
+    if (strcmp(before, after)) {
+        printf("%s: splitting changed the parent's state\n", name);
+        errors++;
+    }
+    outputs(parent, out[NSPLIT]);
+
+    for (i = 0; i <= NSPLIT; i++)
+        for (j = i+1; j <= NSPLIT; j++)
+            if (!memcmp(out[i], out[j], sizeof(out[i]))) {
+                printf("%s: streams %d and %d are the same\n", name, i, j);
+                errors++;
+            }
+
+    sfree(before);
+    sfree(after);
+    random_free(parent);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    const char *seed = (argc > 1 ? argv[1] : "12345");
+    int errors = 0;
+
+    errors += test_split("SHA-1", random_new(seed, strlen(seed)));
+    errors += test_split("xoshiro", random_new_fast(seed, strlen(seed)));
+
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* RANDOM_TEST */
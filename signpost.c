@@ -1428,6 +1428,7 @@ struct game_drawstate {
     int *nums, *dirp;
     unsigned int *f;
     double angle_offset;
+    bool gear_mode;
 
     bool dragging;
     int dx, dy;
@@ -1753,6 +1754,10 @@ static game_drawstate *game_new_drawstate(drawing *dr, const game_state *state)
     }
 
     ds->angle_offset = 0.0F;
+    {
+        char *env = getenv("SIGNPOST_GEARS");
+        ds->gear_mode = (env && (env[0] == 'y' || env[0] == 'Y'));
+    }
 
     ds->dragging = false;
     ds->dx = ds->dy = 0;
@@ -2137,12 +2142,7 @@ static void game_redraw(drawing *dr, game_drawstate *ds,
                      * rotate in the same direction. Choose for
                      * yourself which is more brain-twisting :-)
                      */
-                    static int gear_mode = -1;
-                    if (gear_mode < 0) {
-                        char *env = getenv("SIGNPOST_GEARS");
-                        gear_mode = (env && (env[0] == 'y' || env[0] == 'Y'));
-                    }
-                    if (gear_mode)
+                    if (ds->gear_mode)
                         sign = 1 - 2 * ((x ^ y) & 1);
                     else
                         sign = 1;
@@ -1662,12 +1662,8 @@ static char *interpret_move(const game_state *state, game_ui *ui,
 	 * lookups.
 	 */
 	{
-	    static int swap_buttons = -1;
-	    if (swap_buttons < 0) {
-		char *env = getenv("SLANT_SWAP_BUTTONS");
-		swap_buttons = (env && (env[0] == 'y' || env[0] == 'Y'));
-	    }
-	    if (swap_buttons) {
+	    char *env = getenv("SLANT_SWAP_BUTTONS");
+	    if (env && (env[0] == 'y' || env[0] == 'Y')) {
 		if (button == LEFT_BUTTON)
 		    button = RIGHT_BUTTON;
 		else
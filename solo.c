@@ -142,63 +142,94 @@ enum {
  * these arrays contain a list of bitmasks for each sum value, where if
  * bit N is set, it means that N occurs in the sum.  Each list is
  * terminated by a zero if it is shorter than the size of the array.
+ *
+ * The tables are written out in full, rather than being filled in at
+ * run time, so that nothing in this back end writes to static storage
+ * and several games can be generated at once on different threads.
  */
 #define MAX_2SUMS 5
 #define MAX_3SUMS 8
 #define MAX_4SUMS 12
-static unsigned long sum_bits2[18][MAX_2SUMS];
-static unsigned long sum_bits3[25][MAX_3SUMS];
-static unsigned long sum_bits4[31][MAX_4SUMS];
-
-static int find_sum_bits(unsigned long *array, int idx, int value_left,
-			 int addends_left, int min_addend,
-			 unsigned long bitmask_so_far)
-{
-    int i;
-    assert(addends_left >= 2);
-
-    for (i = min_addend; i < value_left; i++) {
-	unsigned long new_bitmask = bitmask_so_far | (1L << i);
-	assert(bitmask_so_far != new_bitmask);
-
-	if (addends_left == 2) {
-	    int j = value_left - i;
-	    if (j <= i)
-		break;
-	    if (j > 9)
-		continue;
-	    array[idx++] = new_bitmask | (1L << j);
-	} else
-	    idx = find_sum_bits(array, idx, value_left - i,
-				addends_left - 1, i + 1,
-				new_bitmask);
-    }
-    return idx;
-}
-
-static void precompute_sum_bits(void)
-{
-    int i;
-    for (i = 3; i < 31; i++) {
-	int j;
-	if (i < 18) {
-	    j = find_sum_bits(sum_bits2[i], 0, i, 2, 1, 0);
-	    assert (j <= MAX_2SUMS);
-	    if (j < MAX_2SUMS)
-		sum_bits2[i][j] = 0;
-	}
-	if (i < 25) {
-	    j = find_sum_bits(sum_bits3[i], 0, i, 3, 1, 0);
-	    assert (j <= MAX_3SUMS);
-	    if (j < MAX_3SUMS)
-		sum_bits3[i][j] = 0;
-	}
-	j = find_sum_bits(sum_bits4[i], 0, i, 4, 1, 0);
-	assert (j <= MAX_4SUMS);
-	if (j < MAX_4SUMS)
-	    sum_bits4[i][j] = 0;
-    }
-}
+static const unsigned long sum_bits2[18][MAX_2SUMS] = {
+    {0},
+    {0},
+    {0},
+    {0x006},
+    {0x00a},
+    {0x012,0x00c},
+    {0x022,0x014},
+    {0x042,0x024,0x018},
+    {0x082,0x044,0x028},
+    {0x102,0x084,0x048,0x030},
+    {0x202,0x104,0x088,0x050},
+    {0x204,0x108,0x090,0x060},
+    {0x208,0x110,0x0a0},
+    {0x210,0x120,0x0c0},
+    {0x220,0x140},
+    {0x240,0x180},
+    {0x280},
+    {0x300},
+};
+static const unsigned long sum_bits3[25][MAX_3SUMS] = {
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0x00e},
+    {0x016},
+    {0x026,0x01a},
+    {0x046,0x02a,0x01c},
+    {0x086,0x04a,0x032,0x02c},
+    {0x106,0x08a,0x052,0x04c,0x034},
+    {0x206,0x10a,0x092,0x062,0x08c,0x054,0x038},
+    {0x20a,0x112,0x0a2,0x10c,0x094,0x064,0x058},
+    {0x212,0x122,0x0c2,0x20c,0x114,0x0a4,0x098,0x068},
+    {0x222,0x142,0x214,0x124,0x0c4,0x118,0x0a8,0x070},
+    {0x242,0x182,0x224,0x144,0x218,0x128,0x0c8,0x0b0},
+    {0x282,0x244,0x184,0x228,0x148,0x130,0x0d0},
+    {0x302,0x284,0x248,0x188,0x230,0x150,0x0e0},
+    {0x304,0x288,0x250,0x190,0x160},
+    {0x308,0x290,0x260,0x1a0},
+    {0x310,0x2a0,0x1c0},
+    {0x320,0x2c0},
+    {0x340},
+    {0x380},
+};
+static const unsigned long sum_bits4[31][MAX_4SUMS] = {
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0},
+    {0x01e},
+    {0x02e},
+    {0x04e,0x036},
+    {0x08e,0x056,0x03a},
+    {0x10e,0x096,0x066,0x05a,0x03c},
+    {0x20e,0x116,0x0a6,0x09a,0x06a,0x05c},
+    {0x216,0x126,0x0c6,0x11a,0x0aa,0x072,0x09c,0x06c},
+    {0x226,0x146,0x21a,0x12a,0x0ca,0x0b2,0x11c,0x0ac,0x074},
+    {0x246,0x186,0x22a,0x14a,0x132,0x0d2,0x21c,0x12c,0x0cc,0x0b4,0x078},
+    {0x286,0x24a,0x18a,0x232,0x152,0x0e2,0x22c,0x14c,0x134,0x0d4,0x0b8},
+    {0x306,0x28a,0x252,0x192,0x162,0x24c,0x18c,0x234,0x154,0x0e4,0x138,0x0d8},
+    {0x30a,0x292,0x262,0x1a2,0x28c,0x254,0x194,0x164,0x238,0x158,0x0e8},
+    {0x312,0x2a2,0x1c2,0x30c,0x294,0x264,0x1a4,0x258,0x198,0x168,0x0f0},
+    {0x322,0x2c2,0x314,0x2a4,0x1c4,0x298,0x268,0x1a8,0x170},
+    {0x342,0x324,0x2c4,0x318,0x2a8,0x1c8,0x270,0x1b0},
+    {0x382,0x344,0x328,0x2c8,0x2b0,0x1d0},
+    {0x384,0x348,0x330,0x2d0,0x1e0},
+    {0x388,0x350,0x2e0},
+    {0x390,0x360},
+    {0x3a0},
+    {0x3c0},
+};
 
 struct game_params {
     /*
@@ -708,14 +739,19 @@ struct solver_usage {
     int cr;
     struct block_structure *blocks, *kblocks, *extra_cages;
     /*
-     * We set up a cubic array, indexed by x, y and digit; each
-     * element of this array is true or false according to whether
-     * or not that digit _could_ in principle go in that position.
+     * We set up a cubic array of bits, indexed by x, y and digit;
+     * each bit is set or clear according to whether or not that
+     * digit _could_ in principle go in that position.
      *
-     * The way to index this array is cube[(y*cr+x)*cr+n-1]; there
-     * are macros below to help with this.
+     * The bits for each square are packed into a single word, with
+     * digit n in bit n-1, so cand[y*cr+x] is the candidate set for
+     * that square and can be counted or searched a word at a time.
+     * A single bit of the cube is addressed by a `cube position'
+     * (y*cr+x) << CUBE_SHIFT | (n-1); there are macros below to help
+     * with this. Cube positions sort in the same order as (square,
+     * digit) pairs, which solver_intersect relies on.
      */
-    bool *cube;
+    unsigned long *cand;
     /*
      * This is the grid in which we write down our final
      * deductions. y-coordinates in here are _not_ transformed.
@@ -744,10 +780,17 @@ struct solver_usage {
     int nr_regions;
     int **sq2region;
 };
-#define cubepos2(xy,n) ((xy)*usage->cr+(n)-1)
+#define CUBE_SHIFT 5                   /* enough for 31 digits */
+#define cubepos2(xy,n) (((xy) << CUBE_SHIFT) + (n)-1)
 #define cubepos(x,y,n) cubepos2((y)*usage->cr+(x),n)
-#define cube(x,y,n) (usage->cube[cubepos(x,y,n)])
-#define cube2(xy,n) (usage->cube[cubepos2(xy,n)])
+#define cubesquare(p) ((p) >> CUBE_SHIFT)
+#define cubedigit(p) (((p) & ((1 << CUBE_SHIFT) - 1)) + 1)
+#define cubebit(p) (1UL << ((p) & ((1 << CUBE_SHIFT) - 1)))
+#define cubetest(p) ((usage->cand[cubesquare(p)] & cubebit(p)) != 0)
+#define cubeclear(p) (usage->cand[cubesquare(p)] &= ~cubebit(p))
+#define cube(x,y,n) cubetest(cubepos(x,y,n))
+#define cube2(xy,n) cubetest(cubepos2(xy,n))
+#define DIGITBIT(n) (1UL << ((n)-1))
 
 #define ondiag0(xy) ((xy) % (cr+1) == 0)
 #define ondiag1(xy) ((xy) % (cr-1) == 0 && (xy) > 0 && (xy) < cr*cr-1)
@@ -770,23 +813,21 @@ static void solver_place(struct solver_usage *usage, int x, int y, int n)
     /*
      * Rule out all other numbers in this square.
      */
-    for (i = 1; i <= cr; i++)
-	if (i != n)
-	    cube(x,y,i) = false;
+    usage->cand[sqindex] = DIGITBIT(n);
 
     /*
      * Rule out this number in all other positions in the row.
      */
     for (i = 0; i < cr; i++)
 	if (i != y)
-	    cube(x,i,n) = false;
+	    cubeclear(cubepos(x,i,n));
 
     /*
      * Rule out this number in all other positions in the column.
      */
     for (i = 0; i < cr; i++)
 	if (i != x)
-	    cube(i,y,n) = false;
+	    cubeclear(cubepos(i,y,n));
 
     /*
      * Rule out this number in all other positions in the block.
@@ -795,7 +836,7 @@ static void solver_place(struct solver_usage *usage, int x, int y, int n)
     for (i = 0; i < cr; i++) {
 	int bp = usage->blocks->blocks[bi][i];
 	if (bp != sqindex)
-	    cube2(bp,n) = false;
+	    cubeclear(cubepos2(bp,n));
     }
 
     /*
@@ -814,13 +855,13 @@ static void solver_place(struct solver_usage *usage, int x, int y, int n)
 	if (ondiag0(sqindex)) {
 	    for (i = 0; i < cr; i++)
 		if (diag0(i) != sqindex)
-		    cube2(diag0(i),n) = false;
+		    cubeclear(cubepos2(diag0(i),n));
 	    usage->diag[n-1] = true;
 	}
 	if (ondiag1(sqindex)) {
 	    for (i = 0; i < cr; i++)
 		if (diag1(i) != sqindex)
-		    cube2(diag1(i),n) = false;
+		    cubeclear(cubepos2(diag1(i),n));
 	    usage->diag[cr+n-1] = true;
 	}
     }
@@ -856,24 +897,31 @@ static int solver_elim(struct solver_usage *usage, int *indices
 
     /*
      * Count the number of set bits within this section of the
-     * cube.
+     * cube. If the section is the whole of one square, as it is for
+     * every `which number goes here' check, it's a single word.
      */
-    m = 0;
-    fpos = -1;
-    for (i = 0; i < cr; i++)
-	if (usage->cube[indices[i]]) {
-	    fpos = indices[i];
-	    m++;
-	}
+    if (cubesquare(indices[0]) == cubesquare(indices[cr-1])) {
+        unsigned long bits = usage->cand[cubesquare(indices[0])];
+        m = count_bits(bits);
+        fpos = (bits ? cubepos2(cubesquare(indices[0]),
+                                1 + lowest_bit(bits)) : -1);
+    } else {
+        m = 0;
+        fpos = -1;
+        for (i = 0; i < cr; i++)
+            if (cubetest(indices[i])) {
+                fpos = indices[i];
+                m++;
+            }
+    }
 
     if (m == 1) {
 	int x, y, n;
 	assert(fpos >= 0);
 
-	n = 1 + fpos % cr;
-	x = fpos / cr;
-	y = x / cr;
-	x %= cr;
+	n = cubedigit(fpos);
+	x = cubesquare(fpos) % cr;
+	y = cubesquare(fpos) / cr;
 
         if (!usage->grid[y*cr+x]) {
 #ifdef STANDALONE_SOLVER
@@ -926,7 +974,7 @@ static int solver_intersect(struct solver_usage *usage,
         int p = indices1[i];
 	while (j < cr && indices2[j] < p)
 	    j++;
-        if (usage->cube[p]) {
+        if (cubetest(p)) {
 	    if (j < cr && indices2[j] == p)
 		continue;	       /* both domains contain this index */
 	    else
@@ -945,7 +993,7 @@ static int solver_intersect(struct solver_usage *usage,
         int p = indices2[i];
 	while (j < cr && indices1[j] < p)
 	    j++;
-        if (usage->cube[p] && (j >= cr || indices1[j] != p)) {
+        if (cubetest(p) && (j >= cr || indices1[j] != p)) {
 #ifdef STANDALONE_SOLVER
             if (solver_show_working) {
                 int px, py, pn;
@@ -959,17 +1007,16 @@ static int solver_intersect(struct solver_usage *usage,
                     printf(":\n");
                 }
 
-                pn = 1 + p % cr;
-                px = p / cr;
-                py = px / cr;
-                px %= cr;
+                pn = cubedigit(p);
+                px = cubesquare(p) % cr;
+                py = cubesquare(p) / cr;
 
                 printf("%*s  ruling out %d at (%d,%d)\n",
                        solver_recurse_depth*4, "", pn, 1+px, 1+py);
             }
 #endif
             ret = +1;		       /* we did something */
-            usage->cube[p] = false;
+            cubeclear(p);
         }
     }
 
@@ -977,7 +1024,8 @@ static int solver_intersect(struct solver_usage *usage,
 }
 
 struct solver_scratch {
-    unsigned char *grid, *rowidx, *colidx, *set;
+    unsigned char *grid, *rowidx, *colidx;
+    unsigned long *rows;
     int *neighbours, *bfsqueue;
     int *indexlist, *indexlist2;
 #ifdef STANDALONE_SOLVER
@@ -994,11 +1042,11 @@ static int solver_set(struct solver_usage *usage,
                       )
 {
     int cr = usage->cr;
-    int i, j, n, count;
-    unsigned char *grid = scratch->grid;
+    int i, j, n;
+    unsigned long *rows = scratch->rows;
     unsigned char *rowidx = scratch->rowidx;
     unsigned char *colidx = scratch->colidx;
-    unsigned char *set = scratch->set;
+    unsigned long set, setlimit;
 
     /*
      * We are passed a cr-by-cr matrix of booleans. Our first job
@@ -1010,9 +1058,21 @@ static int solver_set(struct solver_usage *usage,
     memset(colidx, 1, cr);
     for (i = 0; i < cr; i++) {
         int count = 0, first = -1;
-        for (j = 0; j < cr; j++)
-            if (usage->cube[indices[i*cr+j]])
-                first = j, count++;
+
+        if (cubesquare(indices[i*cr]) == cubesquare(indices[i*cr+cr-1])) {
+            /*
+             * This row is all the digits of one square, in order,
+             * so we can read it straight out of that square's word.
+             */
+            unsigned long bits = usage->cand[cubesquare(indices[i*cr])];
+            count = count_bits(bits);
+            if (bits)
+                first = lowest_bit(bits);
+        } else {
+            for (j = 0; j < cr; j++)
+                if (cubetest(indices[i*cr+j]))
+                    first = j, count++;
+        }
 
 	/*
 	 * If count == 0, then there's a row with no 1s at all and
@@ -1051,11 +1111,17 @@ static int solver_set(struct solver_usage *usage,
     assert(n == j);
 
     /*
-     * And create the smaller matrix.
+     * And create the smaller matrix, with each row packed into a
+     * word. Column j of the matrix goes in bit n-1-j, so that a set
+     * of columns is also a word, and counting through sets of
+     * columns in the order we want is just incrementing it.
      */
-    for (i = 0; i < n; i++)
+    for (i = 0; i < n; i++) {
+        rows[i] = 0;
         for (j = 0; j < n; j++)
-            grid[i*cr+j] = usage->cube[indices[rowidx[i]*cr+colidx[j]]];
+            if (cubetest(indices[rowidx[i]*cr+colidx[j]]))
+                rows[i] |= 1UL << (n-1-j);
+    }
 
     /*
      * Having done that, we now have a matrix in which every row
@@ -1064,10 +1130,10 @@ static int solver_set(struct solver_usage *usage,
      * `rectangle', i.e. a subset of rows crossed with a subset of
      * columns) whose width and height add up to n.
      */
+    setlimit = (n > 0 ? 2UL << (n-1) : 1);
+    for (set = 0; set < setlimit; set++) {
+        int count = count_bits(set);
 
-    memset(set, 0, n);
-    count = 0;
-    while (1) {
         /*
          * We have a candidate set. If its size is <=1 or >=n-1
          * then we move on immediately.
@@ -1078,17 +1144,10 @@ static int solver_set(struct solver_usage *usage,
              * find that many rows which each have a zero in all
              * the positions listed in `set'.
              */
-            int rows = 0;
-            for (i = 0; i < n; i++) {
-                bool ok = true;
-                for (j = 0; j < n; j++)
-                    if (set[j] && grid[i*cr+j]) {
-                        ok = false;
-                        break;
-                    }
-                if (ok)
-                    rows++;
-            }
+            int nrows = 0;
+            for (i = 0; i < n; i++)
+                if (!(rows[i] & set))
+                    nrows++;
 
             /*
              * We expect never to be able to get _more_ than
@@ -1098,7 +1157,7 @@ static int solver_set(struct solver_usage *usage,
              * indicates a faulty deduction before this point or
              * even a bogus clue.
              */
-            if (rows > n - count) {
+            if (nrows > n - count) {
 #ifdef STANDALONE_SOLVER
 		if (solver_show_working) {
 		    va_list ap;
@@ -1114,7 +1173,7 @@ static int solver_set(struct solver_usage *usage,
 		return -1;
 	    }
 
-            if (rows >= n - count) {
+            if (nrows >= n - count) {
                 bool progress = false;
 
                 /*
@@ -1129,15 +1188,9 @@ static int solver_set(struct solver_usage *usage,
                  * positions in the cube to meddle with.
                  */
                 for (i = 0; i < n; i++) {
-                    bool ok = true;
-                    for (j = 0; j < n; j++)
-                        if (set[j] && grid[i*cr+j]) {
-                            ok = false;
-                            break;
-                        }
-                    if (!ok) {
+                    if (rows[i] & set) {
                         for (j = 0; j < n; j++)
-                            if (!set[j] && grid[i*cr+j]) {
+                            if (rows[i] & ~set & (1UL << (n-1-j))) {
                                 int fpos = indices[rowidx[i]*cr+colidx[j]];
 #ifdef STANDALONE_SOLVER
                                 if (solver_show_working) {
@@ -1153,10 +1206,9 @@ static int solver_set(struct solver_usage *usage,
                                         printf(":\n");
                                     }
 
-                                    pn = 1 + fpos % cr;
-                                    px = fpos / cr;
-                                    py = px / cr;
-                                    px %= cr;
+                                    pn = cubedigit(fpos);
+                                    px = cubesquare(fpos) % cr;
+                                    py = cubesquare(fpos) / cr;
 
                                     printf("%*s  ruling out %d at (%d,%d)\n",
 					   solver_recurse_depth*4, "",
@@ -1164,7 +1216,7 @@ static int solver_set(struct solver_usage *usage,
                                 }
 #endif
                                 progress = true;
-                                usage->cube[fpos] = false;
+                                cubeclear(fpos);
                             }
                     }
                 }
@@ -1174,18 +1226,6 @@ static int solver_set(struct solver_usage *usage,
                 }
             }
         }
-
-        /*
-         * Binary increment: change the rightmost 0 to a 1, and
-         * change all 1s to the right of it to 0s.
-         */
-        i = n;
-        while (i > 0 && set[i-1])
-            set[--i] = 0, count--;
-        if (i > 0)
-            set[--i] = 1, count++;
-        else
-            break;                     /* done */
     }
 
     return 0;
@@ -1241,22 +1281,22 @@ static int solver_forcing(struct solver_usage *usage,
 
     for (y = 0; y < cr; y++)
         for (x = 0; x < cr; x++) {
-            int count, t, n;
+            int t, n;
 
             /*
              * If this square doesn't have exactly two candidate
              * numbers, don't try it.
              * 
-             * In this loop we also sum the candidate numbers,
-             * which is a nasty hack to allow us to quickly find
+             * We also sum the candidate numbers, which is a
+             * nasty hack to allow us to quickly find
              * `the other one' (since we will shortly know there
              * are exactly two).
              */
-            for (count = t = 0, n = 1; n <= cr; n++)
-                if (cube(x, y, n))
-                    count++, t += n;
-            if (count != 2)
+            if (count_bits(usage->cand[y*cr+x]) != 2)
                 continue;
+            for (t = 0, n = 1; n <= cr; n++)
+                if (cube(x, y, n))
+                    t += n;
 
             /*
              * Now attempt a bfs for each candidate.
@@ -1314,7 +1354,7 @@ static int solver_forcing(struct solver_usage *usage,
                          * Try visiting each of those neighbours.
                          */
                         for (i = 0; i < nneighbours; i++) {
-                            int cc, tt, nn;
+                            int tt, nn;
 
                             xt = neighbours[i] % cr;
                             yt = neighbours[i] / cr;
@@ -1341,10 +1381,10 @@ static int solver_forcing(struct solver_usage *usage,
                              * this square to have exactly two
                              * possible numbers.
                              */
-                            for (cc = tt = 0, nn = 1; nn <= cr; nn++)
-                                if (cube(xt, yt, nn))
-                                    cc++, tt += nn;
-                            if (cc == 2) {
+                            if (count_bits(usage->cand[yt*cr+xt]) == 2) {
+                                for (tt = 0, nn = 1; nn <= cr; nn++)
+                                    if (cube(xt, yt, nn))
+                                        tt += nn;
                                 bfsqueue[tail++] = yt*cr+xt;
 #ifdef STANDALONE_SOLVER
                                 bfsprev[yt*cr+xt] = yy*cr+xx;
@@ -1387,7 +1427,7 @@ static int solver_forcing(struct solver_usage *usage,
                                            orign, 1+xt, 1+yt);
                                 }
 #endif
-                                cube(xt, yt, orign) = false;
+                                cubeclear(cubepos(xt, yt, orign));
                                 return 1;
                             }
                         }
@@ -1438,7 +1478,7 @@ static int solver_killer_minmax(struct solver_usage *usage,
 			}
 		}
 		if (maxval + n < clues[b]) {
-		    cube2(x, n) = false;
+		    cubeclear(cubepos2(x, n));
 		    ret = 1;
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working)
@@ -1448,7 +1488,7 @@ static int solver_killer_minmax(struct solver_usage *usage,
 #endif
 		}
 		if (minval + n > clues[b]) {
-		    cube2(x, n) = false;
+		    cubeclear(cubepos2(x, n));
 		    ret = 1;
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working)
@@ -1473,7 +1513,8 @@ static int solver_killer_sums(struct solver_usage *usage, int b,
     int cr = usage->cr;
     int i, ret, max_sums;
     int nsquares = cages->nr_squares[b];
-    unsigned long *sumbits, possible_addends;
+    const unsigned long *sumbits;
+    unsigned long possible_addends;
 
     if (clue == 0) {
 	assert(nsquares == 0);
@@ -1581,7 +1622,7 @@ static int solver_killer_sums(struct solver_usage *usage, int b,
 	    if (!cube2(x, n))
 		continue;
 	    if ((possible_addends & (1 << n)) == 0) {
-		cube2(x, n) = false;
+		cubeclear(cubepos2(x, n));
 		ret = 1;
 #ifdef STANDALONE_SOLVER
 		if (solver_show_working) {
@@ -1655,40 +1696,25 @@ static int filter_whole_cages(struct solver_usage *usage, int *squares, int n,
     return off;
 }
 
-static struct solver_scratch *solver_new_scratch(struct solver_usage *usage)
+static struct solver_scratch *solver_new_scratch(struct solver_usage *usage,
+                                                 arena *ar)
 {
-    struct solver_scratch *scratch = snew(struct solver_scratch);
+    struct solver_scratch *scratch = anew(ar, struct solver_scratch);
     int cr = usage->cr;
-    scratch->grid = snewn(cr*cr, unsigned char);
-    scratch->rowidx = snewn(cr, unsigned char);
-    scratch->colidx = snewn(cr, unsigned char);
-    scratch->set = snewn(cr, unsigned char);
-    scratch->neighbours = snewn(5*cr, int);
-    scratch->bfsqueue = snewn(cr*cr, int);
+    scratch->grid = anewn(ar, cr*cr, unsigned char);
+    scratch->rowidx = anewn(ar, cr, unsigned char);
+    scratch->colidx = anewn(ar, cr, unsigned char);
+    scratch->rows = anewn(ar, cr, unsigned long);
+    scratch->neighbours = anewn(ar, 5*cr, int);
+    scratch->bfsqueue = anewn(ar, cr*cr, int);
 #ifdef STANDALONE_SOLVER
-    scratch->bfsprev = snewn(cr*cr, int);
+    scratch->bfsprev = anewn(ar, cr*cr, int);
 #endif
-    scratch->indexlist = snewn(cr*cr, int);   /* used for set elimination */
-    scratch->indexlist2 = snewn(cr, int);   /* only used for intersect() */
+    scratch->indexlist = anewn(ar, cr*cr, int); /* used for set elimination */
+    scratch->indexlist2 = anewn(ar, cr, int); /* only used for intersect() */
     return scratch;
 }
 
-static void solver_free_scratch(struct solver_scratch *scratch)
-{
-#ifdef STANDALONE_SOLVER
-    sfree(scratch->bfsprev);
-#endif
-    sfree(scratch->bfsqueue);
-    sfree(scratch->neighbours);
-    sfree(scratch->set);
-    sfree(scratch->colidx);
-    sfree(scratch->rowidx);
-    sfree(scratch->grid);
-    sfree(scratch->indexlist);
-    sfree(scratch->indexlist2);
-    sfree(scratch);
-}
-
 /*
  * Used for passing information about difficulty levels between the solver
  * and its callers.
@@ -1698,35 +1724,34 @@ struct difficulty {
     int maxdiff, maxkdiff;
     /* Levels reached by the solver.  */
     int diff, kdiff;
+    /* Resort to exact cover search (dlx.c) rather than recursion.  */
+    bool exact_cover;
 };
 
-static void solver(int cr, struct block_structure *blocks,
-		  struct block_structure *kblocks, bool xtype,
-		  digit *grid, digit *kgrid, struct difficulty *dlev)
+/*
+ * Set up a usage structure as a clean slate (everything possible),
+ * allocated from 'ar'.
+ */
+static struct solver_usage *solver_new_usage(
+    int cr, struct block_structure *blocks, struct block_structure *kblocks,
+    bool xtype, digit *grid, digit *kgrid, arena *ar)
 {
     struct solver_usage *usage;
-    struct solver_scratch *scratch;
-    int x, y, b, i, n, ret;
-    int diff = DIFF_BLOCK;
-    int kdiff = DIFF_KSINGLE;
+    int x, y, b, i, n;
 
-    /*
-     * Set up a usage structure as a clean slate (everything
-     * possible).
-     */
-    usage = snew(struct solver_usage);
+    usage = anew(ar, struct solver_usage);
     usage->cr = cr;
     usage->blocks = blocks;
     if (kblocks) {
 	usage->kblocks = dup_block_structure(kblocks);
 	usage->extra_cages = alloc_block_structure (kblocks->c, kblocks->r,
 						    cr * cr, cr, cr * cr);
-	usage->extra_clues = snewn(cr*cr, digit);
+	usage->extra_clues = anewn(ar, cr*cr, digit);
     } else {
 	usage->kblocks = usage->extra_cages = NULL;
 	usage->extra_clues = NULL;
     }
-    usage->cube = snewn(cr*cr*cr, bool);
+    usage->cand = anewn(ar, cr*cr, unsigned long);
     usage->grid = grid;		       /* write straight back to the input */
     if (kgrid) {
 	int nclues;
@@ -1737,7 +1762,7 @@ static void solver(int cr, struct block_structure *blocks,
 	 * Allow for expansion of the killer regions, the absolute
 	 * limit is obviously one region per square.
 	 */
-	usage->kclues = snewn(cr*cr, digit);
+	usage->kclues = anewn(ar, cr*cr, digit);
 	for (i = 0; i < nclues; i++) {
 	    for (n = 0; n < kblocks->nr_squares[i]; n++)
 		if (kgrid[kblocks->blocks[i][n]] != 0)
@@ -1749,25 +1774,25 @@ static void solver(int cr, struct block_structure *blocks,
 	usage->kclues = NULL;
     }
 
-    for (i = 0; i < cr*cr*cr; i++)
-        usage->cube[i] = true;
+    for (i = 0; i < cr*cr; i++)
+        usage->cand[i] = (1UL << cr) - 1;
 
-    usage->row = snewn(cr * cr, bool);
-    usage->col = snewn(cr * cr, bool);
-    usage->blk = snewn(cr * cr, bool);
+    usage->row = anewn(ar, cr * cr, bool);
+    usage->col = anewn(ar, cr * cr, bool);
+    usage->blk = anewn(ar, cr * cr, bool);
     memset(usage->row, 0, cr * cr * sizeof(bool));
     memset(usage->col, 0, cr * cr * sizeof(bool));
     memset(usage->blk, 0, cr * cr * sizeof(bool));
 
     if (xtype) {
-	usage->diag = snewn(cr * 2, bool);
+	usage->diag = anewn(ar, cr * 2, bool);
 	memset(usage->diag, 0, cr * 2 * sizeof(bool));
     } else
 	usage->diag = NULL; 
 
     usage->nr_regions = cr * 3 + (xtype ? 2 : 0);
-    usage->regions = snewn(cr * usage->nr_regions, int);
-    usage->sq2region = snewn(cr * cr * 3, int *);
+    usage->regions = anewn(ar, cr * usage->nr_regions, int);
+    usage->sq2region = anewn(ar, cr * cr * 3, int *);
 
     for (n = 0; n < cr; n++) {
 	for (i = 0; i < cr; i++) {
@@ -1783,7 +1808,176 @@ static void solver(int cr, struct block_structure *blocks,
 	}
     }
 
-    scratch = solver_new_scratch(usage);
+    return usage;
+}
+
+/*
+ * Blockwise positional elimination: the simplest deduction the
+ * solver makes, and the first it tries. We keep going until there's
+ * nothing more to be done, and return +1 if we made any progress,
+ * 0 if none, or -1 on finding a contradiction.
+ *
+ * It doesn't matter what order we do this in. Every deduction made
+ * here stays valid after any other, so we end up in the same state
+ * whatever order we make them in; so rather than going back to the
+ * first block after each one, we finish each pass over the blocks
+ * before starting another.
+ */
+static int solver_blockwise(struct solver_usage *usage,
+                            struct solver_scratch *scratch)
+{
+    int cr = usage->cr;
+    int b, i, n, ret;
+    bool progress = false, pass_progress;
+
+    do {
+        pass_progress = false;
+        for (b = 0; b < cr; b++)
+            for (n = 1; n <= cr; n++)
+                if (!usage->blk[b*cr+n-1]) {
+                    for (i = 0; i < cr; i++)
+                        scratch->indexlist[i] =
+                            cubepos2(usage->blocks->blocks[b][i],n);
+                    ret = solver_elim(usage, scratch->indexlist
+#ifdef STANDALONE_SOLVER
+                                      , "positional elimination,"
+                                      " %d in block %s", n,
+                                      usage->blocks->blocknames[b]
+#endif
+                                      );
+                    if (ret < 0)
+                        return -1;
+                    if (ret > 0)
+                        pass_progress = progress = true;
+                }
+    } while (pass_progress);
+
+    return progress ? +1 : 0;
+}
+
+/*
+ * A checkpoint of the solver's state, for generators that call the
+ * solver over and over on puzzles sharing a set of clues they know
+ * will stay. It records the state after placing just those clues and
+ * making every blockwise positional elimination that follows from
+ * them. A solver run given the checkpoint starts from there, placing
+ * only the rest of its clues.
+ *
+ * That gives exactly the same result as starting from scratch. The
+ * solver always runs blockwise elimination to a standstill before
+ * trying anything else, and doing so reaches the same state whatever
+ * order the deductions are made in, and whether or not some of the
+ * clues were dealt with first; so by the time any deduction that
+ * affects the difficulty rating is made, the two runs are in the same
+ * state, and from then on they're identical.
+ */
+struct solver_checkpoint {
+    arena *ar;
+    digit *grid;
+    struct solver_usage *usage;
+    struct solver_scratch *scratch;
+};
+
+/*
+ * The alternative to guessing at the end of solver(): hand whatever
+ * candidates are left to an exact cover search, which is much less
+ * prone than our own recursion to wandering off into huge fruitless
+ * subtrees. Each candidate digit in each square is a row of the
+ * matrix, and the columns say that each square gets one digit and
+ * each row, column, block and (for X-type puzzles) diagonal gets
+ * each digit once. Killer cage sums aren't exact cover constraints,
+ * so Killer puzzles can't come here.
+ *
+ * Returns DIFF_IMPOSSIBLE, DIFF_RECURSIVE or DIFF_AMBIGUOUS like the
+ * recursion would, and likewise fills in the grid with the first
+ * solution found, if any.
+ */
+static int solver_exact_cover(struct solver_usage *usage, digit *grid,
+                              arena *ar)
+{
+    int cr = usage->cr, area = cr*cr;
+    int ndiag = usage->diag ? 2 : 0;
+    int *rowsq, *rows, cols[6];
+    int xy, n, i, k, count;
+    dlx *d;
+
+    assert(!usage->kblocks);
+
+    d = dlx_new(4*area + ndiag*cr, 0);
+    rowsq = anewn(ar, area * cr, int);
+    rows = anewn(ar, area, int);
+
+    for (xy = 0; xy < area; xy++)
+        for (n = 1; n <= cr; n++) {
+            if (!cube2(xy, n))
+                continue;
+            k = 0;
+            cols[k++] = xy;
+            cols[k++] = area + (xy / cr) * cr + n-1;
+            cols[k++] = 2*area + (xy % cr) * cr + n-1;
+            cols[k++] = 3*area + usage->blocks->whichblock[xy] * cr + n-1;
+            if (usage->diag && ondiag0(xy))
+                cols[k++] = 4*area + n-1;
+            if (usage->diag && ondiag1(xy))
+                cols[k++] = 4*area + cr + n-1;
+            rowsq[dlx_add_row(d, cols, k)] = cubepos2(xy, n);
+        }
+
+    count = dlx_solve(d, 2);
+    k = dlx_solution(d, rows);
+    for (i = 0; i < k; i++)
+        grid[cubesquare(rowsq[rows[i]])] = cubedigit(rowsq[rows[i]]);
+    dlx_free(d);
+
+    return (count == 0 ? DIFF_IMPOSSIBLE :
+            count == 1 ? DIFF_RECURSIVE : DIFF_AMBIGUOUS);
+}
+
+/*
+ * All the solver's working storage comes from the arena 'ar', and is
+ * given back to it on return, so that a generator calling the solver
+ * over and over again doesn't go back to the system allocator every
+ * time. The arena is rewound rather than reset, because the solver
+ * calls itself recursively to make guesses.
+ */
+static void solver(int cr, struct block_structure *blocks,
+		  struct block_structure *kblocks, bool xtype,
+		  digit *grid, digit *kgrid, struct difficulty *dlev,
+		  arena *ar, const struct solver_checkpoint *ck)
+{
+    struct solver_usage *usage;
+    struct solver_scratch *scratch;
+    arena_mark mark = arena_get_mark(ar);
+    int x, y, b, i, n, ret;
+    int diff = DIFF_BLOCK;
+    int kdiff = DIFF_KSINGLE;
+
+    usage = solver_new_usage(cr, blocks, kblocks, xtype, grid, kgrid, ar);
+    scratch = solver_new_scratch(usage, ar);
+
+    /*
+     * If we've been given a checkpoint, start from its state. Its
+     * clues and deductions go into our grid, and don't need placing
+     * again below.
+     */
+    if (ck) {
+        struct solver_usage *ckusage = ck->usage;
+
+        memcpy(usage->cand, ckusage->cand, cr * cr * sizeof(unsigned long));
+        memcpy(usage->row, ckusage->row, cr * cr * sizeof(bool));
+        memcpy(usage->col, ckusage->col, cr * cr * sizeof(bool));
+        memcpy(usage->blk, ckusage->blk, cr * cr * sizeof(bool));
+        if (xtype)
+            memcpy(usage->diag, ckusage->diag, cr * 2 * sizeof(bool));
+        for (i = 0; i < cr*cr; i++)
+            if (ck->grid[i]) {
+                if (grid[i] && grid[i] != ck->grid[i]) {
+                    diff = DIFF_IMPOSSIBLE;
+                    goto got_result;
+                }
+                grid[i] = ck->grid[i];
+            }
+    }
 
     /*
      * Place all the clue numbers we are given.
@@ -1791,7 +1985,7 @@ static void solver(int cr, struct block_structure *blocks,
     for (x = 0; x < cr; x++)
 	for (y = 0; y < cr; y++) {
             int n = grid[y*cr+x];
-	    if (n) {
+	    if (n && !(ck && ck->grid[y*cr+x])) {
                 if (!cube(x,y,n)) {
                     diff = DIFF_IMPOSSIBLE;
                     goto got_result;
@@ -1818,28 +2012,16 @@ static void solver(int cr, struct block_structure *blocks,
         cont:
 
 	/*
-	 * Blockwise positional elimination.
+	 * Blockwise positional elimination. This runs to a standstill
+	 * by itself, so there's no need to come back round to it.
 	 */
-	for (b = 0; b < cr; b++)
-	    for (n = 1; n <= cr; n++)
-		if (!usage->blk[b*cr+n-1]) {
-		    for (i = 0; i < cr; i++)
-			scratch->indexlist[i] = cubepos2(usage->blocks->blocks[b][i],n);
-		    ret = solver_elim(usage, scratch->indexlist
-#ifdef STANDALONE_SOLVER
-				      , "positional elimination,"
-				      " %d in block %s", n,
-				      usage->blocks->blocknames[b]
-#endif
-				      );
-		    if (ret < 0) {
-			diff = DIFF_IMPOSSIBLE;
-			goto got_result;
-		    } else if (ret > 0) {
-			diff = max(diff, DIFF_BLOCK);
-			goto cont;
-		    }
-		}
+	ret = solver_blockwise(usage, scratch);
+	if (ret < 0) {
+	    diff = DIFF_IMPOSSIBLE;
+	    goto got_result;
+	} else if (ret > 0) {
+	    diff = max(diff, DIFF_BLOCK);
+	}
 
 	if (usage->kclues != NULL) {
 	    bool changed = false;
@@ -1868,7 +2050,7 @@ static void solver(int cr, struct block_structure *blocks,
 		     * about the other squares in the cage.
 		     */
 		    for (n = 0; n < usage->kblocks->nr_squares[b]; n++) {
-			cube2(usage->kblocks->blocks[b][n], t) = false;
+			cubeclear(cubepos2(usage->kblocks->blocks[b][n], t));
 		    }
 		}
 
@@ -2498,10 +2680,7 @@ static void solver(int cr, struct block_structure *blocks,
 		     * An unfilled square. Count the number of
 		     * possible digits in it.
 		     */
-		    count = 0;
-		    for (n = 1; n <= cr; n++)
-			if (cube(x,y,n))
-			    count++;
+		    count = count_bits(usage->cand[y*cr+x]);
 
 		    /*
 		     * We should have found any impossibilities
@@ -2515,7 +2694,14 @@ static void solver(int cr, struct block_structure *blocks,
 		    }
 		}
 
-	if (best != -1) {
+	if (best != -1 && dlev->exact_cover && !usage->kblocks) {
+#ifdef STANDALONE_SOLVER
+	    if (solver_show_working)
+		printf("%*sresorting to exact cover search\n",
+		       solver_recurse_depth*4, "");
+#endif
+	    diff = solver_exact_cover(usage, grid, ar);
+	} else if (best != -1) {
 	    int i, j;
 	    digit *list, *ingrid, *outgrid;
 
@@ -2527,9 +2713,9 @@ static void solver(int cr, struct block_structure *blocks,
 	    y = best / cr;
 	    x = best % cr;
 
-	    list = snewn(cr, digit);
-	    ingrid = snewn(cr * cr, digit);
-	    outgrid = snewn(cr * cr, digit);
+	    list = anewn(ar, cr, digit);
+	    ingrid = anewn(ar, cr * cr, digit);
+	    outgrid = anewn(ar, cr * cr, digit);
 	    memcpy(ingrid, grid, cr * cr);
 
 	    /* Make a list of the possible digits. */
@@ -2565,7 +2751,9 @@ static void solver(int cr, struct block_structure *blocks,
 		solver_recurse_depth++;
 #endif
 
-		solver(cr, blocks, kblocks, xtype, outgrid, kgrid, dlev);
+                genstat_count(GENSTAT_BACKTRACKS);
+		solver(cr, blocks, kblocks, xtype, outgrid, kgrid, dlev, ar,
+                       NULL);
 
 #ifdef STANDALONE_SOLVER
 		solver_recurse_depth--;
@@ -2601,10 +2789,6 @@ static void solver(int cr, struct block_structure *blocks,
 		if (diff == DIFF_AMBIGUOUS)
 		    break;
 	    }
-
-	    sfree(outgrid);
-	    sfree(ingrid);
-	    sfree(list);
 	}
 
     } else {
@@ -2632,21 +2816,54 @@ static void solver(int cr, struct block_structure *blocks,
 	       "one solution");
 #endif
 
-    sfree(usage->sq2region);
-    sfree(usage->regions);
-    sfree(usage->cube);
-    sfree(usage->row);
-    sfree(usage->col);
-    sfree(usage->blk);
     if (usage->kblocks) {
 	free_block_structure(usage->kblocks);
 	free_block_structure(usage->extra_cages);
-	sfree(usage->extra_clues);
     }
-    if (usage->kclues) sfree(usage->kclues);
-    sfree(usage);
 
-    solver_free_scratch(scratch);
+    arena_release(ar, mark);
+}
+
+static struct solver_checkpoint *solver_checkpoint_new(
+    int cr, struct block_structure *blocks, bool xtype)
+{
+    struct solver_checkpoint *ck = snew(struct solver_checkpoint);
+
+    ck->ar = arena_new();
+    ck->grid = anewn(ck->ar, cr*cr, digit);
+    memset(ck->grid, 0, cr*cr * sizeof(digit));
+    ck->usage = solver_new_usage(cr, blocks, NULL, xtype, ck->grid, NULL,
+                                 ck->ar);
+    ck->scratch = solver_new_scratch(ck->usage, ck->ar);
+    return ck;
+}
+
+static void solver_checkpoint_free(struct solver_checkpoint *ck)
+{
+    arena_free(ck->ar);
+    sfree(ck);
+}
+
+/*
+ * Add a clue to a checkpoint. The clues added must all come from a
+ * single valid solution, so there's no question of a contradiction.
+ */
+static void solver_checkpoint_place(struct solver_checkpoint *ck,
+                                    int x, int y, int n)
+{
+    struct solver_usage *usage = ck->usage;
+    int cr = usage->cr;
+    int ret;
+
+    if (ck->grid[y*cr+x]) {
+        assert(ck->grid[y*cr+x] == n);
+        return;                        /* already deduced */
+    }
+
+    assert(cube(x,y,n));
+    solver_place(usage, x, y, n);
+    ret = solver_blockwise(usage, ck->scratch);
+    assert(ret >= 0);
 }
 
 /* ----------------------------------------------------------------------
@@ -2777,6 +2994,7 @@ static bool gridgen_real(struct gridgen_usage *usage, digit *grid, int *steps)
     if (*steps <= 0)
 	return false;
     (*steps)--;
+    genstat_count(GENSTAT_BACKTRACKS);
 
     /*
      * Otherwise, there must be at least one space. Find the most
@@ -3633,6 +3851,67 @@ static key_label *game_request_keys(const game_params *params, int *nkeys)
     return keys;
 }
 
+/*
+ * Report to genstats why new_game_desc threw away a candidate puzzle,
+ * given what the solver said about it.
+ */
+static void count_rejection(const struct difficulty *dlev, bool killer)
+{
+    if (dlev->diff == DIFF_AMBIGUOUS)
+        genstat_count(GENSTAT_REJECT_AMBIGUOUS);
+    else if (dlev->diff == DIFF_IMPOSSIBLE)
+        genstat_count(GENSTAT_REJECT_OTHER);
+    else if (dlev->diff > dlev->maxdiff ||
+             (killer && dlev->kdiff > dlev->maxkdiff))
+        genstat_count(GENSTAT_REJECT_TOO_HARD);
+    else
+        genstat_count(GENSTAT_REJECT_TOO_EASY);
+}
+
+/*
+ * Context for trying several clue removals at once, as described in
+ * new_game_desc. Job j tries removing locs[j] (and its reflections)
+ * on its own from 'grid', which no job modifies, starting the solver
+ * from the checkpoint 'ck' of clues that are staying; each job has its
+ * own copy of the grid to solve, its own arena and its own
+ * difficulty structure, and reports in ok[j] whether the removal
+ * would be acceptable.
+ */
+struct xy { int x, y; };
+struct removal_ctx {
+    const game_params *params;
+    struct block_structure *blocks, *kblocks;
+    digit *grid, *kgrid;
+    const struct xy *locs;
+    digit *grids;                      /* one area-sized grid per job */
+    arena **arenas;
+    const struct solver_checkpoint *ck;
+    struct difficulty dlev;
+    bool *ok;
+};
+
+static void try_removal(void *vctx, int j)
+{
+    struct removal_ctx *ctx = (struct removal_ctx *)vctx;
+    const game_params *params = ctx->params;
+    int cr = params->c * params->r, area = cr*cr;
+    digit *grid2 = ctx->grids + j * area;
+    struct difficulty dlev = ctx->dlev;
+    int coords[16], ncoords, k;
+
+    memcpy(grid2, ctx->grid, area);
+    ncoords = symmetries(params, ctx->locs[j].x, ctx->locs[j].y,
+                         coords, params->symm);
+    for (k = 0; k < ncoords; k++)
+        grid2[coords[2*k+1]*cr+coords[2*k]] = 0;
+
+    solver(cr, ctx->blocks, ctx->kblocks, params->xtype, grid2, ctx->kgrid,
+           &dlev, ctx->arenas[j], ctx->ck);
+    genstat_count(GENSTAT_SOLVER_CALLS);
+    ctx->ok[j] = (dlev.diff <= dlev.maxdiff &&
+                  (!params->killer || dlev.kdiff <= dlev.maxkdiff));
+}
+
 static char *new_game_desc(const game_params *params, random_state *rs,
 			   char **aux, bool interactive)
 {
@@ -3640,14 +3919,16 @@ static char *new_game_desc(const game_params *params, random_state *rs,
     int area = cr*cr;
     struct block_structure *blocks, *kblocks;
     digit *grid, *grid2, *kgrid;
-    struct xy { int x, y; } *locs;
+    struct xy *locs;
     int nlocs;
     char *desc;
     int coords[16], ncoords;
     int x, y, i, j;
     struct difficulty dlev;
-
-    precompute_sum_bits();
+    arena *ar;
+    struct removal_ctx rctx;
+    struct solver_checkpoint *ck;
+    int nspec = parallel_width();
 
     /*
      * Adjust the maximum difficulty level to be consistent with
@@ -3657,6 +3938,7 @@ static char *new_game_desc(const game_params *params, random_state *rs,
      */
     dlev.maxdiff = params->diff;
     dlev.maxkdiff = params->kdiff;
+    dlev.exact_cover = true;
     if (c == 2 && r == 2)
         dlev.maxdiff = DIFF_BLOCK;
 
@@ -3669,6 +3951,17 @@ static char *new_game_desc(const game_params *params, random_state *rs,
     kblocks = NULL;
     kgrid = (params->killer) ? snewn(area, digit) : NULL;
 
+    ar = arena_new();
+
+    rctx.params = params;
+    rctx.blocks = blocks;
+    rctx.grids = snewn(nspec * area, digit);
+    rctx.arenas = snewn(nspec, arena *);
+    rctx.arenas[0] = ar;
+    for (i = 1; i < nspec; i++)
+        rctx.arenas[i] = arena_new();
+    rctx.ok = snewn(nspec, bool);
+
 #ifdef STANDALONE_SOLVER
     assert(!"This should never happen, so we don't need to create blocknames");
 #endif
@@ -3679,6 +3972,8 @@ static char *new_game_desc(const game_params *params, random_state *rs,
      * difficult grids otherwise.
      */
     while (1) {
+        arena_reset(ar);
+
         /*
          * Generate a random solved state, starting by
          * constructing the block structure.
@@ -3695,14 +3990,17 @@ static char *new_game_desc(const game_params *params, random_state *rs,
 		    blocks->whichblock[y*cr+x] = (y/c) * c + (x/r);
 	}
 	make_blocks_from_whichblock(blocks);
+        genstat_count(GENSTAT_ATTEMPTS);
 
 	if (params->killer) {
             if (kblocks) free_block_structure(kblocks);
 	    kblocks = gen_killer_cages(cr, rs, params->kdiff > DIFF_KSINGLE);
 	}
 
-        if (!gridgen(cr, blocks, kblocks, params->xtype, grid, rs, area*area))
+        if (!gridgen(cr, blocks, kblocks, params->xtype, grid, rs, area*area)) {
+            genstat_count(GENSTAT_REJECT_OTHER);
 	    continue;
+        }
         assert(check_valid(cr, blocks, kblocks, NULL, params->xtype, grid));
 
 	/*
@@ -3739,7 +4037,9 @@ static char *new_game_desc(const game_params *params, random_state *rs,
 		compute_kclues(kblocks, kgrid, grid2, area);
 
 		memset(grid, 0, area * sizeof *grid);
-		solver(cr, blocks, kblocks, params->xtype, grid, kgrid, &dlev);
+		solver(cr, blocks, kblocks, params->xtype, grid, kgrid, &dlev,
+                       ar, NULL);
+                genstat_count(GENSTAT_SOLVER_CALLS);
 		if (dlev.diff == dlev.maxdiff && dlev.kdiff == dlev.maxkdiff) {
 		    /*
 		     * We have one that matches our difficulty.  Store it for
@@ -3793,6 +4093,7 @@ static char *new_game_desc(const game_params *params, random_state *rs,
 		memset(grid, 0, area * sizeof *grid);
 		break;
 	    }
+            count_rejection(&dlev, true);
 	    continue;
 	}
 
@@ -3828,34 +4129,74 @@ static char *new_game_desc(const game_params *params, random_state *rs,
          * Now loop over the shuffled list and, for each element,
          * see whether removing that element (and its reflections)
          * from the grid will still leave the grid soluble.
+         *
+         * If the front end has threads to spare, we try the next
+         * several elements at once, each removed on its own from the
+         * current grid. We then take their results in order up to
+         * and including the first removal that succeeded; the ones
+         * after that were tried on a grid that has since lost some
+         * clues, so they're thrown away and tried again. That gives
+         * exactly the same puzzle as trying them one at a time, and
+         * it's cheap, because most of the solver time is spent late
+         * on, when the grid is sparse and most removals fail.
+         *
+         * A clue we fail to remove is never tried again, so it's in
+         * the final puzzle for certain, and goes into a solver
+         * checkpoint which every later trial starts from.
          */
-        for (i = 0; i < nlocs; i++) {
-            x = locs[i].x;
-            y = locs[i].y;
-
-            memcpy(grid2, grid, area);
-            ncoords = symmetries(params, x, y, coords, params->symm);
-            for (j = 0; j < ncoords; j++)
-                grid2[coords[2*j+1]*cr+coords[2*j]] = 0;
-
-            solver(cr, blocks, kblocks, params->xtype, grid2, kgrid, &dlev);
-            if (dlev.diff <= dlev.maxdiff &&
-		(!params->killer || dlev.kdiff <= dlev.maxkdiff)) {
-                for (j = 0; j < ncoords; j++)
-                    grid[coords[2*j+1]*cr+coords[2*j]] = 0;
+        ck = solver_checkpoint_new(cr, blocks, params->xtype);
+        rctx.kblocks = kblocks;
+        rctx.grid = grid;
+        rctx.kgrid = kgrid;
+        rctx.dlev = dlev;
+        rctx.ck = ck;
+        i = 0;
+        while (i < nlocs) {
+            int n = min(nspec, nlocs - i);
+
+            rctx.locs = locs + i;
+            parallel_run(n, try_removal, &rctx);
+
+            for (j = 0; j < n; j++) {
+                int k;
+
+                ncoords = symmetries(params, locs[i+j].x, locs[i+j].y,
+                                     coords, params->symm);
+                if (rctx.ok[j]) {
+                    for (k = 0; k < ncoords; k++)
+                        grid[coords[2*k+1]*cr+coords[2*k]] = 0;
+                    j++;
+                    break;
+                }
+                for (k = 0; k < ncoords; k++) {
+                    x = coords[2*k];
+                    y = coords[2*k+1];
+                    solver_checkpoint_place(ck, x, y, grid[y*cr+x]);
+                }
             }
+            i += j;
         }
+        solver_checkpoint_free(ck);
 
         memcpy(grid2, grid, area);
 
-	solver(cr, blocks, kblocks, params->xtype, grid2, kgrid, &dlev);
+	solver(cr, blocks, kblocks, params->xtype, grid2, kgrid, &dlev, ar,
+               NULL);
+        genstat_count(GENSTAT_SOLVER_CALLS);
 	if (dlev.diff == dlev.maxdiff &&
 	    (!params->killer || dlev.kdiff == dlev.maxkdiff))
 	    break;		       /* found one! */
+        count_rejection(&dlev, params->killer);
     }
 
     sfree(grid2);
     sfree(locs);
+    for (i = 1; i < nspec; i++)
+        arena_free(rctx.arenas[i]);
+    sfree(rctx.arenas);
+    sfree(rctx.grids);
+    sfree(rctx.ok);
+    arena_free(ar);
 
     /*
      * Now we have the grid as it will be presented to the user.
@@ -4131,8 +4472,6 @@ static game_state *new_game(midend *me, const game_params *params,
     int c = params->c, r = params->r, cr = c*r, area = cr * cr;
     int i;
 
-    precompute_sum_bits();
-
     state->cr = cr;
     state->xtype = params->xtype;
     state->killer = params->killer;
@@ -4284,6 +4623,7 @@ static char *solve_game(const game_state *state, const game_state *currstate,
     char *ret;
     digit *grid;
     struct difficulty dlev;
+    arena *ar;
 
     /*
      * If we already have the solution in ai, save ourselves some
@@ -4296,8 +4636,11 @@ static char *solve_game(const game_state *state, const game_state *currstate,
     memcpy(grid, state->grid, cr*cr);
     dlev.maxdiff = DIFF_RECURSIVE;
     dlev.maxkdiff = DIFF_KINTERSECT;
+    dlev.exact_cover = true;
+    ar = arena_new();
     solver(cr, state->blocks, state->kblocks, state->xtype, grid,
-	   state->kgrid, &dlev);
+	   state->kgrid, &dlev, ar, NULL);
+    arena_free(ar);
 
     *error = NULL;
 
@@ -5643,8 +5986,9 @@ int main(int argc, char **argv)
     game_state *s;
     char *id = NULL, *desc;
     const char *err;
-    bool grade = false;
+    bool grade = false, recurse = false;
     struct difficulty dlev;
+    arena *ar;
 
     while (--argc > 0) {
         char *p = *++argv;
@@ -5652,6 +5996,8 @@ int main(int argc, char **argv)
             solver_show_working = true;
         } else if (!strcmp(p, "-g")) {
             grade = true;
+        } else if (!strcmp(p, "-r")) {
+            recurse = true;
         } else if (*p == '-') {
             fprintf(stderr, "%s: unrecognised option `%s'\n", argv[0], p);
             return 1;
@@ -5661,7 +6007,7 @@ int main(int argc, char **argv)
     }
 
     if (!id) {
-        fprintf(stderr, "usage: %s [-g | -v] <game_id>\n", argv[0]);
+        fprintf(stderr, "usage: %s [-g | -v] [-r] <game_id>\n", argv[0]);
         return 1;
     }
 
@@ -5683,7 +6029,11 @@ int main(int argc, char **argv)
 
     dlev.maxdiff = DIFF_RECURSIVE;
     dlev.maxkdiff = DIFF_KINTERSECT;
-    solver(s->cr, s->blocks, s->kblocks, s->xtype, s->grid, s->kgrid, &dlev);
+    dlev.exact_cover = !recurse;
+    ar = arena_new();
+    solver(s->cr, s->blocks, s->kblocks, s->xtype, s->grid, s->kgrid, &dlev,
+           ar, NULL);
+    arena_free(ar);
     if (grade) {
 	printf("Difficulty rating: %s\n",
 	       dlev.diff==DIFF_BLOCK ? "Trivial (blockwise positional elimination only)":
@@ -1,7 +1,21 @@
 /*
  * Implement arraysort() defined in puzzles.h.
  *
- * Strategy: heapsort.
+ * Strategy: introsort. That is, quicksort with a median-of-three (or,
+ * for large arrays, median-of-nine) pivot, handing small subarrays
+ * over to insertion sort and falling back to heapsort if too many
+ * partitions come out lopsided, so that the worst case is still
+ * O(n log n). As in pdqsort, a lopsided partition also makes us
+ * shuffle a few elements, to stop patterns in the input from
+ * fooling the pivot selection over and over; and a pivot equal to
+ * the element just before the subarray means we can set aside
+ * everything equal to it in one linear pass, so that runs of equal
+ * elements cost nothing like n log n comparisons.
+ *
+ * Since the comparison function is called through a pointer and may
+ * well do a lot of work of its own, most of the effort here goes on
+ * making fewer calls to it; the rest goes on moving elements of the
+ * common small sizes without a call to memcpy per move.
  */
 
 #include <stddef.h>
@@ -9,21 +23,46 @@
 
 #include "puzzles.h"
 
-static void memswap(void *av, void *bv, size_t size)
+/* Subarrays this short are left to insertion sort. */
+#define INSERTION_THRESHOLD 16
+
+/* Above this size, the pivot is chosen by median-of-nine. */
+#define NINTHER_THRESHOLD 128
+
+/*
+ * Swap two elements. Fixed-size memcpy calls compile to plain loads
+ * and stores, so elements of the usual sizes get swapped inline
+ * regardless of their alignment.
+ */
+#define SWAP_AS(type) do {                      \
+        type t_;                                \
+        memcpy(&t_, a, sizeof(type));           \
+        memcpy(a, b, sizeof(type));             \
+        memcpy(b, &t_, sizeof(type));           \
+    } while (0)
+
+static inline void memswap(void *av, void *bv, size_t size)
 {
-    char t[4096];
     char *a = (char *)av, *b = (char *)bv;
 
-    while (size > 0) {
-        size_t thissize = size < sizeof(t) ? size : sizeof(t);
+    if (size == sizeof(int)) {
+        SWAP_AS(int);
+    } else if (size == sizeof(void *)) {
+        SWAP_AS(void *);
+    } else {
+        char t[64];
 
-        memcpy(t, a, thissize);
-        memcpy(a, b, thissize);
-        memcpy(b, t, thissize);
+        while (size > 0) {
+            size_t thissize = size < sizeof(t) ? size : sizeof(t);
 
-        size -= thissize;
-        a += thissize;
-        b += thissize;
+            memcpy(t, a, thissize);
+            memcpy(a, b, thissize);
+            memcpy(b, t, thissize);
+
+            size -= thissize;
+            a += thissize;
+            b += thissize;
+        }
     }
 }
 
@@ -55,8 +94,8 @@ static void downheap(void *array, size_t nmemb, size_t size,
     }
 }
 
-void arraysort_fn(void *array, size_t nmemb, size_t size,
-                  arraysort_cmpfn_t cmp, void *ctx)
+static void arraysort_heapsort(void *array, size_t nmemb, size_t size,
+                               arraysort_cmpfn_t cmp, void *ctx)
 {
     size_t i;
 
@@ -88,6 +127,261 @@ void arraysort_fn(void *array, size_t nmemb, size_t size,
     }
 }
 
+/*
+ * Binary insertion sort. Each element costs about log2 of the sorted
+ * prefix's length in comparisons, instead of up to the length itself,
+ * and an element already in order costs just the one.
+ */
+static void insertion_sort(void *array, size_t nmemb, size_t size,
+                           arraysort_cmpfn_t cmp, void *ctx)
+{
+    char tmp[64];
+    size_t i;
+
+    for (i = 1; i < nmemb; i++) {
+        size_t lo = 0, hi = i - 1;
+
+        if (CMP(i-1, i) <= 0)
+            continue;                  /* already in place */
+
+        /* Find the first element of the prefix greater than this one. */
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (CMP(mid, i) <= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if (size <= sizeof(tmp)) {
+            memcpy(tmp, PTR(i), size);
+            memmove(PTR(lo+1), PTR(lo), (i - lo) * size);
+            memcpy(PTR(lo), tmp, size);
+        } else {
+            size_t j;
+            for (j = i; j > lo; j--)
+                SWAP(j, j-1);
+        }
+    }
+}
+
+/*
+ * Insertion sort that gives up, returning false, once it has had to
+ * move more than a few elements; so it sorts a nearly sorted array
+ * in linear time but doesn't waste much on anything else.
+ */
+#define PARTIAL_INSERTION_LIMIT 8
+static bool partial_insertion_sort(void *array, size_t nmemb, size_t size,
+                                   arraysort_cmpfn_t cmp, void *ctx)
+{
+    size_t i, j, moved = 0;
+
+    for (i = 1; i < nmemb; i++) {
+        for (j = i; j > 0 && CMP(j-1, j) > 0; j--)
+            SWAP(j-1, j);
+        moved += i - j;
+        if (moved > PARTIAL_INSERTION_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+/* Return whichever of the elements i, j, k is the median. */
+static size_t median3(void *array, size_t size, arraysort_cmpfn_t cmp,
+                      void *ctx, size_t i, size_t j, size_t k)
+{
+    if (CMP(i, j) < 0) {
+        if (CMP(j, k) < 0)
+            return j;
+        return CMP(i, k) < 0 ? k : i;
+    } else {
+        if (CMP(i, k) < 0)
+            return i;
+        return CMP(j, k) < 0 ? k : j;
+    }
+}
+
+/*
+ * After a badly unbalanced partition, swap a few elements of a
+ * subarray around, on the assumption that some regularity in the
+ * input is defeating the pivot choice and will keep doing so if left
+ * alone. (Descending runs are the usual culprit: the rotation of the
+ * pivot to the front leaves each side in an order that makes
+ * median-of-three pick a near-extreme element next time.)
+ */
+static void break_patterns(void *array, size_t nmemb, size_t size)
+{
+    if (nmemb > INSERTION_THRESHOLD) {
+        size_t q = nmemb / 4;
+        SWAP(0, q);
+        SWAP(nmemb - 1, nmemb - q);
+        if (nmemb > NINTHER_THRESHOLD) {
+            SWAP(1, q + 1);
+            SWAP(2, q + 2);
+            SWAP(nmemb - 2, nmemb - q + 1);
+            SWAP(nmemb - 3, nmemb - q + 2);
+        }
+    }
+}
+
+/*
+ * Partition a subarray with its pivot at index 0, when the element
+ * just before the subarray is known to be equal to the pivot, so
+ * that nothing in the subarray is less than it. Elements equal to
+ * the pivot go to the left and anything greater to the right, and
+ * the return value is the pivot's final index; everything up to it
+ * is then equal to the pivot, and already in its final place.
+ */
+static size_t partition_equal(void *array, size_t nmemb, size_t size,
+                              arraysort_cmpfn_t cmp, void *ctx)
+{
+    size_t i = 0, j = nmemb;
+
+    /* The pivot itself stops this scan. */
+    do j--; while (CMP(0, j) < 0);
+
+    /*
+     * If anything was greater than the pivot, the element after j
+     * is, and will stop the upward scan; otherwise we have to watch
+     * for j ourselves.
+     */
+    if (j + 1 == nmemb) {
+        while (i < j && CMP(0, ++i) >= 0);
+    } else {
+        while (CMP(0, ++i) >= 0);
+    }
+
+    while (i < j) {
+        SWAP(i, j);
+        do j--; while (CMP(0, j) < 0);
+        do i++; while (CMP(0, i) >= 0);
+    }
+
+    if (j != 0)
+        SWAP(0, j);
+    return j;
+}
+
+/*
+ * 'badness' is the number of badly unbalanced partitions we're
+ * still prepared to put up with before concluding that quicksort
+ * isn't going to work on this input and switching to heapsort.
+ * 'leftmost' is false if the array is preceded by an element (the
+ * pivot of an earlier partition) which is no greater than anything
+ * in it.
+ */
+static void introsort(void *array, size_t nmemb, size_t size,
+                      arraysort_cmpfn_t cmp, void *ctx, int badness,
+                      bool leftmost)
+{
+    while (nmemb > INSERTION_THRESHOLD) {
+        size_t i, j, pivot, mid = nmemb / 2, last = nmemb - 1;
+        bool swapped;
+
+        if (nmemb > NINTHER_THRESHOLD) {
+            size_t step = nmemb / 8;
+            pivot = median3(
+                array, size, cmp, ctx,
+                median3(array, size, cmp, ctx, 0, step, 2*step),
+                median3(array, size, cmp, ctx, mid-step, mid, mid+step),
+                median3(array, size, cmp, ctx, last-2*step, last-step, last));
+        } else {
+            pivot = median3(array, size, cmp, ctx, 0, mid, last);
+        }
+        if (pivot != 0)
+            SWAP(0, pivot);
+
+        /*
+         * If the pivot is no greater than the element before us, it
+         * must be equal to it, and the smallest thing here. So set
+         * aside everything equal to it, and sort only the rest.
+         */
+        if (!leftmost && cmp((char *)array - size, PTR(0), ctx) >= 0) {
+            j = partition_equal(array, nmemb, size, cmp, ctx);
+            array = PTR(j + 1);
+            nmemb -= j + 1;
+            continue;
+        }
+
+        /*
+         * Partition around the pivot, now at index 0. Both scans stop
+         * at elements equal to the pivot, which keeps the partition
+         * balanced when there are many duplicates; the downward scan
+         * can't run off the start because the pivot itself stops it.
+         */
+        i = 0;
+        j = nmemb;
+        swapped = false;
+        while (1) {
+            do i++; while (i < nmemb && CMP(i, 0) < 0);
+            do j--; while (CMP(0, j) < 0);
+            if (i >= j)
+                break;
+            SWAP(i, j);
+            swapped = true;
+        }
+        if (j != 0)
+            SWAP(0, j);
+
+        /*
+         * Now [0,j) are no greater than the pivot at j, and (j,nmemb)
+         * no less.
+         */
+        if (j < nmemb / 8 || nmemb - 1 - j < nmemb / 8) {
+            if (badness-- == 0) {
+                arraysort_heapsort(array, j, size, cmp, ctx);
+                arraysort_heapsort(PTR(j + 1), nmemb - 1 - j, size, cmp, ctx);
+                return;
+            }
+            break_patterns(array, j, size);
+            break_patterns(PTR(j + 1), nmemb - 1 - j, size);
+        } else if (!swapped &&
+                   partial_insertion_sort(array, j, size, cmp, ctx) &&
+                   partial_insertion_sort(PTR(j + 1), nmemb - 1 - j,
+                                          size, cmp, ctx)) {
+            /*
+             * The array was already partitioned, which suggests it
+             * might have been sorted already, and so it proved.
+             */
+            return;
+        }
+
+        /*
+         * Recurse into the smaller side and loop round for the
+         * larger, so that the stack depth stays logarithmic.
+         */
+        if (j < nmemb - 1 - j) {
+            introsort(array, j, size, cmp, ctx, badness, leftmost);
+            array = PTR(j + 1);
+            nmemb -= j + 1;
+            leftmost = false;
+        } else {
+            introsort(PTR(j + 1), nmemb - 1 - j, size, cmp, ctx, badness,
+                      false);
+            nmemb = j;
+        }
+    }
+
+    insertion_sort(array, nmemb, size, cmp, ctx);
+}
+
+void arraysort_fn(void *array, size_t nmemb, size_t size,
+                  arraysort_cmpfn_t cmp, void *ctx)
+{
+    int badness = 0;
+    size_t n;
+
+    /*
+     * Each bad partition still removes at least an eighth of the
+     * elements, so allowing log2(n) of them keeps the total work
+     * O(n log n) whatever happens.
+     */
+    for (n = nmemb; n > 1; n >>= 1)
+        badness++;
+
+    introsort(array, nmemb, size, cmp, ctx, badness, true);
+}
+
 #ifdef SORT_TEST
 
 #include <stdlib.h>
@@ -106,6 +400,103 @@ int resetcmp(const void *av, const void *bv)
     return a < b ? -1 : a > b ? +1 : 0;
 }
 
+/*
+ * Fill in keys in one of several patterns that tend to show up the
+ * weaknesses of quicksort variants.
+ */
+enum { RANDOM, FEW_DISTINCT, ASCENDING, DESCENDING, ORGAN_PIPE, ALL_EQUAL,
+       NPATTERNS };
+static const char *const pattern_names[] = {
+    "random", "few distinct", "ascending", "descending", "organ pipe",
+    "all equal",
+};
+
+static void make_keys(int *keys, int n, int pattern)
+{
+    int j;
+
+    for (j = 0; j < n; j++) {
+        switch (pattern) {
+          case RANDOM: keys[j] = rand(); break;
+          case FEW_DISTINCT: keys[j] = rand() % 4; break;
+          case ASCENDING: keys[j] = j; break;
+          case DESCENDING: keys[j] = n - j; break;
+          case ORGAN_PIPE: keys[j] = j < n/2 ? j : n - j; break;
+          default: keys[j] = 0; break;
+        }
+    }
+}
+
+/*
+ * Elements of arbitrary size for exercising the different ways of
+ * moving them: a key, the element's original index, and filler bytes
+ * derived from the index so we can tell if anything got mangled.
+ */
+static int elemcmp(const void *av, const void *bv, void *ctx)
+{
+    int a, b;
+    memcpy(&a, av, sizeof(int));
+    memcpy(&b, bv, sizeof(int));
+    return a < b ? -1 : a > b ? +1 : 0;
+}
+
+static const char *check_elements(const int *keys, int n, size_t size)
+{
+    char *array = snewn(n * size, char), *e;
+    bool *seen = snewn(n, bool);
+    const char *fail = NULL;
+    int j, prevkey = 0;
+    size_t k;
+
+    for (j = 0; j < n; j++) {
+        e = array + j * size;
+        memcpy(e, &keys[j], sizeof(int));
+        memcpy(e + sizeof(int), &j, sizeof(int));
+        for (k = 2 * sizeof(int); k < size; k++)
+            e[k] = (char)(j + k);
+        seen[j] = false;
+    }
+
+    arraysort_fn(array, n, size, elemcmp, NULL);
+
+    for (j = 0; j < n && !fail; j++) {
+        int key, index;
+        e = array + j * size;
+        memcpy(&key, e, sizeof(int));
+        memcpy(&index, e + sizeof(int), sizeof(int));
+        if (j > 0 && key < prevkey)
+            fail = "output misordered";
+        else if (index < 0 || index >= n || seen[index] ||
+                 keys[index] != key)
+            fail = "output not permuted";
+        else
+            for (k = 2 * sizeof(int); k < size; k++)
+                if (e[k] != (char)(index + k))
+                    fail = "element corrupted";
+        if (!fail)
+            seen[index] = true;
+        prevkey = key;
+    }
+
+    sfree(array);
+    sfree(seen);
+    return fail;
+}
+
+struct countctx {
+    const int *keys;
+    long ncmps;
+};
+
+static int countcmp(const void *av, const void *bv, void *vctx)
+{
+    struct countctx *ctx = (struct countctx *)vctx;
+    int a = *(const int *)av, b = *(const int *)bv;
+    ctx->ncmps++;
+    return (ctx->keys[a] < ctx->keys[b] ? -1 :
+            ctx->keys[a] > ctx->keys[b] ? +1 : 0);
+}
+
 int main(int argc, char **argv)
 {
     typedef int Array[3723];
@@ -153,6 +544,71 @@ int main(int argc, char **argv)
         }
     }
 
+    /*
+     * Every pattern at a range of sizes, including all the small ones
+     * handled entirely by insertion sort, with elements of several
+     * sizes so that every way of moving them gets used.
+     */
+    for (iteration = 0; iteration < 3000; iteration++) {
+        static const size_t sizes[] = { 2*sizeof(int), 3*sizeof(int), 100 };
+        int n = (iteration < 600 ? iteration / 6 : 1 + rand() % 3000);
+        int pattern = iteration % NPATTERNS;
+        size_t size = sizes[(iteration / NPATTERNS) % lenof(sizes)];
+        int *ekeys = snewn(n + 1, int);
+        const char *fail;
+
+        make_keys(ekeys, n, pattern);
+        fail = check_elements(ekeys, n, size);
+        sfree(ekeys);
+        if (fail) {
+            printf("Failed at iteration %d (%d elements of size %d, %s): "
+                   "%s\n", iteration, n, (int)size, pattern_names[pattern],
+                   fail);
+            return 1;
+        }
+    }
+
+    /*
+     * Timings against the plain heapsort this replaced, sorting a
+     * million indices by the keys they refer to.
+     */
+    {
+        int n = 1 << 20, pattern, pass, j;
+        int *bkeys = snewn(n, int), *bdata = snewn(n, int);
+
+        printf("%-14s %24s %24s\n", "", "arraysort", "heapsort");
+        for (pattern = 0; pattern < NPATTERNS; pattern++) {
+            printf("%-14s", pattern_names[pattern]);
+            make_keys(bkeys, n, pattern);
+            for (pass = 0; pass < 2; pass++) {
+                struct countctx ctx;
+                clock_t start;
+
+                for (j = 0; j < n; j++)
+                    bdata[j] = j;
+                ctx.keys = bkeys;
+                ctx.ncmps = 0;
+                start = clock();
+                if (pass == 0)
+                    arraysort(bdata, n, countcmp, &ctx);
+                else
+                    arraysort_heapsort(bdata, n, sizeof(*bdata),
+                                       countcmp, &ctx);
+                printf(" %8.3f s %10ld cmps",
+                       (double)(clock() - start) / CLOCKS_PER_SEC,
+                       ctx.ncmps);
+                for (j = 1; j < n; j++)
+                    if (bkeys[bdata[j]] < bkeys[bdata[j-1]]) {
+                        printf("\nTiming run misordered\n");
+                        return 1;
+                    }
+            }
+            printf("\n");
+        }
+        sfree(bkeys);
+        sfree(bdata);
+    }
+
     printf("OK\n");
     return 0;
 }
@@ -1,9 +1,11 @@
 /*
  * tdq.c: implement a 'to-do queue', a simple de-duplicating to-do
- * list mechanism.
+ * list mechanism, and the 'worklist', a prioritised version of the
+ * same idea.
  */
 
 #include <assert.h>
+#include <limits.h>
 
 #include "puzzles.h"
 
@@ -86,3 +88,335 @@ void tdq_fill(tdq *tdq)
     for (i = 0; i < tdq->n; i++)
         tdq_add(tdq, i);
 }
+
+/*
+ * A worklist keeps one doubly linked list per priority level, threaded
+ * through next[] and prev[] arrays indexed by element, so that adding
+ * at either end, moving an element to a more urgent level and removing
+ * from the front are all constant time. Which elements are present is
+ * recorded in a bitset; an element's level is only meaningful while
+ * it's present.
+ */
+
+#define WL_WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+#define WL_PRESENT(wl, k) \
+    (((wl)->present[(k) / WL_WORD_BITS] >> ((k) % WL_WORD_BITS)) & 1)
+
+struct worklist {
+    int n, nlevels;
+    int *next, *prev;                  /* -1 terminates each list */
+    int *head, *tail;                  /* per level */
+    unsigned char *level;
+    unsigned long *present;
+    int count;
+};
+
+worklist *worklist_new(int n, int nlevels)
+{
+    worklist *wl = snew(worklist);
+    int i, nwords = (n + WL_WORD_BITS - 1) / WL_WORD_BITS;
+
+    assert(nlevels > 0 && nlevels <= 256);
+    wl->n = n;
+    wl->nlevels = nlevels;
+    wl->next = snewn(n, int);
+    wl->prev = snewn(n, int);
+    wl->level = snewn(n, unsigned char);
+    wl->head = snewn(nlevels, int);
+    wl->tail = snewn(nlevels, int);
+    wl->present = snewn(nwords + 1, unsigned long);
+    for (i = 0; i < nlevels; i++)
+        wl->head[i] = wl->tail[i] = -1;
+    for (i = 0; i < nwords; i++)
+        wl->present[i] = 0;
+    wl->count = 0;
+    return wl;
+}
+
+void worklist_free(worklist *wl)
+{
+    sfree(wl->next);
+    sfree(wl->prev);
+    sfree(wl->level);
+    sfree(wl->head);
+    sfree(wl->tail);
+    sfree(wl->present);
+    sfree(wl);
+}
+
+static void worklist_unlink(worklist *wl, int k)
+{
+    int lv = wl->level[k];
+
+    if (wl->prev[k] >= 0)
+        wl->next[wl->prev[k]] = wl->next[k];
+    else
+        wl->head[lv] = wl->next[k];
+    if (wl->next[k] >= 0)
+        wl->prev[wl->next[k]] = wl->prev[k];
+    else
+        wl->tail[lv] = wl->prev[k];
+
+    wl->present[k / WL_WORD_BITS] &= ~(1UL << (k % WL_WORD_BITS));
+    wl->count--;
+}
+
+/*
+ * Common code for worklist_add and worklist_push. Returns false if
+ * the element was already present at the same or a more urgent level,
+ * in which case nothing needs doing.
+ */
+static bool worklist_prepare(worklist *wl, int k, int level)
+{
+    assert((unsigned)k < (unsigned)wl->n);
+    assert((unsigned)level < (unsigned)wl->nlevels);
+
+    if (WL_PRESENT(wl, k)) {
+        if (wl->level[k] <= level)
+            return false;
+        worklist_unlink(wl, k);
+    }
+
+    wl->present[k / WL_WORD_BITS] |= 1UL << (k % WL_WORD_BITS);
+    wl->level[k] = level;
+    wl->count++;
+    return true;
+}
+
+void worklist_add(worklist *wl, int k, int level)
+{
+    if (!worklist_prepare(wl, k, level))
+        return;
+
+    wl->next[k] = -1;
+    wl->prev[k] = wl->tail[level];
+    if (wl->tail[level] >= 0)
+        wl->next[wl->tail[level]] = k;
+    else
+        wl->head[level] = k;
+    wl->tail[level] = k;
+}
+
+void worklist_push(worklist *wl, int k, int level)
+{
+    if (!worklist_prepare(wl, k, level))
+        return;
+
+    wl->prev[k] = -1;
+    wl->next[k] = wl->head[level];
+    if (wl->head[level] >= 0)
+        wl->prev[wl->head[level]] = k;
+    else
+        wl->tail[level] = k;
+    wl->head[level] = k;
+}
+
+bool worklist_contains(const worklist *wl, int k)
+{
+    assert((unsigned)k < (unsigned)wl->n);
+    return WL_PRESENT(wl, k);
+}
+
+int worklist_count(const worklist *wl)
+{
+    return wl->count;
+}
+
+int worklist_remove(worklist *wl, int maxlevel, int *level)
+{
+    int lv, k;
+
+    for (lv = 0; lv <= maxlevel && lv < wl->nlevels; lv++) {
+        if ((k = wl->head[lv]) >= 0) {
+            worklist_unlink(wl, k);
+            if (level)
+                *level = lv;
+            return k;
+        }
+    }
+    return -1;
+}
+
+int worklist_remove_batch(worklist *wl, int maxlevel, int *out, int max,
+                          int *level)
+{
+    int lv, k, n = 0;
+
+    for (lv = 0; lv <= maxlevel && lv < wl->nlevels; lv++) {
+        if (wl->head[lv] < 0)
+            continue;
+        while (n < max && (k = wl->head[lv]) >= 0) {
+            worklist_unlink(wl, k);
+            out[n++] = k;
+        }
+        if (level)
+            *level = lv;
+        break;
+    }
+    return n;
+}
+
+void worklist_fill(worklist *wl, int level)
+{
+    int i;
+    for (i = 0; i < wl->n; i++)
+        worklist_add(wl, i, level);
+}
+
+#ifdef TDQ_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Check a worklist against a naive model: for each level, an array of
+ * the elements in order.
+ */
+#define N 50
+#define LEVELS 4
+
+static int model[LEVELS][N], modellen[LEVELS];
+
+static int model_find(int k, int *level)
+{
+    int lv, i;
+    for (lv = 0; lv < LEVELS; lv++)
+        for (i = 0; i < modellen[lv]; i++)
+            if (model[lv][i] == k) {
+                *level = lv;
+                return i;
+            }
+    return -1;
+}
+
+static void model_delete(int lv, int i)
+{
+    memmove(model[lv] + i, model[lv] + i + 1,
+            (modellen[lv] - i - 1) * sizeof(int));
+    modellen[lv]--;
+}
+
+static void model_insert(int k, int level, bool front)
+{
+    int lv, i = model_find(k, &lv);
+
+    if (i >= 0) {
+        if (lv <= level)
+            return;
+        model_delete(lv, i);
+    }
+    if (front) {
+        memmove(model[level] + 1, model[level], modellen[level] * sizeof(int));
+        model[level][0] = k;
+    } else {
+        model[level][modellen[level]] = k;
+    }
+    modellen[level]++;
+}
+
+static int model_remove(int maxlevel, int *level)
+{
+    int lv, k;
+    for (lv = 0; lv <= maxlevel && lv < LEVELS; lv++)
+        if (modellen[lv]) {
+            k = model[lv][0];
+            model_delete(lv, 0);
+            *level = lv;
+            return k;
+        }
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed;
+    worklist *wl;
+    tdq *tdq;
+    int iteration, i, count;
+
+    seed = (argc > 1 ? strtoul(argv[1], NULL, 0) : time(NULL));
+    printf("Random seed = %u\n", seed);
+    srand(seed);
+
+    wl = worklist_new(N, LEVELS);
+    for (iteration = 0; iteration < 1000000; iteration++) {
+        int op = rand() % 10, k = rand() % N, lv = rand() % LEVELS;
+        int got, expected, glv, elv;
+
+        if (op < 3) {
+            worklist_add(wl, k, lv);
+            model_insert(k, lv, false);
+        } else if (op < 5) {
+            worklist_push(wl, k, lv);
+            model_insert(k, lv, true);
+        } else if (op < 8) {
+            got = worklist_remove(wl, lv, &glv);
+            expected = model_remove(lv, &elv);
+            if (got != expected || (got >= 0 && glv != elv)) {
+                printf("Iteration %d: removed %d at level %d, "
+                       "expected %d at level %d\n",
+                       iteration, got, glv, expected, elv);
+                return 1;
+            }
+        } else if (op < 9) {
+            int out[N], n, max = 1 + rand() % 8;
+            n = worklist_remove_batch(wl, lv, out, max, &glv);
+            for (i = 0; i < n; i++) {
+                expected = model_remove(lv, &elv);
+                if (out[i] != expected || glv != elv) {
+                    printf("Iteration %d: batch element %d was %d at "
+                           "level %d, expected %d at level %d\n",
+                           iteration, i, out[i], glv, expected, elv);
+                    return 1;
+                }
+            }
+            /* A short batch must have emptied its level. */
+            if (n > 0 && n < max && modellen[glv]) {
+                printf("Iteration %d: batch stopped early\n", iteration);
+                return 1;
+            }
+            if (n == 0 && model_remove(lv, &elv) >= 0) {
+                printf("Iteration %d: batch was empty\n", iteration);
+                return 1;
+            }
+        } else {
+            if (worklist_contains(wl, k) != (model_find(k, &elv) >= 0)) {
+                printf("Iteration %d: membership of %d wrong\n",
+                       iteration, k);
+                return 1;
+            }
+        }
+
+        for (count = lv = 0; lv < LEVELS; lv++)
+            count += modellen[lv];
+        if (worklist_count(wl) != count) {
+            printf("Iteration %d: count %d, expected %d\n",
+                   iteration, worklist_count(wl), count);
+            return 1;
+        }
+    }
+    worklist_free(wl);
+
+    /* With one level, a worklist should behave exactly like a tdq. */
+    wl = worklist_new(N, 1);
+    tdq = tdq_new(N);
+    for (iteration = 0; iteration < 100000; iteration++) {
+        int k = rand() % N;
+        if (rand() % 2) {
+            worklist_add(wl, k, 0);
+            tdq_add(tdq, k);
+        } else if (worklist_remove(wl, 0, NULL) != tdq_remove(tdq)) {
+            printf("Iteration %d: differs from tdq\n", iteration);
+            return 1;
+        }
+    }
+    worklist_free(wl);
+    tdq_free(tdq);
+
+    printf("OK\n");
+    return 0;
+}
+
+#endif /* TDQ_TEST */
@@ -916,6 +916,9 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
     int **adjlists = snewn(ntrees, int *);
     int *adjsizes = snewn(ntrees, int);
     int *outr = snewn(4*ntrees, int);
+    /* Big enough for any number of potential tree squares we can get,
+     * so that we needn't reallocate it on every attempt. */
+    void *mscratch = smalloc(matching_scratch_size(ntrees, 4*ntrees));
     struct solver_scratch *sc = new_scratch(w, h);
     char *ret, *p;
     int i, j, nl, nr;
@@ -972,6 +975,8 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
 	params->diff = DIFF_EASY;      /* downgrade to prevent tight loop */
 
     while (1) {
+        genstat_count(GENSTAT_ATTEMPTS);
+
 	/*
 	 * Make a list of grid squares which we'll permute as we pick
 	 * the tent locations.
@@ -1025,8 +1030,10 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
 		j--;
 	    }
 	}
-	if (j > 0)
+	if (j > 0) {
+	    genstat_count(GENSTAT_REJECT_OTHER);
 	    continue;		       /* couldn't place all the tents */
+	}
 
 	/*
 	 * Build up the graph for matching.c.
@@ -1052,10 +1059,13 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
 	/*
 	 * Call the matching algorithm to actually place the trees.
 	 */
-	j = matching(ntrees, nr, adjlists, adjsizes, rs, NULL, outr);
+	j = matching_with_scratch(mscratch, ntrees, nr, adjlists, adjsizes,
+                                  rs, NULL, outr);
 
-	if (j < ntrees)
+	if (j < ntrees) {
+	    genstat_count(GENSTAT_REJECT_OTHER);
 	    continue;		       /* couldn't place all the trees */
+	}
 
 	/*
 	 * Fill in the trees in the grid, by cross-referencing treemap
@@ -1086,8 +1096,10 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
 	    if (j == h)
 		break;		       /* found empty column */
 	}
-	if (i < w)
+	if (i < w) {
+	    genstat_count(GENSTAT_REJECT_OTHER);
 	    continue;		       /* a column was empty */
+	}
 
 	for (j = 0; j < h; j++) {
 	    for (i = 0; i < w; i++) {
@@ -1097,8 +1109,10 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
 	    if (i == w)
 		break;		       /* found empty row */
 	}
-	if (j < h)
+	if (j < h) {
+	    genstat_count(GENSTAT_REJECT_OTHER);
 	    continue;		       /* a row was empty */
+	}
 
 	/*
 	 * Now set up the numbers round the edge.
@@ -1126,6 +1140,7 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
             puzzle[i] = grid[i] == TREE ? TREE : BLANK;
 	i = tents_solve(w, h, puzzle, numbers, soln, sc, params->diff-1);
 	j = tents_solve(w, h, puzzle, numbers, soln, sc, params->diff);
+        genstat_add(GENSTAT_SOLVER_CALLS, 2);
 
         /*
          * We expect solving with difficulty params->diff to have
@@ -1135,6 +1150,13 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
          */
 	if (i == 2 && j == 1)
 	    break;
+
+        /*
+         * This solver can't tell an ambiguous puzzle from one that's
+         * too hard for it, so both count as the latter.
+         */
+        genstat_count(j != 1 ? GENSTAT_REJECT_TOO_HARD :
+                      GENSTAT_REJECT_TOO_EASY);
     }
 
     /*
@@ -1174,6 +1196,7 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
     *aux = sresize(*aux, p - *aux, char);
 
     free_scratch(sc);
+    sfree(mscratch);
     sfree(outr);
     sfree(adjdata);
     sfree(adjlists);
@@ -0,0 +1,303 @@
+/*
+ * threadtest.c: stress test checking that the game back ends (and the
+ * midend and common code underneath them) can be used from several
+ * threads at once, as batchgen.c's --jobs mode and any long-running
+ * generation service need.
+ *
+ * Every back end is supposed to be reentrant: nothing it does may
+ * depend on, or modify, writable static storage. This program checks
+ * that in the only way a test can, by doing a lot of work on many
+ * threads at once and seeing whether anything comes out different.
+ * It first generates a set of games serially, recording the game
+ * description each random seed produced, and then has several threads
+ * generate the same set concurrently (each starting at a different
+ * point in the list, so that different back ends and different
+ * parameters are mixed together), checking every description against
+ * the serial one and solving each game where the back end can.
+ *
+ * A clean run doesn't prove the absence of races, but a build with
+ * -fsanitize=thread will report any that this workload exercises.
+ *
+ * Usage:
+ *
+ *   threadtest [--threads <n>] [--presets <n>] [--seeds <n>] [puzzle...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "puzzles.h"
+#include "grid.h"
+
+/* ----------------------------------------------------------------------
+ * The test itself.
+ */
+
+struct job {
+    const game *game;
+    char *id;                          /* random-seed game id */
+    char *desc;                        /* what it generated serially */
+};
+
+struct stress {
+    struct job *jobs;
+    int njobs, jobsize;
+    int nthreads;
+
+    pthread_mutex_t lock;              /* protects nerrors and stderr */
+    int nerrors;
+};
+
+struct worker {
+    struct stress *st;
+    int index;
+};
+
+static void add_job(struct stress *st, const game *game, char *id)
+{
+    if (st->njobs >= st->jobsize) {
+        st->jobsize = st->njobs * 5 / 4 + 64;
+        st->jobs = sresize(st->jobs, st->jobsize, struct job);
+    }
+    st->jobs[st->njobs].game = game;
+    st->jobs[st->njobs].id = id;
+    st->jobs[st->njobs].desc = NULL;
+    st->njobs++;
+}
+
+static void add_presets(struct stress *st, const game *game,
+                        struct preset_menu *menu, int *npresets,
+                        int maxpresets, int nseeds)
+{
+    int i, j;
+
+    for (i = 0; i < menu->n_entries && *npresets < maxpresets; i++) {
+        if (menu->entries[i].params) {
+            char *paramstr = game->encode_params(
+                menu->entries[i].params, true);
+
+            for (j = 0; j < nseeds; j++) {
+                /*
+                 * Alternate between seeds for the fast and SHA-1
+                 * random number generators, so both get exercised.
+                 */
+                char *id = snewn(strlen(paramstr) + 40, char);
+                sprintf(id, "%s%s#threadtest%d", paramstr,
+                        j % 2 ? "" : "~", j);
+                add_job(st, game, id);
+            }
+            sfree(paramstr);
+            (*npresets)++;
+        } else {
+            add_presets(st, game, menu->entries[i].submenu, npresets,
+                        maxpresets, nseeds);
+        }
+    }
+}
+
+/*
+ * Generate the game for one job in the given midend, and solve it if
+ * the back end supports that. Returns the descriptive game id, or
+ * NULL with *err filled in.
+ */
+static char *run_job(midend *me, const struct job *job, const char **err)
+{
+    char *desc;
+
+    *err = midend_game_id(me, job->id);
+    if (*err)
+        return NULL;
+    midend_new_game(me);
+    desc = midend_get_game_id(me);
+
+    if (job->game->can_solve) {
+        *err = midend_solve(me);
+        if (*err) {
+            sfree(desc);
+            return NULL;
+        }
+    }
+
+    return desc;
+}
+
+static void report(struct stress *st, const char *fmt, ...)
+{
+    va_list ap;
+
+    pthread_mutex_lock(&st->lock);
+    st->nerrors++;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    pthread_mutex_unlock(&st->lock);
+}
+
+static void *worker_thread(void *vctx)
+{
+    struct worker *w = (struct worker *)vctx;
+    struct stress *st = w->st;
+    midend *me;
+    int i;
+
+    for (i = 0; i < st->njobs; i++) {
+        const struct job *job =
+            &st->jobs[(i + w->index * st->njobs / st->nthreads) % st->njobs];
+        const char *err;
+        char *desc;
+
+        if (!job->desc)
+            continue;                  /* failed in the serial run */
+
+        /*
+         * A fresh midend every time: a solve in a game with
+         * SOLVE_ANIMATES leaves an animation pending, which the next
+         * midend_new_game would try to finish by redrawing.
+         */
+        me = midend_new(NULL, job->game, NULL, NULL);
+        desc = run_job(me, job, &err);
+        midend_free(me);
+        if (!desc)
+            report(st, "thread %d: %s: %s\n", w->index, job->id, err);
+        else if (strcmp(desc, job->desc))
+            report(st, "thread %d: %s: generated '%s', expected '%s'\n",
+                   w->index, job->id, desc, job->desc);
+        sfree(desc);
+    }
+
+    grid_cache_clear();
+    return NULL;
+}
+
+static void usage(FILE *fp)
+{
+    fprintf(fp,
+            "usage: threadtest [options] [puzzle...]\n"
+            "options: --threads <n>       number of threads (default 4)\n"
+            "         --presets <n>       presets to try per puzzle "
+            "(default 3)\n"
+            "         --seeds <n>         seeds to try per preset "
+            "(default 2)\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct stress st[1];
+    struct worker *workers;
+    pthread_t *threads;
+    bool *wanted;
+    bool any_wanted = false;
+    int maxpresets = 3, nseeds = 2;
+    int i, j;
+
+    st->jobs = NULL;
+    st->njobs = st->jobsize = 0;
+    st->nthreads = 4;
+    st->nerrors = 0;
+
+    wanted = snewn(gamecount, bool);
+    for (i = 0; i < gamecount; i++)
+        wanted[i] = false;
+
+    for (i = 1; i < argc; i++) {
+        const char *p = argv[i];
+        if ((!strcmp(p, "--threads") || !strcmp(p, "--presets") ||
+             !strcmp(p, "--seeds")) && i+1 < argc) {
+            int n = atoi(argv[++i]);
+            if (n < 1) {
+                fprintf(stderr, "threadtest: '%s' expected a positive "
+                        "number\n", p);
+                return 1;
+            }
+            if (!strcmp(p, "--threads"))
+                st->nthreads = n;
+            else if (!strcmp(p, "--presets"))
+                maxpresets = n;
+            else
+                nseeds = n;
+        } else if (!strcmp(p, "--help")) {
+            usage(stdout);
+            return 0;
+        } else if (p[0] == '-') {
+            usage(stderr);
+            return 1;
+        } else {
+            for (j = 0; j < gamecount; j++)
+                if (!strcmp(p, gamelist[j]->htmlhelp_topic))
+                    break;
+            if (j == gamecount) {
+                fprintf(stderr, "threadtest: unrecognised puzzle '%s'\n", p);
+                return 1;
+            }
+            wanted[j] = any_wanted = true;
+        }
+    }
+
+    /*
+     * Make the list of games to generate.
+     */
+    for (i = 0; i < gamecount; i++) {
+        midend *me;
+        int npresets = 0;
+
+        if (any_wanted && !wanted[i])
+            continue;
+
+        me = midend_new(NULL, gamelist[i], NULL, NULL);
+        add_presets(st, gamelist[i], midend_get_presets(me, NULL),
+                    &npresets, maxpresets, nseeds);
+        midend_free(me);
+    }
+    sfree(wanted);
+
+    /*
+     * Generate them all serially, to find out what they ought to be.
+     */
+    for (i = 0; i < st->njobs; i++) {
+        midend *me = midend_new(NULL, st->jobs[i].game, NULL, NULL);
+        const char *err;
+
+        st->jobs[i].desc = run_job(me, &st->jobs[i], &err);
+        if (!st->jobs[i].desc) {
+            fprintf(stderr, "serial: %s: %s\n", st->jobs[i].id, err);
+            st->nerrors++;
+        }
+        midend_free(me);
+    }
+
+    /*
+     * And then all at once.
+     */
+    pthread_mutex_init(&st->lock, NULL);
+    workers = snewn(st->nthreads, struct worker);
+    threads = snewn(st->nthreads, pthread_t);
+    for (i = 0; i < st->nthreads; i++) {
+        workers[i].st = st;
+        workers[i].index = i;
+        if (pthread_create(&threads[i], NULL, worker_thread, &workers[i])) {
+            fprintf(stderr, "threadtest: unable to create thread\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < st->nthreads; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&st->lock);
+
+    printf("%d games generated by each of %d threads: %d error%s\n",
+           st->njobs, st->nthreads, st->nerrors,
+           st->nerrors == 1 ? "" : "s");
+
+    for (i = 0; i < st->njobs; i++) {
+        sfree(st->jobs[i].id);
+        sfree(st->jobs[i].desc);
+    }
+    sfree(st->jobs);
+    sfree(workers);
+    sfree(threads);
+
+    return st->nerrors ? 1 : 0;
+}
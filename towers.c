@@ -285,7 +285,7 @@ static int solver_easy(struct latin_solver *solver, void *vctx)
 		CSTARTSTEP(cstart, cstep, c, w);
 		pos = start + (ctx->clues[c]-1)*step;
 		cpos = cstart + (ctx->clues[c]-1)*cstep;
-		if (solver->cube[cpos*w+w-1]) {
+		if (cube2(cpos, w)) {
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working) {
 			printf("%*sfacing clues on %s %d are maximal:\n",
@@ -366,7 +366,7 @@ static int solver_easy(struct latin_solver *solver, void *vctx)
 		if (ctx->dscratch[i-1] < w && ctx->dscratch[i-1] >= furthest)
 		    continue;	       /* skip this number, it's elsewhere */
 		j--;
-		if (solver->cube[cstart*w+i-1]) {
+		if (cube2(cstart, i)) {
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working) {
 			printf("%s%*s  ruling out %d at (%d,%d)\n",
@@ -375,7 +375,7 @@ static int solver_easy(struct latin_solver *solver, void *vctx)
 			prefix[0] = '\0';
 		    }
 #endif
-		    solver->cube[cstart*w+i-1] = 0;
+		    cubeclear2(cstart, i);
 		    ret = 1;
 		}
 	    }
@@ -415,7 +415,7 @@ static int solver_easy(struct latin_solver *solver, void *vctx)
 	    }
 
 	    for (j = 0; j < clue - i - 1; j++)
-		if (solver->cube[(cstart + j*cstep)*w+n-1]) {
+		if (cube2(cstart + j*cstep, n)) {
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working) {
 			int pos = start+j*step;
@@ -425,7 +425,7 @@ static int solver_easy(struct latin_solver *solver, void *vctx)
 			prefix[0] = '\0';
 		    }
 #endif
-		    solver->cube[(cstart + j*cstep)*w+n-1] = 0;
+		    cubeclear2(cstart + j*cstep, n);
 		    ret = 1;
 		}
 	    i++;
@@ -481,7 +481,7 @@ static int solver_hard(struct latin_solver *solver, void *vctx)
 		for (j = ctx->dscratch[i] + 1; j <= limit; j++) {
 		    if (bitmap & (1L << j))
 			continue;      /* used this one already */
-		    if (!solver->cube[pos*w+j-1])
+		    if (!cube2(pos, j))
 			continue;      /* ruled out already */
 
 		    /* Found one. */
@@ -542,7 +542,7 @@ static int solver_hard(struct latin_solver *solver, void *vctx)
 	for (i = 0; i < w; i++) {
 	    int pos = start + step * i;
 	    for (j = 1; j <= w; j++) {
-		if (solver->cube[pos*w+j-1] &&
+		if (cube2(pos, j) &&
 		    !(ctx->iscratch[i] & (1L << j))) {
 #ifdef STANDALONE_SOLVER
 		    if (solver_show_working) {
@@ -552,7 +552,7 @@ static int solver_hard(struct latin_solver *solver, void *vctx)
 			prefix[0] = '\0';
 		    }
 #endif
-		    solver->cube[pos*w+j-1] = 0;
+		    cubeclear2(pos, j);
 		    ret = 1;
 		}
 	    }
@@ -680,6 +680,7 @@ done
 	 */
 	sfree(grid);
 	grid = latin_generate(w, rs);
+        genstat_count(GENSTAT_ATTEMPTS);
 
 	/*
 	 * Fill in the clues.
@@ -712,8 +713,10 @@ done
 	     */
 	    memset(soln2, 0, a);
 	    ret = solver(w, clues, soln2, diff);
-	    if (ret > diff)
+	    if (ret > diff) {
+                latin_count_rejection(ret, diff);
 		continue;
+            }
 	}
 
 	for (i = 0; i < a; i++)
@@ -751,8 +754,10 @@ done
 	 */
 	memcpy(soln2, grid, a);
 	ret = solver(w, clues, soln2, diff);
-	if (ret != diff)
+	if (ret != diff) {
+            latin_count_rejection(ret, diff);
 	    continue;		       /* go round again */
+        }
 
 	/*
 	 * We've got a usable puzzle!
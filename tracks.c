@@ -265,6 +265,14 @@ struct game_state {
     struct numbers *numbers;
     int *num_errors;            /* size w+h */
     bool completed, used_solve, impossible;
+
+    /*
+     * While tracks_solve is running, the squares (at level 0) and
+     * rows and columns (at level 1, numbered from w*h, columns first)
+     * that have changed since the deductions that look at them last
+     * did. NULL the rest of the time.
+     */
+    worklist *todo;
 };
 
 /* Return the four directions in which a particular edge flag is set, around a square. */
@@ -336,6 +344,7 @@ static void clear_game(game_state *state)
     memset(state->num_errors, 0, (w+h) * sizeof(int));
 
     state->completed = state->used_solve = state->impossible = false;
+    state->todo = NULL;
 }
 
 static game_state *blank_game(const game_params *params)
@@ -383,6 +392,7 @@ static game_state *dup_game(const game_state *state)
     ret->completed = state->completed;
     ret->used_solve = state->used_solve;
     ret->impossible = state->impossible;
+    ret->todo = NULL;
 
     return ret;
 }
@@ -907,6 +917,19 @@ struct solver_scratch {
     int *dsf;
 };
 
+/* Note that square i's own flags have changed, and hence so has the
+ * count of squares along its row and column. */
+static void solve_changed_square(game_state *state, int i)
+{
+    int w = state->p.w, h = state->p.h;
+
+    if (state->todo) {
+        worklist_add(state->todo, i, 0);
+        worklist_add(state->todo, w*h + i%w, 1);
+        worklist_add(state->todo, w*h + w + i/w, 1);
+    }
+}
+
 static int solve_set_sflag(game_state *state, int x, int y,
                            unsigned int f, const char *why)
 {
@@ -921,6 +944,7 @@ static int solve_set_sflag(game_state *state, int x, int y,
         state->impossible = true;
     }
     state->sflags[i] |= f;
+    solve_changed_square(state, i);
     return 1;
 }
 
@@ -939,58 +963,70 @@ static int solve_set_eflag(game_state *state, int x, int y, int d,
         state->impossible = true;
     }
     S_E_SET(state, x, y, d, f);
+    if (state->todo) {
+        int w = state->p.w, xx = x + DX(d), yy = y + DY(d);
+        worklist_add(state->todo, y*w + x, 0);
+        if (INGRID(state, xx, yy))
+            worklist_add(state->todo, yy*w + xx, 0);
+    }
     return 1;
 }
 
 static int solve_update_flags(game_state *state)
 {
-    int x, y, i, w = state->p.w, h = state->p.h, did = 0;
+    int x, y, i, sq, w = state->p.w, did = 0;
 
-    for (x = 0; x < w; x++) {
-        for (y = 0; y < h; y++) {
-            /* If a square is NOTRACK, all four edges must be. */
-            if (state->sflags[y*w + x] & S_NOTRACK) {
-                for (i = 0; i < 4; i++) {
-                    unsigned int d = 1<<i;
-                    did += solve_set_eflag(state, x, y, d, E_NOTRACK, "edges around NOTRACK");
-                }
+    /*
+     * These deductions only look at one square and its edges, so the
+     * only squares worth looking at are the ones whose flags have
+     * changed, which includes every square they set anything on.
+     */
+    while ((sq = worklist_remove(state->todo, 0, NULL)) >= 0) {
+        x = sq % w;
+        y = sq / w;
+
+        /* If a square is NOTRACK, all four edges must be. */
+        if (state->sflags[y*w + x] & S_NOTRACK) {
+            for (i = 0; i < 4; i++) {
+                unsigned int d = 1<<i;
+                did += solve_set_eflag(state, x, y, d, E_NOTRACK, "edges around NOTRACK");
             }
+        }
 
-            /* If 3 or more edges around a square are NOTRACK, the square is. */
-            if (S_E_COUNT(state, x, y, E_NOTRACK) >= 3) {
-                did += solve_set_sflag(state, x, y, S_NOTRACK, "square has >2 NOTRACK edges");
-            }
+        /* If 3 or more edges around a square are NOTRACK, the square is. */
+        if (S_E_COUNT(state, x, y, E_NOTRACK) >= 3) {
+            did += solve_set_sflag(state, x, y, S_NOTRACK, "square has >2 NOTRACK edges");
+        }
 
-            /* If any edge around a square is TRACK, the square is. */
-            if (S_E_COUNT(state, x, y, E_TRACK) > 0) {
-                did += solve_set_sflag(state, x, y, S_TRACK, "square has TRACK edge");
-            }
+        /* If any edge around a square is TRACK, the square is. */
+        if (S_E_COUNT(state, x, y, E_TRACK) > 0) {
+            did += solve_set_sflag(state, x, y, S_TRACK, "square has TRACK edge");
+        }
 
-            /* If a square is TRACK and 2 edges are NOTRACK,
-               the other two edges must be TRACK. */
-            if ((state->sflags[y*w + x] & S_TRACK) &&
-                    (S_E_COUNT(state, x, y, E_NOTRACK) == 2) &&
-                    (S_E_COUNT(state, x, y, E_TRACK) < 2)) {
-                for (i = 0; i < 4; i++) {
-                    unsigned int d = 1<<i;
-                    if (!(S_E_FLAGS(state, x, y, d) & (E_TRACK|E_NOTRACK))) {
-                        did += solve_set_eflag(state, x, y, d, E_TRACK,
-                                               "TRACK square/2 NOTRACK edges");
-                    }
+        /* If a square is TRACK and 2 edges are NOTRACK,
+           the other two edges must be TRACK. */
+        if ((state->sflags[y*w + x] & S_TRACK) &&
+                (S_E_COUNT(state, x, y, E_NOTRACK) == 2) &&
+                (S_E_COUNT(state, x, y, E_TRACK) < 2)) {
+            for (i = 0; i < 4; i++) {
+                unsigned int d = 1<<i;
+                if (!(S_E_FLAGS(state, x, y, d) & (E_TRACK|E_NOTRACK))) {
+                    did += solve_set_eflag(state, x, y, d, E_TRACK,
+                                           "TRACK square/2 NOTRACK edges");
                 }
             }
+        }
 
-            /* If a square is TRACK and 2 edges are TRACK, the other two
-               must be NOTRACK. */
-            if ((state->sflags[y*w + x] & S_TRACK) &&
-                    (S_E_COUNT(state, x, y, E_TRACK) == 2) &&
-                    (S_E_COUNT(state, x, y, E_NOTRACK) < 2)) {
-                for (i = 0; i < 4; i++) {
-                    unsigned int d = 1<<i;
-                    if (!(S_E_FLAGS(state, x, y, d) & (E_TRACK|E_NOTRACK))) {
-                        did += solve_set_eflag(state, x, y, d, E_NOTRACK,
-                                               "TRACK square/2 TRACK edges");
-                    }
+        /* If a square is TRACK and 2 edges are TRACK, the other two
+           must be NOTRACK. */
+        if ((state->sflags[y*w + x] & S_TRACK) &&
+                (S_E_COUNT(state, x, y, E_TRACK) == 2) &&
+                (S_E_COUNT(state, x, y, E_NOTRACK) < 2)) {
+            for (i = 0; i < 4; i++) {
+                unsigned int d = 1<<i;
+                if (!(S_E_FLAGS(state, x, y, d) & (E_TRACK|E_NOTRACK))) {
+                    did += solve_set_eflag(state, x, y, d, E_NOTRACK,
+                                           "TRACK square/2 TRACK edges");
                 }
             }
         }
@@ -1046,16 +1082,25 @@ static int solve_count_clues_sub(game_state *state, int si, int id, int n,
 
 static int solve_count_clues(game_state *state)
 {
-    int w = state->p.w, h = state->p.h, x, y, target, did = 0;
+    int w = state->p.w, h = state->p.h, target, did = 0;
+    int *lines = snewn(w+h, int), n, i, level;
 
-    for (x = 0; x < w; x++) {
-        target = state->numbers->numbers[x];
-        did += solve_count_clues_sub(state, x, w, h, target, "col count");
-    }
-    for (y = 0; y < h; y++) {
-        target = state->numbers->numbers[w+y];
-        did += solve_count_clues_sub(state, y*w, 1, w, target, "row count");
+    /* Only rows and columns whose squares have changed can need
+     * anything doing, so take all of those queued so far and check
+     * them (anything we change in the process will be queued again). */
+    n = worklist_remove_batch(state->todo, 1, lines, w+h, &level);
+    assert(n == 0 || level == 1);
+    for (i = 0; i < n; i++) {
+        int line = lines[i] - w*h;
+        target = state->numbers->numbers[line];
+        if (line < w)
+            did += solve_count_clues_sub(state, line, w, h, target,
+                                         "col count");
+        else
+            did += solve_count_clues_sub(state, (line-w)*w, 1, w, target,
+                                         "row count");
     }
+    sfree(lines);
     return did;
 }
 
@@ -1255,6 +1300,7 @@ static int solve_check_neighbours_try(game_state *state, int x, int y,
     if (onefill) {
         /* But at most one of them can be filled, so it can't be p. */
         state->sflags[p] |= S_NOTRACK;
+        solve_changed_square(state, p);
         solverdebug(("square (%d,%d) -> NOTRACK: otherwise, that and (%d,%d) "
                      "would make too many TRACK in %s", x, y, X, Y, what));
         did++;
@@ -1263,6 +1309,7 @@ static int solve_check_neighbours_try(game_state *state, int x, int y,
         /* Alternatively, at least one of them _must_ be filled, so P
          * must be. */
         state->sflags[P] |= S_TRACK;
+        solve_changed_square(state, P);
         solverdebug(("square (%d,%d) -> TRACK: otherwise, that and (%d,%d) "
                      "would make too many NOTRACK in %s", X, Y, x, y, what));
         did++;
@@ -1559,6 +1606,12 @@ static int tracks_solve(game_state *state, int diff, int *max_diff_out)
     debug(("solve..."));
     state->impossible = false;
 
+    state->todo = worklist_new(w*h + w+h, 2);
+    for (x = 0; x < w*h; x++)
+        worklist_add(state->todo, x, 0);
+    for (x = 0; x < w+h; x++)
+        worklist_add(state->todo, w*h + x, 1);
+
     /* Set all the outer border edges as no-track. */
     for (x = 0; x < w; x++) {
         solve_discount_edge(state, x, 0, U);
@@ -1596,6 +1649,8 @@ static int tracks_solve(game_state *state, int diff, int *max_diff_out)
     }
 
     sfree(sc->dsf);
+    worklist_free(state->todo);
+    state->todo = NULL;
 
     if (max_diff_out)
         *max_diff_out = max_diff;
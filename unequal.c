@@ -601,20 +601,20 @@ static void free_ctx(void *vctx)
 
 static void solver_nminmax(struct latin_solver *solver,
                            int x, int y, int *min_r, int *max_r,
-                           unsigned char **ns_r)
+                           unsigned long *ns_r)
 {
     int o = solver->o, min = o, max = 0, n;
-    unsigned char *ns;
+    unsigned long ns;
 
     assert(x >= 0 && y >= 0 && x < o && y < o);
 
-    ns = solver->cube + cubepos(x,y,1);
+    ns = solver->cand[cubesq(x,y)];
 
     if (grid(x,y) > 0) {
         min = max = grid(x,y)-1;
     } else {
         for (n = 0; n < o; n++) {
-            if (ns[n]) {
+            if (ns & LATIN_BIT(n+1)) {
                 if (n > max) max = n;
                 if (n < min) min = n;
             }
@@ -629,7 +629,7 @@ static int solver_links(struct latin_solver *solver, void *vctx)
 {
     struct solver_ctx *ctx = (struct solver_ctx *)vctx;
     int i, j, lmin, gmax, nchanged = 0;
-    unsigned char *gns, *lns;
+    unsigned long gns, lns;
     struct solver_link *link;
 
     for (i = 0; i < ctx->nlinks; i++) {
@@ -640,7 +640,7 @@ static int solver_links(struct latin_solver *solver, void *vctx)
         for (j = 0; j < solver->o; j++) {
             /* For the 'greater' end of the link, discount all numbers
              * too small to satisfy the inequality. */
-            if (gns[j]) {
+            if (gns & LATIN_BIT(j+1)) {
                 if (j < (lmin+link->len)) {
 #ifdef STANDALONE_SOLVER
                     if (solver_show_working) {
@@ -652,13 +652,13 @@ static int solver_links(struct latin_solver *solver, void *vctx)
                                j+1, link->gx+1, link->gy+1);
                     }
 #endif
-                    cube(link->gx, link->gy, j+1) = false;
+                    cubeclear(link->gx, link->gy, j+1);
                     nchanged++;
                 }
             }
             /* For the 'lesser' end of the link, discount all numbers
              * too large to satisfy inequality. */
-            if (lns[j]) {
+            if (lns & LATIN_BIT(j+1)) {
                 if (j > (gmax-link->len)) {
 #ifdef STANDALONE_SOLVER
                     if (solver_show_working) {
@@ -670,7 +670,7 @@ static int solver_links(struct latin_solver *solver, void *vctx)
                                j+1, link->lx+1, link->ly+1);
                     }
 #endif
-                    cube(link->lx, link->ly, j+1) = false;
+                    cubeclear(link->lx, link->ly, j+1);
                     nchanged++;
                 }
             }
@@ -720,7 +720,7 @@ static int solver_adjacent(struct latin_solver *solver, void *vctx)
                                solver_recurse_depth*4, "", n+1, nx+1, ny+1);
                     }
 #endif
-                    cube(nx, ny, n+1) = false;
+                    cubeclear(nx, ny, n+1);
                     nchanged++;
                 }
             }
@@ -785,7 +785,7 @@ static int solver_adjacent_set(struct latin_solver *solver, void *vctx)
                                solver_recurse_depth*4, "", n+1, nx+1, ny+1);
                     }
 #endif
-                    cube(nx, ny, n+1) = false;
+                    cubeclear(nx, ny, n+1);
                     nchanged++;
                 }
             }
@@ -888,9 +888,9 @@ static int solver_state(game_state *state, int maxdiff)
 {
     struct solver_ctx *ctx = new_ctx(state);
     struct latin_solver solver;
-    int diff;
+    int diff, o = state->order, i, n;
 
-    latin_solver_alloc(&solver, state->nums, state->order);
+    latin_solver_alloc(&solver, state->nums, o);
 
     diff = latin_solver_main(&solver, maxdiff,
 			     DIFF_LATIN, DIFF_SET, DIFF_EXTREME,
@@ -898,7 +898,9 @@ static int solver_state(game_state *state, int maxdiff)
 			     unequal_solvers, unequal_valid, ctx,
                              clone_ctx, free_ctx);
 
-    memcpy(state->hints, solver.cube, state->order*state->order*state->order);
+    for (i = 0; i < o*o; i++)
+        for (n = 0; n < o; n++)
+            state->hints[i*o+n] = (solver.cand[i] >> n) & 1;
 
     free_ctx(ctx);
 
@@ -1078,10 +1080,13 @@ int maxtries;
 #else
 #define MAXTRIES 50
 #endif
-static int gg_solved;
 
+/*
+ * *nsolved counts solver runs, for diagnostics. (It's passed around
+ * rather than being a static so that generation is reentrant.)
+ */
 static int game_assemble(game_state *new, int *scratch, digit *latin,
-                         int difficulty)
+                         int difficulty, int *nsolved)
 {
     game_state *copy = dup_game(new);
     int best;
@@ -1103,7 +1108,7 @@ static int game_assemble(game_state *new, int *scratch, digit *latin,
 #endif
 
     while(1) {
-        gg_solved++;
+        (*nsolved)++;
         if (solver_state(copy, difficulty) == 1) break;
 
         best = gg_best_clue(copy, scratch, latin);
@@ -1114,7 +1119,7 @@ static int game_assemble(game_state *new, int *scratch, digit *latin,
 #ifdef STANDALONE_SOLVER
     if (solver_show_working) {
         char *dbg = game_text_format(new);
-        printf("game_assemble: done, %d solver iterations:\n%s\n", gg_solved, dbg);
+        printf("game_assemble: done, %d solver iterations:\n%s\n", *nsolved, dbg);
         sfree(dbg);
     }
 #endif
@@ -1122,7 +1127,7 @@ static int game_assemble(game_state *new, int *scratch, digit *latin,
 }
 
 static void game_strip(game_state *new, int *scratch, digit *latin,
-                       int difficulty)
+                       int difficulty, int *nsolved)
 {
     int o = new->order, o2 = o*o, lscratch = o2*5, i;
     game_state *copy = blank_game(new->order, new->mode);
@@ -1134,7 +1139,7 @@ static void game_strip(game_state *new, int *scratch, digit *latin,
 
         memcpy(copy->nums,  new->nums,  o2 * sizeof(digit));
         memcpy(copy->flags, new->flags, o2 * sizeof(unsigned int));
-        gg_solved++;
+        (*nsolved)++;
         if (solver_state(copy, difficulty) != 1) {
             /* put clue back, we can't solve without it. */
             bool ret = gg_place_clue(new, scratch[i], latin, false);
@@ -1150,7 +1155,7 @@ static void game_strip(game_state *new, int *scratch, digit *latin,
 #ifdef STANDALONE_SOLVER
     if (solver_show_working) {
         char *dbg = game_text_format(new);
-        debug(("game_strip: done, %d solver iterations.", gg_solved));
+        debug(("game_strip: done, %d solver iterations.", *nsolved));
         debug(("%s", dbg));
         sfree(dbg);
     }
@@ -1185,7 +1190,7 @@ static char *new_game_desc(const game_params *params_in, random_state *rs,
     game_params params_copy = *params_in; /* structure copy */
     game_params *params = &params_copy;
     digit *sq = NULL;
-    int i, x, y, retlen, k, nsol;
+    int i, x, y, retlen, k, nsol, nsolved;
     int o2 = params->order * params->order, ntries = 1;
     int *scratch, lscratch = o2*5;
     char *ret, buf[80];
@@ -1205,6 +1210,7 @@ generate:
     if (sq) sfree(sq);
     sq = latin_generate(params->order, rs);
     latin_debug(sq, params->order);
+    genstat_count(GENSTAT_ATTEMPTS);
     /* Separately shuffle the numeric and inequality clues */
     shuffle(scratch, lscratch/5, sizeof(int), rs);
     shuffle(scratch+lscratch/5, 4*lscratch/5, sizeof(int), rs);
@@ -1217,10 +1223,12 @@ generate:
         add_adjacent_flags(state, sq);
     }
 
-    gg_solved = 0;
-    if (game_assemble(state, scratch, sq, params->diff) < 0)
+    nsolved = 0;
+    if (game_assemble(state, scratch, sq, params->diff, &nsolved) < 0) {
+        genstat_count(GENSTAT_REJECT_OTHER);
         goto generate;
-    game_strip(state, scratch, sq, params->diff);
+    }
+    game_strip(state, scratch, sq, params->diff, &nsolved);
 
     if (params->diff > 0) {
         game_state *copy = dup_game(state);
@@ -1233,6 +1241,7 @@ generate:
 #endif
             if (ntries < MAXTRIES) {
                 ntries++;
+                genstat_count(GENSTAT_REJECT_TOO_EASY);
                 goto generate;
             }
 #ifdef STANDALONE_SOLVER
@@ -1247,7 +1256,7 @@ generate:
 #ifdef STANDALONE_SOLVER
     if (solver_show_working)
         printf("new_game_desc: generated %s puzzle; %d attempts (%d solver).\n",
-               unequal_diffnames[params->diff], ntries, gg_solved);
+               unequal_diffnames[params->diff], ntries, nsolved);
 #endif
 
     ret = NULL; retlen = 0;
@@ -333,7 +333,7 @@ static int solver_normal(struct latin_solver *solver, void *vctx)
 			       names[n-1], x+1, y+1);
 		    }
 #endif
-		    if (solver->cube[(x*w+y)*w+n-1]) {
+		    if (cube(x, y, n)) {
 			latin_solver_place(solver, x, y, n);
 			return 1;
 		    } else {
@@ -361,7 +361,7 @@ static int solver_normal(struct latin_solver *solver, void *vctx)
 			       names[n-1], x+1, y+1);
 		    }
 #endif
-		    if (solver->cube[(x*w+y)*w+n-1]) {
+		    if (cube(x, y, n)) {
 			latin_solver_place(solver, x, y, n);
 			return 1;
 		    } else {
@@ -514,7 +514,7 @@ static int solver_hard(struct latin_solver *solver, void *vctx)
                                solver_recurse_depth*4, "", names[j], i, j);
                     }
 #endif
-                    cube(i, j, j+1) = false;
+                    cubeclear(i, j, j+1);
                 }
                 if (cube(j, i, j+1)) {
 #ifdef STANDALONE_SOLVER
@@ -528,7 +528,7 @@ static int solver_hard(struct latin_solver *solver, void *vctx)
                                solver_recurse_depth*4, "", names[j], j, i);
                     }
 #endif
-                    cube(j, i, j+1) = false;
+                    cubeclear(j, i, j+1);
                 }
             }
         }